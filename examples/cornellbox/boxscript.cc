@@ -1,5 +1,5 @@
 #include <examples/cornellbox/boxscript.h>
-#include <math.h>
+#include <rally/math/transcendental.h>
 
 enum class BoxMaterials : rally::u32 {
   kWhite = 0,
@@ -69,9 +69,11 @@ bool UpdateBoxScript(rally::Application* app) {
   // Update Light
   constexpr float light_speed = 0.05f;
   constexpr float light_radius = 0.4f;
-  rally::Vec4 light_pos = {
-      light_radius * sinf(current_time * light_speed), 0.0f,
-      light_radius * cosf(current_time * light_speed), 1.0f};
+  rally::Vec4 sin_t, cos_t;
+  rally::VSinCos4(rally::Vec4{_mm_set1_ps(current_time * light_speed)}, sin_t,
+                  cos_t);
+  rally::Vec4 light_pos = {light_radius * _mm_cvtss_f32(sin_t.data), 0.0f,
+                           light_radius * _mm_cvtss_f32(cos_t.data), 1.0f};
   light_pos = rally::VMul(rally::MRotation(0.0f, 0.0f, rally::Radians(30.0f)),
                           light_pos);
   light_pos = rally::VMul(rally::MTranslation(0.0f, 0.0f, -1.0f), light_pos);
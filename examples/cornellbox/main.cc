@@ -12,9 +12,9 @@ int main() {
   ScriptCreateInfo script_ci{CreateBoxScript, UpdateBoxScript};
   ApplicationCreateInfo app_ci{&thread_ci, &window_ci, &renderer_ci, &scene_ii,
                                &script_ci};
+  // Reserved up front, pages are committed as the application uses them
   constexpr s64 kAppMemorySize = Gigabytes(1);
-  void* app_memory = malloc(kAppMemorySize);
-  Application* app = CreateApplication(&app_ci, app_memory, kAppMemorySize);
+  Application* app = CreateApplication(&app_ci, nullptr, kAppMemorySize);
   if (app == nullptr) {
     DestroyApplication(app);
     return 0;
@@ -1,5 +1,6 @@
 #include <examples/hellorally/helloscript.h>
 #include <math.h>
+#include <rally/math/transcendental.h>
 
 static bool BuildScene(rally::Application* app) {
   // Setup camera
@@ -37,6 +38,7 @@ bool UpdateHelloScript(rally::Application* app) {
   time_total += 0.01f;
 
   // Update light intensity
-  app->scene->lights[0].intensity = fabs(sin(time_total)*10.0f);
+  rally::Vec4 sin_t = rally::VSin4(rally::Vec4{_mm_set1_ps(time_total)});
+  app->scene->lights[0].intensity = fabsf(_mm_cvtss_f32(sin_t.data) * 10.0f);
   return false;
 }
\ No newline at end of file
@@ -10,11 +10,11 @@ int main() {
   RendererCreateInfo renderer_ci{RenderMode::kRasterization, 640, 480, 3, 2};
   SceneImportInfo scene_ii{true};
   ScriptCreateInfo script_ci{CreateHelloScript, UpdateHelloScript};
-  ApplicationCreateInfo app_ci{&thread_ci, &window_ci, &renderer_ci, &scene_ii,
-                               &script_ci};
+  ApplicationCreateInfo app_ci{&thread_ci, &window_ci, &renderer_ci,
+                               &scene_ii,   &script_ci, Megabytes(256)};
+  // Reserved up front, pages are committed as the application uses them
   constexpr s64 kAppMemorySize = Gigabytes(1);
-  void* app_memory = malloc(kAppMemorySize);
-  Application* app = CreateApplication(&app_ci, app_memory, kAppMemorySize);
+  Application* app = CreateApplication(&app_ci, nullptr, kAppMemorySize);
   if (app == nullptr) {
     DestroyApplication(app);
     return 0;
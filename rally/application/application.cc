@@ -1,50 +1,91 @@
 #include <rally/application/application.h>
+#include <rally/dev/dev.h>
 #include <rally/scene/importer.h>
 
 namespace rally {
 Application* CreateApplication(ApplicationCreateInfo* app_ci, void* data,
                                s64 data_size) {
-  // Create allocator and store application data
-  StackAllocator* stack_alloc = CreateStackAllocator(data, data_size);
-  Application* app = (Application*)StackAllocate(
-      stack_alloc, sizeof(Application), alignof(Application));
+  // Create allocator and store application data, without a block data_size
+  // bytes of address space are reserved and committed as they are used
+  StackAllocator* stack_alloc =
+      data != nullptr
+          ? CreateStackAllocator(data, data_size)
+          : CreateVirtualStackAllocator(data_size, app_ci->huge_pages);
+  if (stack_alloc == nullptr) return nullptr;
+  SetMemoryTag(stack_alloc, MemoryTag::kApplication);
+  Application* app = SALLOCZ(stack_alloc, Application, 1);
   app->alloc = stack_alloc;
   bool failed = false;
 
+  // Carve the heap before anything else takes the stack
+  if (app_ci->heap_size > 0) {
+    SetMemoryTag(stack_alloc, MemoryTag::kHeap);
+    app->heap = CreateHeapAllocator(stack_alloc, app_ci->heap_size);
+    if (app->heap == nullptr) return nullptr;
+  }
+
   // Create Thread Pool
+  SetMemoryTag(stack_alloc, MemoryTag::kThreadPool);
   if (app_ci->thread_ci != nullptr)
     failed |= CreateThreadPool(app_ci->thread_ci, app);
   if (failed) return nullptr;
 
+#ifdef _WIN32
   // Import scene at assets.bin
+  SetMemoryTag(stack_alloc, MemoryTag::kScene);
   if (app_ci->scene_ii != nullptr) failed |= ImportScene(app);
   if (failed) return nullptr;
 
   // Create Win32 Window
+  SetMemoryTag(stack_alloc, MemoryTag::kApplication);
   if (app_ci->window_ci != nullptr)
     failed |= CreateWin32Window(app_ci->window_ci, app);
   if (failed) return nullptr;
 
   // Create Renderer
+  SetMemoryTag(stack_alloc, MemoryTag::kRenderer);
   if (app_ci->render_ci != nullptr)
     failed |= CreateRenderer(app_ci->render_ci, app);
   if (failed) return nullptr;
+#else
+  // Headless platforms only support the thread pool and scripts
+  ASSERT(app_ci->scene_ii == nullptr && app_ci->window_ci == nullptr &&
+             app_ci->render_ci == nullptr,
+         "Scene import, windows and rendering require Win32!");
+#endif
 
   // Create script object and run script create function
+  SetMemoryTag(stack_alloc, MemoryTag::kScript);
   failed |= CreateScript(app_ci->script_ci, app);
   if (failed) return nullptr;
+  // Later allocations are attributed to the application
+  SetMemoryTag(stack_alloc, MemoryTag::kApplication);
   return app;
 }
 bool UpdateApplication(Application* app) {
+  if (app->threadpool != nullptr) BeginThreadPoolFrame(app->threadpool);
+#ifdef _WIN32
   UpdateWin32Window(app->window);
+#endif
   if (app->script->update_func != nullptr) app->script->update_func(app);
+#ifdef _WIN32
   UpdateRenderer(app);
+#endif
   return true;
 }
+#ifdef _WIN32
 bool IsApplicationActive(Application* app) { return app->window->active; }
+#else
+bool IsApplicationActive(Application* app) { return app != nullptr; }
+#endif
 void DestroyApplication(Application* app) {
+  if (app == nullptr) return;
   DestroyThreadPool(app->threadpool);
+#ifdef _WIN32
   DestroyRenderer(app);
   DestroyWin32Window(app->window);
+#endif
+  // The application lives in its allocator, release it last
+  DestroyStackAllocator(app->alloc);
 }
 }  // namespace rally
\ No newline at end of file
@@ -1,13 +1,17 @@
 #pragma once
+#include <rally/memory/heapallocator.h>
 #include <rally/memory/stackallocator.h>
-#include <rally/render/renderer.h>
 #include <rally/thread/threadpool.h>
-#include <rally/win32/win32.h>
 #include <rally/scene/scene.h>
 #include <rally/script/script.h>
+#ifdef _WIN32
+#include <rally/render/renderer.h>
+#include <rally/win32/win32.h>
+#endif
 
 namespace rally {
 struct StackAllocator;
+struct HeapAllocator;
 struct ThreadPool;
 struct Window;
 struct Renderer;
@@ -20,6 +24,8 @@ struct SceneImportInfo;
 struct ScriptCreateInfo;
 struct Application {
   StackAllocator* alloc;
+  // Variable-sized, long-lived allocations, nullptr unless heap_size is set
+  HeapAllocator* heap;
   ThreadPool* threadpool;
   Window* window;
   Renderer* renderer;
@@ -32,7 +38,12 @@ struct ApplicationCreateInfo {
   RendererCreateInfo* render_ci;
   SceneImportInfo* scene_ii;
   ScriptCreateInfo* script_ci;
+  // Bytes of the application block managed by the heap
+  s64 heap_size;
+  // Back a reserved application block with huge pages
+  b32 huge_pages;
 };
+// data may be nullptr to reserve data_size bytes of virtual memory instead
 Application* CreateApplication(ApplicationCreateInfo* app_ci, void* data,
                                s64 data_size);
 bool UpdateApplication(Application* app);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <rally/dev/dev.h>
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+namespace rally {
+// Array with a capacity fixed at creation, storage comes from an allocator
+template <typename T>
+struct FixedVector {
+  T* data;
+  u32 count;
+  u32 capacity;
+};
+// Returns true if the allocator is out of memory
+template <typename T>
+bool CreateFixedVector(StackAllocator* alloc, u32 capacity,
+                       FixedVector<T>* vec) {
+  vec->data = (T*)StackAllocateArray(alloc, capacity, sizeof(T),
+                                     alignof(T) > kCacheLineSize
+                                         ? alignof(T)
+                                         : kCacheLineSize);
+  vec->count = 0;
+  vec->capacity = vec->data != nullptr ? capacity : 0;
+  return vec->data == nullptr;
+}
+template <typename T>
+T* GetFixedVector(FixedVector<T>* vec, u32 index) {
+  ASSERT(index < vec->count, "Fixed vector index out of bounds!");
+  return &vec->data[index];
+}
+// Returns nullptr when full
+template <typename T>
+T* PushFixedVector(FixedVector<T>* vec, const T& value) {
+  if (vec->count == vec->capacity) return nullptr;
+  T* item = &vec->data[vec->count++];
+  *item = value;
+  return item;
+}
+// Returns true when empty
+template <typename T>
+bool PopFixedVector(FixedVector<T>* vec, T* out_value) {
+  if (vec->count == 0) return true;
+  *out_value = vec->data[--vec->count];
+  return false;
+}
+// Move the last element into index, order is not preserved
+template <typename T>
+void SwapRemoveFixedVector(FixedVector<T>* vec, u32 index) {
+  ASSERT(index < vec->count, "Fixed vector index out of bounds!");
+  vec->data[index] = vec->data[--vec->count];
+}
+template <typename T>
+void ClearFixedVector(FixedVector<T>* vec) {
+  vec->count = 0;
+}
+}  // namespace rally
\ No newline at end of file
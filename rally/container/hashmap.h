@@ -0,0 +1,126 @@
+#pragma once
+
+#include <rally/dev/dev.h>
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+namespace rally {
+// Integer finalizer from MurmurHash3, overload HashKey for other key types
+inline u64 HashKey(u64 key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ull;
+  key ^= key >> 33;
+  return key;
+}
+inline u64 HashKey(u32 key) { return HashKey((u64)key); }
+inline u64 HashKey(i32 key) { return HashKey((u64)(u32)key); }
+inline u64 HashKey(i64 key) { return HashKey((u64)key); }
+template <typename T>
+u64 HashKey(T* key) {
+  return HashKey((u64)(uintptr_t)key);
+}
+template <typename K, typename V>
+struct HashSlot {
+  // Distance from the key's home slot plus one, 0 when empty
+  u32 distance;
+  K key;
+  V value;
+};
+// Open addressing map with Robin Hood probing: keys far from their home slot
+// take over slots from keys closer to theirs, which keeps probe lengths short
+// and lets lookups stop early. Capacity is fixed at creation.
+template <typename K, typename V>
+struct HashMap {
+  HashSlot<K, V>* slots;
+  u32 mask;
+  u32 count;
+  u32 max_count;
+};
+// Returns true if the allocator is out of memory
+template <typename K, typename V>
+bool CreateHashMap(StackAllocator* alloc, u32 capacity, HashMap<K, V>* map) {
+  // Keep the load factor at or below 7/8
+  u32 slot_count = 1;
+  while (slot_count < capacity + capacity / 7 + 1) slot_count <<= 1;
+  map->slots = (HashSlot<K, V>*)StackAllocateArrayZeroed(
+      alloc, slot_count, sizeof(HashSlot<K, V>), kCacheLineSize);
+  map->mask = slot_count - 1;
+  map->count = 0;
+  map->max_count = capacity;
+  // Zeroed slots start empty
+  return map->slots == nullptr;
+}
+// Returns nullptr if key is missing
+template <typename K, typename V>
+V* FindHashMap(HashMap<K, V>* map, const K& key) {
+  u32 slot_i = (u32)HashKey(key) & map->mask;
+  for (u32 distance = 1;; distance++) {
+    HashSlot<K, V>* slot = &map->slots[slot_i];
+    // Key would have displaced this slot, it is not in the map
+    if (slot->distance < distance) return nullptr;
+    if (slot->distance == distance && slot->key == key) return &slot->value;
+    slot_i = (slot_i + 1) & map->mask;
+  }
+}
+// Insert or overwrite, returns nullptr when full
+template <typename K, typename V>
+V* InsertHashMap(HashMap<K, V>* map, const K& key, const V& value) {
+  if (map->count == map->max_count) {
+    V* existing = FindHashMap(map, key);
+    if (existing != nullptr) *existing = value;
+    return existing;
+  }
+  HashSlot<K, V> entry = {1, key, value};
+  V* inserted = nullptr;
+  u32 slot_i = (u32)HashKey(key) & map->mask;
+  while (true) {
+    HashSlot<K, V>* slot = &map->slots[slot_i];
+    if (slot->distance == 0) {
+      *slot = entry;
+      map->count++;
+      return inserted != nullptr ? inserted : &slot->value;
+    }
+    // Only the original key can already be present
+    if (inserted == nullptr && slot->distance == entry.distance &&
+        slot->key == key) {
+      slot->value = value;
+      return &slot->value;
+    }
+    if (slot->distance < entry.distance) {
+      HashSlot<K, V> displaced = *slot;
+      *slot = entry;
+      entry = displaced;
+      if (inserted == nullptr) inserted = &slot->value;
+    }
+    entry.distance++;
+    slot_i = (slot_i + 1) & map->mask;
+  }
+}
+// Returns true if key is missing
+template <typename K, typename V>
+bool RemoveHashMap(HashMap<K, V>* map, const K& key) {
+  V* value = FindHashMap(map, key);
+  if (value == nullptr) return true;
+  u32 slot_i = (u32)(((char*)value - (char*)map->slots) /
+                     sizeof(HashSlot<K, V>));
+  // Shift the following run back so no tombstones are needed
+  u32 next_i = (slot_i + 1) & map->mask;
+  while (map->slots[next_i].distance > 1) {
+    map->slots[slot_i] = map->slots[next_i];
+    map->slots[slot_i].distance--;
+    slot_i = next_i;
+    next_i = (next_i + 1) & map->mask;
+  }
+  map->slots[slot_i].distance = 0;
+  map->count--;
+  return false;
+}
+template <typename K, typename V>
+void ClearHashMap(HashMap<K, V>* map) {
+  for (u32 slot_i = 0; slot_i <= map->mask; slot_i++)
+    map->slots[slot_i].distance = 0;
+  map->count = 0;
+}
+}  // namespace rally
\ No newline at end of file
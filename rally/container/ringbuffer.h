@@ -0,0 +1,135 @@
+#pragma once
+
+#include <rally/dev/dev.h>
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+#include <atomic>
+
+namespace rally {
+// Single-producer single-consumer ring, capacity is a power of 2. Head and
+// tail live on their own cache lines so producer and consumer don't share.
+template <typename T>
+struct SpscRing {
+  alignas(kCacheLineSize) std::atomic<u32> head;
+  // Consumer position cached by the producer, and the reverse, so the common
+  // case touches no shared line
+  u32 cached_tail;
+  alignas(kCacheLineSize) std::atomic<u32> tail;
+  u32 cached_head;
+  alignas(kCacheLineSize) T* items;
+  u32 mask;
+};
+template <typename T>
+bool CreateSpscRing(StackAllocator* alloc, u32 capacity, SpscRing<T>* ring) {
+  ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0,
+         "Ring capacity must be a power of 2!");
+  ring->items = (T*)StackAllocateArray(alloc, capacity, sizeof(T),
+                                       kCacheLineSize);
+  ring->mask = capacity - 1;
+  ring->head.store(0);
+  ring->tail.store(0);
+  ring->cached_head = 0;
+  ring->cached_tail = 0;
+  return ring->items == nullptr;
+}
+// Producer only, returns true when full
+template <typename T>
+bool PushSpscRing(SpscRing<T>* ring, const T& value) {
+  u32 head = ring->head.load(std::memory_order_relaxed);
+  if (head - ring->cached_tail > ring->mask) {
+    ring->cached_tail = ring->tail.load(std::memory_order_acquire);
+    if (head - ring->cached_tail > ring->mask) return true;
+  }
+  ring->items[head & ring->mask] = value;
+  ring->head.store(head + 1, std::memory_order_release);
+  return false;
+}
+// Consumer only, returns true when empty
+template <typename T>
+bool PopSpscRing(SpscRing<T>* ring, T* out_value) {
+  u32 tail = ring->tail.load(std::memory_order_relaxed);
+  if (tail == ring->cached_head) {
+    ring->cached_head = ring->head.load(std::memory_order_acquire);
+    if (tail == ring->cached_head) return true;
+  }
+  *out_value = ring->items[tail & ring->mask];
+  ring->tail.store(tail + 1, std::memory_order_release);
+  return false;
+}
+
+// Slot of an MPMC ring, sequence tells producers and consumers whose turn it
+// is to use the slot
+template <typename T>
+struct MpmcSlot {
+  std::atomic<u32> sequence;
+  T value;
+};
+// Bounded multi-producer multi-consumer ring, capacity is a power of 2
+template <typename T>
+struct MpmcRing {
+  alignas(kCacheLineSize) std::atomic<u32> front;
+  alignas(kCacheLineSize) std::atomic<u32> end;
+  alignas(kCacheLineSize) MpmcSlot<T>* slots;
+  u32 mask;
+};
+template <typename T>
+bool CreateMpmcRing(StackAllocator* alloc, u32 capacity, MpmcRing<T>* ring) {
+  ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0,
+         "Ring capacity must be a power of 2!");
+  ring->slots = (MpmcSlot<T>*)StackAllocateArray(
+      alloc, capacity, sizeof(MpmcSlot<T>), kCacheLineSize);
+  if (ring->slots == nullptr) return true;
+  ring->mask = capacity - 1;
+  ring->front.store(0);
+  ring->end.store(0);
+  for (u32 slot_i = 0; slot_i < capacity; slot_i++)
+    ring->slots[slot_i].sequence.store(slot_i);
+  return false;
+}
+// Returns true when full
+template <typename T>
+bool PushMpmcRing(MpmcRing<T>* ring, const T& value) {
+  u32 end = ring->end.load(std::memory_order_relaxed);
+  while (true) {
+    MpmcSlot<T>* slot = &ring->slots[end & ring->mask];
+    u32 sequence = slot->sequence.load(std::memory_order_acquire);
+    i32 diff = (i32)(sequence - end);
+    if (diff == 0) {
+      if (ring->end.compare_exchange_weak(end, end + 1,
+                                          std::memory_order_relaxed)) {
+        slot->value = value;
+        slot->sequence.store(end + 1, std::memory_order_release);
+        return false;
+      }
+    } else if (diff < 0) {
+      return true;
+    } else {
+      end = ring->end.load(std::memory_order_relaxed);
+    }
+  }
+}
+// Returns true when empty
+template <typename T>
+bool PopMpmcRing(MpmcRing<T>* ring, T* out_value) {
+  u32 front = ring->front.load(std::memory_order_relaxed);
+  while (true) {
+    MpmcSlot<T>* slot = &ring->slots[front & ring->mask];
+    u32 sequence = slot->sequence.load(std::memory_order_acquire);
+    i32 diff = (i32)(sequence - (front + 1));
+    if (diff == 0) {
+      if (ring->front.compare_exchange_weak(front, front + 1,
+                                            std::memory_order_relaxed)) {
+        *out_value = slot->value;
+        slot->sequence.store(front + ring->mask + 1,
+                             std::memory_order_release);
+        return false;
+      }
+    } else if (diff < 0) {
+      return true;
+    } else {
+      front = ring->front.load(std::memory_order_relaxed);
+    }
+  }
+}
+}  // namespace rally
\ No newline at end of file
@@ -1,19 +1,25 @@
 #pragma once
 #include <assert.h>
+#ifdef _WIN32
 #include <windows.h>
+#define DEBUG_OUTPUT(message) OutputDebugStringA((message))
+#else
+#include <stdio.h>
+#define DEBUG_OUTPUT(message) fputs((message), stderr)
+#endif
 
 #ifndef NDEBUG
-#define ASSERT(condition, message)   \
-  do {                               \
-    if (!(condition)) {              \
-      OutputDebugStringA("Error: "); \
-      OutputDebugStringA((message)); \
-      OutputDebugStringA("\n");      \
-      assert(false && (message));    \
-    }                                \
+#define ASSERT(condition, message) \
+  do {                             \
+    if (!(condition)) {            \
+      DEBUG_OUTPUT("Error: ");     \
+      DEBUG_OUTPUT((message));     \
+      DEBUG_OUTPUT("\n");          \
+      assert(false && (message));  \
+    }                              \
   } while (false)
 #else
 #define ASSERT(condition, message) \
   do {                             \
   } while (false)
-#endif
\ No newline at end of file
+#endif
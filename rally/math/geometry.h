@@ -2,14 +2,37 @@
 #include <rally/math/vec.h>
 
 namespace rally {
-struct Vertex {
-  Vec3 position;
-  Vec3 normal;
-  Vec3 tangent;
-  Vec3 bitangent;
-  Vec2 uv;
-};
-typedef u32 Index;
+// Tightly packed 3-component vector, Vec3 pads to 16 bytes for SSE
+struct Float3 {
+  r32 x, y, z;
+};
+// Unit normal mapped onto the octahedron, snorm16 per component
+struct OctNormal {
+  i16 x, y;
+};
+// Tangent space rotation as an snorm16 quaternion, the sign of w carries the
+// bitangent handedness
+struct TangentFrame {
+  i16 x, y, z, w;
+};
+// Texture coordinate as two IEEE half floats
+struct HalfUv {
+  u16 u, v;
+};
+// Vertex attributes stored as one stream per attribute, indexed by vertex.
+// Passes over positions only touch the 12-byte position stream, attributes
+// are compressed, see rally/math/packing.h
+struct VertexStreams {
+  Float3* positions;
+  OctNormal* normals;
+  TangentFrame* tangent_frames;
+  HalfUv* uvs;
+};
+// Axis-aligned bounding box
+struct Bounds {
+  Float3 min;
+  Float3 max;
+};
 struct PointLight {
   Vec4 position;
   r32 color_r, color_g, color_b;
@@ -31,6 +54,6 @@ struct Instance {
   i32 vertex_offset;
   i32 index_offset;
   i32 material_id;
-  i32 _pad;
+  i32 index_size;
 };
 }  // namespace rally
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <math.h>
+#include <rally/math/packing.h>
+#include <string.h>
+
+namespace rally {
+static r32 Dot(const Float3& a, const Float3& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+static Float3 Cross(const Float3& a, const Float3& b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+static Float3 Normalize(const Float3& a) {
+  r32 inv_length = 1.0f / sqrtf(Dot(a, a));
+  return {a.x * inv_length, a.y * inv_length, a.z * inv_length};
+}
+static r32 SignNotZero(r32 x) { return x >= 0.0f ? 1.0f : -1.0f; }
+static i16 ToSnorm16(r32 x) {
+  x = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+  return (i16)lrintf(x * 32767.0f);
+}
+static r32 FromSnorm16(i16 x) {
+  r32 f = (r32)x / 32767.0f;
+  return f < -1.0f ? -1.0f : f;
+}
+
+// Bit manipulation follows F. Giesen's float_to_half_fast3_rtne and
+// half_to_float
+u16 FloatToHalf(r32 x) {
+  u32 bits;
+  memcpy(&bits, &x, sizeof(bits));
+  u32 sign = bits & 0x80000000u;
+  bits ^= sign;
+  u16 half;
+  if (bits >= 0x47800000u) {
+    // Overflow to infinity, NaN stays NaN
+    half = bits > 0x7f800000u ? 0x7e00 : 0x7c00;
+  } else if (bits < 0x38800000u) {
+    // Subnormal half, the float adder rounds the mantissa for us
+    const u32 denorm_magic = 126u << 23;
+    r32 f;
+    memcpy(&f, &bits, sizeof(f));
+    r32 magic;
+    memcpy(&magic, &denorm_magic, sizeof(magic));
+    f += magic;
+    memcpy(&bits, &f, sizeof(bits));
+    half = (u16)(bits - denorm_magic);
+  } else {
+    u32 mantissa_odd = (bits >> 13) & 1;
+    bits += (u32)(15 - 127) * (1u << 23) + 0xfff;
+    bits += mantissa_odd;
+    half = (u16)(bits >> 13);
+  }
+  return half | (u16)(sign >> 16);
+}
+r32 HalfToFloat(u16 h) {
+  const u32 shifted_exponent = 0x7c00u << 13;
+  u32 bits = (h & 0x7fffu) << 13;
+  u32 exponent = bits & shifted_exponent;
+  bits += (127u - 15u) << 23;
+  r32 f;
+  if (exponent == shifted_exponent) {
+    bits += (128u - 16u) << 23;
+    memcpy(&f, &bits, sizeof(f));
+  } else if (exponent == 0) {
+    // Zero or subnormal, renormalize through the float unit
+    const u32 magic_bits = 113u << 23;
+    r32 magic;
+    memcpy(&magic, &magic_bits, sizeof(magic));
+    bits += 1u << 23;
+    memcpy(&f, &bits, sizeof(f));
+    f -= magic;
+  } else {
+    memcpy(&f, &bits, sizeof(f));
+  }
+  memcpy(&bits, &f, sizeof(bits));
+  bits |= (u32)(h & 0x8000u) << 16;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+OctNormal EncodeOctNormal(const Float3& normal) {
+  r32 inv_l1 =
+      1.0f / (fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z));
+  r32 x = normal.x * inv_l1;
+  r32 y = normal.y * inv_l1;
+  // Fold the lower hemisphere over the diagonals
+  if (normal.z < 0.0f) {
+    r32 folded_x = (1.0f - fabsf(y)) * SignNotZero(x);
+    r32 folded_y = (1.0f - fabsf(x)) * SignNotZero(y);
+    x = folded_x;
+    y = folded_y;
+  }
+  return {ToSnorm16(x), ToSnorm16(y)};
+}
+Float3 DecodeOctNormal(const OctNormal& oct) {
+  Float3 n{FromSnorm16(oct.x), FromSnorm16(oct.y), 0.0f};
+  n.z = 1.0f - fabsf(n.x) - fabsf(n.y);
+  r32 t = n.z < 0.0f ? -n.z : 0.0f;
+  n.x += n.x >= 0.0f ? -t : t;
+  n.y += n.y >= 0.0f ? -t : t;
+  return Normalize(n);
+}
+
+TangentFrame EncodeTangentFrame(const Float3& normal, const Float3& tangent,
+                                const Float3& bitangent) {
+  // Orthonormal basis [t b n] with b = n x t, so the frame is a rotation
+  r32 n_dot_t = Dot(normal, tangent);
+  Float3 t{tangent.x - normal.x * n_dot_t, tangent.y - normal.y * n_dot_t,
+           tangent.z - normal.z * n_dot_t};
+  if (Dot(t, t) < 1e-12f) {
+    // Degenerate tangent, any vector perpendicular to the normal will do
+    t = fabsf(normal.x) < 0.9f ? Cross(normal, {1.0f, 0.0f, 0.0f})
+                               : Cross(normal, {0.0f, 1.0f, 0.0f});
+  }
+  t = Normalize(t);
+  Float3 b = Cross(normal, t);
+  r32 handedness = Dot(b, bitangent) < 0.0f ? -1.0f : 1.0f;
+  const Float3& n = normal;
+
+  // Rotation matrix to quaternion, columns are t, b, n
+  r32 q[4];  // x, y, z, w
+  r32 trace = t.x + b.y + n.z;
+  if (trace > 0.0f) {
+    r32 s = 0.5f / sqrtf(trace + 1.0f);
+    q[3] = 0.25f / s;
+    q[0] = (b.z - n.y) * s;
+    q[1] = (n.x - t.z) * s;
+    q[2] = (t.y - b.x) * s;
+  } else if (t.x > b.y && t.x > n.z) {
+    r32 s = 2.0f * sqrtf(1.0f + t.x - b.y - n.z);
+    q[3] = (b.z - n.y) / s;
+    q[0] = 0.25f * s;
+    q[1] = (b.x + t.y) / s;
+    q[2] = (n.x + t.z) / s;
+  } else if (b.y > n.z) {
+    r32 s = 2.0f * sqrtf(1.0f + b.y - t.x - n.z);
+    q[3] = (n.x - t.z) / s;
+    q[0] = (b.x + t.y) / s;
+    q[1] = 0.25f * s;
+    q[2] = (n.y + b.z) / s;
+  } else {
+    r32 s = 2.0f * sqrtf(1.0f + n.z - t.x - b.y);
+    q[3] = (t.y - b.x) / s;
+    q[0] = (n.x + t.z) / s;
+    q[1] = (n.y + b.z) / s;
+    q[2] = 0.25f * s;
+  }
+  r32 inv_length =
+      1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  // q and -q are the same rotation, keep w positive and nonzero after
+  // quantization so it can carry the handedness
+  if (q[3] < 0.0f) inv_length = -inv_length;
+  for (u32 i = 0; i < 4; i++) q[i] *= inv_length;
+  const r32 kMinW = 1.0f / 32767.0f;
+  if (q[3] < kMinW) {
+    r32 scale = sqrtf(1.0f - kMinW * kMinW);
+    for (u32 i = 0; i < 3; i++) q[i] *= scale;
+    q[3] = kMinW;
+  }
+  for (u32 i = 0; i < 4; i++) q[i] *= handedness;
+  return {ToSnorm16(q[0]), ToSnorm16(q[1]), ToSnorm16(q[2]),
+          ToSnorm16(q[3])};
+}
+void DecodeTangentFrame(const TangentFrame& frame, Float3& out_normal,
+                        Float3& out_tangent, Float3& out_bitangent) {
+  r32 x = FromSnorm16(frame.x), y = FromSnorm16(frame.y);
+  r32 z = FromSnorm16(frame.z), w = FromSnorm16(frame.w);
+  r32 handedness = w < 0.0f ? -1.0f : 1.0f;
+  r32 inv_length = 1.0f / sqrtf(x * x + y * y + z * z + w * w);
+  x *= inv_length;
+  y *= inv_length;
+  z *= inv_length;
+  w *= inv_length;
+  // Columns of the rotation matrix
+  out_tangent = {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z),
+                 2.0f * (x * z - w * y)};
+  out_bitangent = {handedness * 2.0f * (x * y - w * z),
+                   handedness * (1.0f - 2.0f * (x * x + z * z)),
+                   handedness * 2.0f * (y * z + w * x)};
+  out_normal = {2.0f * (x * z + w * y), 2.0f * (y * z - w * x),
+                1.0f - 2.0f * (x * x + y * y)};
+}
+
+HalfUv EncodeHalfUv(r32 u, r32 v) { return {FloatToHalf(u), FloatToHalf(v)}; }
+Vec2 DecodeHalfUv(const HalfUv& uv) {
+  return {HalfToFloat(uv.u), HalfToFloat(uv.v)};
+}
+}  // namespace rally
\ No newline at end of file
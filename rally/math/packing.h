@@ -0,0 +1,25 @@
+#pragma once
+#include <rally/math/geometry.h>
+
+namespace rally {
+// Reference encoders/decoders for compressed vertex attributes, shader.hlsl
+// decodes the same formats
+
+// IEEE half float conversion, rounds to nearest even
+u16 FloatToHalf(r32 x);
+r32 HalfToFloat(u16 h);
+
+// normal must be unit length, decoded normals are renormalized
+OctNormal EncodeOctNormal(const Float3& normal);
+Float3 DecodeOctNormal(const OctNormal& oct);
+
+// tangent is orthogonalized against normal, only the handedness of bitangent
+// is kept
+TangentFrame EncodeTangentFrame(const Float3& normal, const Float3& tangent,
+                                const Float3& bitangent);
+void DecodeTangentFrame(const TangentFrame& frame, Float3& out_normal,
+                        Float3& out_tangent, Float3& out_bitangent);
+
+HalfUv EncodeHalfUv(r32 u, r32 v);
+Vec2 DecodeHalfUv(const HalfUv& uv);
+}  // namespace rally
\ No newline at end of file
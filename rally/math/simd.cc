@@ -0,0 +1,48 @@
+#include <rally/math/simd.h>
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace rally {
+#ifdef _MSC_VER
+SimdLevel GetCpuSimdLevel() {
+  int info[4];
+  __cpuid(info, 0);
+  int max_leaf = info[0];
+  __cpuid(info, 1);
+  bool fma = info[2] & (1 << 12);
+  bool osxsave = info[2] & (1 << 27);
+  if (!fma || !osxsave || max_leaf < 7) return SimdLevel::kSse;
+  // The OS must save the wider registers on context switches
+  u64 xcr0 = _xgetbv(0);
+  if ((xcr0 & 0x6) != 0x6) return SimdLevel::kSse;
+  __cpuidex(info, 7, 0);
+  bool avx2 = info[1] & (1 << 5);
+  bool avx512f = info[1] & (1 << 16);
+  if (!avx2) return SimdLevel::kSse;
+  if (avx512f && (xcr0 & 0xE6) == 0xE6) return SimdLevel::kAvx512;
+  return SimdLevel::kAvx2;
+}
+#else
+SimdLevel GetCpuSimdLevel() {
+  // Checks OS support for the wider registers as well
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SimdLevel::kAvx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return SimdLevel::kAvx2;
+  return SimdLevel::kSse;
+}
+#endif
+static SimdLevel& GetSimdLevelState() {
+  static SimdLevel simd_level = GetCpuSimdLevel();
+  return simd_level;
+}
+SimdLevel GetSimdLevel() { return GetSimdLevelState(); }
+SimdLevel SetSimdLevel(SimdLevel level) {
+  SimdLevel cpu_level = GetCpuSimdLevel();
+  if ((u32)level > (u32)cpu_level) level = cpu_level;
+  GetSimdLevelState() = level;
+  return level;
+}
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include <rally/types.h>
+
+namespace rally {
+// Instruction sets batched math kernels are compiled for
+enum class SimdLevel : u32 {
+  kSse = 0,
+  kAvx2 = 1,  // With FMA
+  kAvx512 = 2,
+};
+// Widest level supported by both the processor and the OS
+SimdLevel GetCpuSimdLevel();
+// Level batched kernels dispatch to, GetCpuSimdLevel unless overridden
+SimdLevel GetSimdLevel();
+// Force a narrower level, e.g. to compare paths. Levels the processor lacks
+// are clamped, returns the level now in use. Not thread safe.
+SimdLevel SetSimdLevel(SimdLevel level);
+}  // namespace rally
\ No newline at end of file
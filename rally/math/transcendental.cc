@@ -0,0 +1,195 @@
+#include <emmintrin.h>
+#include <math.h>
+#include <rally/math/transcendental.h>
+#include <string.h>
+
+namespace rally {
+// Cephes single precision polynomials on SSE2. Each approximation reduces
+// the argument to a small interval with an extended precision constant split
+// in parts that multiply exactly, then evaluates a minimax polynomial. The
+// kernels are inline so batch loops keep the constants in registers.
+
+static __m128 Select(__m128 mask, __m128 a, __m128 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static __m128 PolyEval(__m128 x, const r32* coefficients, u32 count) {
+  __m128 y = _mm_set1_ps(coefficients[0]);
+  for (u32 coefficient_i = 1; coefficient_i < count; coefficient_i++)
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(coefficients[coefficient_i]));
+  return y;
+}
+
+static inline void SinCos(__m128 x, __m128& out_sin, __m128& out_cos) {
+  // pi / 4 in three parts
+  constexpr r32 kPi4A = 0.78515625f;
+  constexpr r32 kPi4B = 2.4187564849853515625e-4f;
+  constexpr r32 kPi4C = 3.77489497744594108e-8f;
+  constexpr r32 kSinCoefficients[] = {-1.9515295891e-4f, 8.3321608736e-3f,
+                                      -1.6666654611e-1f};
+  constexpr r32 kCosCoefficients[] = {2.443315711809948e-5f,
+                                      -1.388731625493765e-3f,
+                                      4.166664568298827e-2f};
+  const __m128 sign_bit = _mm_set1_ps(-0.0f);
+  const __m128 sin_sign = _mm_and_ps(x, sign_bit);
+  x = _mm_andnot_ps(sign_bit, x);
+  // Octant, rounded up to even so x lands in [-pi/4, pi/4]
+  __m128i octant =
+      _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+  octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+  octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+  const __m128 y = _mm_cvtepi32_ps(octant);
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(kPi4A)));
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(kPi4B)));
+  x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(kPi4C)));
+
+  const __m128 z = _mm_mul_ps(x, x);
+  __m128 sin_x = _mm_mul_ps(PolyEval(z, kSinCoefficients, 3), z);
+  sin_x = _mm_add_ps(_mm_mul_ps(sin_x, x), x);
+  __m128 cos_x = _mm_mul_ps(PolyEval(z, kCosCoefficients, 3), _mm_mul_ps(z, z));
+  cos_x = _mm_sub_ps(cos_x, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  cos_x = _mm_add_ps(cos_x, _mm_set1_ps(1.0f));
+
+  // Octants 2 and 6 swap the polynomials, 4 to 6 negate sin, 2 to 4 cos
+  const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+      _mm_and_si128(octant, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+  const __m128 sin_flip = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+  const __m128 cos_flip = _mm_castsi128_ps(_mm_slli_epi32(
+      _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(2)),
+                    _mm_set1_epi32(4)),
+      29));
+  out_sin = _mm_xor_ps(Select(swap, cos_x, sin_x),
+                       _mm_xor_ps(sin_sign, sin_flip));
+  out_cos = _mm_xor_ps(Select(swap, sin_x, cos_x), cos_flip);
+}
+
+static inline __m128 Exp(__m128 x) {
+  // ln 2 in two parts
+  constexpr r32 kLn2A = 0.693359375f;
+  constexpr r32 kLn2B = -2.12194440e-4f;
+  constexpr r32 kCoefficients[] = {1.9875691500e-4f, 1.3981999507e-3f,
+                                   8.3334519073e-3f, 4.1665795894e-2f,
+                                   1.6666665459e-1f, 5.0000001201e-1f};
+  // Beyond these 2^n leaves the normal range
+  x = _mm_min_ps(x, _mm_set1_ps(88.3762626647949f));
+  x = _mm_max_ps(x, _mm_set1_ps(-87.3365447504f));
+  // Rounds to nearest under the default MXCSR
+  const __m128i n =
+      _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)));
+  const __m128 fn = _mm_cvtepi32_ps(n);
+  x = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(kLn2A)));
+  x = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(kLn2B)));
+  __m128 y = _mm_mul_ps(PolyEval(x, kCoefficients, 6), _mm_mul_ps(x, x));
+  y = _mm_add_ps(_mm_add_ps(y, x), _mm_set1_ps(1.0f));
+  // Scale by 2^n in two steps so n = 128 does not overflow the exponent
+  const __m128i n_half = _mm_srai_epi32(n, 1);
+  const __m128 scale_a = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_add_epi32(n_half, _mm_set1_epi32(127)), 23));
+  const __m128 scale_b = _mm_castsi128_ps(_mm_slli_epi32(
+      _mm_add_epi32(_mm_sub_epi32(n, n_half), _mm_set1_epi32(127)), 23));
+  return _mm_mul_ps(_mm_mul_ps(y, scale_a), scale_b);
+}
+
+static inline __m128 Log(__m128 x) {
+  constexpr r32 kLn2A = 0.693359375f;
+  constexpr r32 kLn2B = -2.12194440e-4f;
+  constexpr r32 kCoefficients[] = {
+      7.0376836292e-2f,  -1.1514610310e-1f, 1.1676998740e-1f,
+      -1.2420140846e-1f, 1.4249322787e-1f,  -1.6668057665e-1f,
+      2.0000714765e-1f,  -2.4999993993e-1f, 3.3333331174e-1f};
+  // Negative and NaN inputs are invalid, zero and infinity are exact
+  const __m128 invalid = _mm_cmpngt_ps(x, _mm_setzero_ps());
+  const __m128 zero = _mm_cmpeq_ps(x, _mm_setzero_ps());
+  const __m128 infinite = _mm_cmpeq_ps(x, _mm_set1_ps(INFINITY));
+  // x = m * 2^e with m in [0.5, 1)
+  const __m128i bits = _mm_castps_si128(x);
+  __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23),
+                                           _mm_set1_epi32(126)));
+  __m128 m = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                   _mm_set1_epi32(0x3f000000)));
+  // Center on 1 by doubling m below sqrt(0.5)
+  const __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+  e = _mm_sub_ps(e, _mm_and_ps(small, _mm_set1_ps(1.0f)));
+  m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(small, m)), _mm_set1_ps(1.0f));
+
+  const __m128 z = _mm_mul_ps(m, m);
+  __m128 y = _mm_mul_ps(_mm_mul_ps(PolyEval(m, kCoefficients, 9), m), z);
+  y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(kLn2B)));
+  y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  __m128 log_x = _mm_add_ps(m, y);
+  log_x = _mm_add_ps(log_x, _mm_mul_ps(e, _mm_set1_ps(kLn2A)));
+  log_x = Select(infinite, x, log_x);
+  // All bits set is a quiet NaN
+  log_x = _mm_or_ps(log_x, invalid);
+  return Select(zero, _mm_set1_ps(-INFINITY), log_x);
+}
+
+Vec4 VSin4(const Vec4& x) {
+  Vec4 out_sin, out_cos;
+  VSinCos4(x, out_sin, out_cos);
+  return out_sin;
+}
+Vec4 VCos4(const Vec4& x) {
+  Vec4 out_sin, out_cos;
+  VSinCos4(x, out_sin, out_cos);
+  return out_cos;
+}
+void VSinCos4(const Vec4& x, Vec4& out_sin, Vec4& out_cos) {
+  SinCos(x.data, out_sin.data, out_cos.data);
+}
+Vec4 VTan4(const Vec4& x) {
+  __m128 sin_x, cos_x;
+  SinCos(x.data, sin_x, cos_x);
+  return Vec4{_mm_div_ps(sin_x, cos_x)};
+}
+Vec4 VExp4(const Vec4& x) { return Vec4{Exp(x.data)}; }
+Vec4 VLog4(const Vec4& x) { return Vec4{Log(x.data)}; }
+
+// Whole registers are streamed, the tail goes through a padded copy
+template <typename Kernel>
+static void Batch(const r32* x, u32 count, Kernel kernel) {
+  u32 i = 0;
+  for (; i + 4 <= count; i += 4) kernel(_mm_loadu_ps(x + i), i, 4);
+  if (i == count) return;
+  r32 tail[4] = {};
+  memcpy(tail, x + i, (count - i) * sizeof(r32));
+  kernel(_mm_loadu_ps(tail), i, count - i);
+}
+// Stores lanes of a to out, a partial store goes through a copy
+static void Store(__m128 a, r32* out, u32 lane_count) {
+  if (lane_count == 4) {
+    _mm_storeu_ps(out, a);
+    return;
+  }
+  r32 lanes[4];
+  _mm_storeu_ps(lanes, a);
+  memcpy(out, lanes, lane_count * sizeof(r32));
+}
+
+void VSinCosBatch(const r32* x, u32 count, r32* out_sin, r32* out_cos) {
+  Batch(x, count, [=](__m128 xs, u32 i, u32 lane_count) {
+    __m128 sin_x, cos_x;
+    SinCos(xs, sin_x, cos_x);
+    Store(sin_x, out_sin + i, lane_count);
+    Store(cos_x, out_cos + i, lane_count);
+  });
+}
+void VTanBatch(const r32* x, u32 count, r32* out) {
+  Batch(x, count, [=](__m128 xs, u32 i, u32 lane_count) {
+    __m128 sin_x, cos_x;
+    SinCos(xs, sin_x, cos_x);
+    Store(_mm_div_ps(sin_x, cos_x), out + i, lane_count);
+  });
+}
+void VExpBatch(const r32* x, u32 count, r32* out) {
+  Batch(x, count, [=](__m128 xs, u32 i, u32 lane_count) {
+    Store(Exp(xs), out + i, lane_count);
+  });
+}
+void VLogBatch(const r32* x, u32 count, r32* out) {
+  Batch(x, count, [=](__m128 xs, u32 i, u32 lane_count) {
+    Store(Log(xs), out + i, lane_count);
+  });
+}
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#include <rally/math/vec.h>
+
+namespace rally {
+// Polynomial approximations of libm functions on each lane. Errors are in
+// ulp of the correctly rounded result, measured against double precision libm
+// over the stated ranges, outside them accuracy degrades.
+
+// Within 2 ulp for |x| <= 8192 where the result is at least 1e-3, closer to
+// the zeros the absolute error stays below 1e-7. Beyond 8192 range reduction
+// loses precision.
+Vec4 VSin4(const Vec4& x);
+Vec4 VCos4(const Vec4& x);
+void VSinCos4(const Vec4& x, Vec4& out_sin, Vec4& out_cos);
+// sin / cos, within 4 ulp for |x| <= 8192 where the result is at least 1e-3
+// and cos at least 1e-2
+Vec4 VTan4(const Vec4& x);
+// Within 1 ulp. Inputs are clamped to [-87.3, 88.3] so results never
+// reach denormals or infinity, and NaN is not propagated.
+Vec4 VExp4(const Vec4& x);
+// Within 1 ulp for normal positive x. Zero gives -infinity, negative
+// and NaN inputs give NaN, denormals are not supported.
+Vec4 VLog4(const Vec4& x);
+
+// Same approximations over arrays of any length, outputs may alias x
+void VSinCosBatch(const r32* x, u32 count, r32* out_sin, r32* out_cos);
+void VTanBatch(const r32* x, u32 count, r32* out);
+void VExpBatch(const r32* x, u32 count, r32* out);
+void VLogBatch(const r32* x, u32 count, r32* out);
+}  // namespace rally
\ No newline at end of file
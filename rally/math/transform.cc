@@ -0,0 +1,209 @@
+#include <emmintrin.h>
+#include <math.h>
+#include <rally/math/transcendental.h>
+#include <rally/math/transform.h>
+#include <rally/math/vec_simd.h>
+
+namespace rally {
+// Translation and scale are contiguous, one aligned load reads both
+static __m128 LoadTranslationScale(const Transform& a) {
+  return _mm_load_ps(&a.translation.x);
+}
+static void StoreTranslationScale(__m128 ts, Transform& out_a) {
+  _mm_store_ps(&out_a.translation.x, ts);
+}
+static __m128 MaskW(__m128 a) {
+  return _mm_and_ps(a, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+}
+static __m128 QMul(__m128 a, __m128 b) {
+  const __m128 sign_xw = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+  const __m128 sign_zw = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+  const __m128 sign_xyw = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+  __m128 ab = _mm_mul_ps(Swizzle<ShuffleMask(3, 3, 3, 3)>(a), b);
+  ab = _mm_add_ps(
+      ab, _mm_mul_ps(Swizzle<ShuffleMask(0, 0, 0, 0)>(a),
+                     _mm_xor_ps(Swizzle<ShuffleMask(3, 2, 1, 0)>(b), sign_xw)));
+  ab = _mm_add_ps(
+      ab, _mm_mul_ps(Swizzle<ShuffleMask(1, 1, 1, 1)>(a),
+                     _mm_xor_ps(Swizzle<ShuffleMask(2, 3, 0, 1)>(b), sign_zw)));
+  ab = _mm_add_ps(
+      ab,
+      _mm_mul_ps(Swizzle<ShuffleMask(2, 2, 2, 2)>(a),
+                 _mm_xor_ps(Swizzle<ShuffleMask(1, 0, 3, 2)>(b), sign_xyw)));
+  return ab;
+}
+// v + 2w(u x v) + 2u x (u x v), w of v is kept
+static __m128 QRotate(__m128 q, __m128 v) {
+  const __m128 u = MaskW(q);
+  const __m128 t = _mm_add_ps(Cross(u, v), Cross(u, v));
+  const __m128 w = Swizzle<ShuffleMask(3, 3, 3, 3)>(q);
+  return _mm_add_ps(_mm_add_ps(v, _mm_mul_ps(w, t)), Cross(u, t));
+}
+static __m128 Normalize4(__m128 a) {
+  return _mm_div_ps(a, _mm_sqrt_ps(HorizontalSum(_mm_mul_ps(a, a))));
+}
+// Rotation, scale and translation of b applied after a's
+static void TCompose(const Transform& a, const Transform& b, __m128& out_q,
+                     __m128& out_ts) {
+  const __m128 ts_a = LoadTranslationScale(a);
+  const __m128 ts_b = LoadTranslationScale(b);
+  out_q = QMul(a.rotation.data, b.rotation.data);
+  // w lane of the rotated vector is the composed scale
+  __m128 ts = _mm_mul_ps(ts_b, Swizzle<ShuffleMask(3, 3, 3, 3)>(ts_a));
+  out_ts = _mm_add_ps(QRotate(a.rotation.data, ts), MaskW(ts_a));
+}
+
+Quat QAxisAngle(const Vec3& axis, r32 angle) {
+  Vec4 s, c;
+  VSinCos4(Vec4{_mm_set1_ps(angle * 0.5f)}, s, c);
+  // sin(angle / 2) * axis in xyz, cos(angle / 2) in w
+  const __m128 w_mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+  return Quat{_mm_or_ps(MaskW(_mm_mul_ps(axis.data, s.data)),
+                        _mm_and_ps(c.data, w_mask))};
+}
+Quat QEuler(const r32 rotx, const r32 roty, const r32 rotz) {
+  // qz * qy * qx expanded, matching the Rz * Ry * Rx order of MRotation
+  Vec4 sin_xyz, cos_xyz;
+  VSinCos4(Vec4{rotx * 0.5f, roty * 0.5f, rotz * 0.5f, 0.0f}, sin_xyz,
+           cos_xyz);
+  alignas(16) r32 sin_f[4], cos_f[4];
+  VStore(sin_xyz, sin_f);
+  VStore(cos_xyz, cos_f);
+  const r32 cx = cos_f[0], sx = sin_f[0];
+  const r32 cy = cos_f[1], sy = sin_f[1];
+  const r32 cz = cos_f[2], sz = sin_f[2];
+  return Quat{_mm_setr_ps(cz * cy * sx - sz * sy * cx,
+                          cz * sy * cx + sz * cy * sx,
+                          sz * cy * cx - cz * sy * sx,
+                          cz * cy * cx + sz * sy * sx)};
+}
+Quat QMul(const Quat& a, const Quat& b) {
+  Quat out_ab;
+  QMul(a, b, out_ab);
+  return out_ab;
+}
+void QMul(const Quat& a, const Quat& b, Quat& out_ab) {
+  out_ab.data = QMul(a.data, b.data);
+}
+Quat QConjugate(const Quat& q) {
+  return Quat{_mm_xor_ps(q.data, _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f))};
+}
+Quat QNormalize(const Quat& q) { return Quat{Normalize4(q.data)}; }
+r32 QDot(const Quat& a, const Quat& b) {
+  return _mm_cvtss_f32(HorizontalSum(_mm_mul_ps(a.data, b.data)));
+}
+Vec3 QRotate(const Quat& q, const Vec3& v) {
+  Vec3 out_v;
+  QRotate(q, v, out_v);
+  return out_v;
+}
+void QRotate(const Quat& q, const Vec3& v, Vec3& out_v) {
+  out_v.data = QRotate(q.data, v.data);
+}
+Quat QNlerp(const Quat& a, const Quat& b, r32 t) {
+  // q and -q are the same rotation, flip b onto a's hemisphere
+  const r32 tb = QDot(a, b) < 0.0f ? -t : t;
+  return Quat{Normalize4(_mm_add_ps(_mm_mul_ps(a.data, _mm_set1_ps(1.0f - t)),
+                                    _mm_mul_ps(b.data, _mm_set1_ps(tb))))};
+}
+Quat QSlerp(const Quat& a, const Quat& b, r32 t) {
+  r32 cos_theta = QDot(a, b);
+  r32 sign = 1.0f;
+  if (cos_theta < 0.0f) {
+    cos_theta = -cos_theta;
+    sign = -1.0f;
+  }
+  // sin(theta) vanishes for close rotations, where nlerp is indistinguishable
+  if (cos_theta > 0.9995f) return QNlerp(a, b, t);
+  const r32 theta = acosf(cos_theta);
+  // sin(theta), sin((1 - t) theta) and sin(t theta) in one approximation
+  Vec4 sin_angles, cos_angles;
+  VSinCos4(Vec4{theta, (1.0f - t) * theta, t * theta, 0.0f}, sin_angles,
+           cos_angles);
+  alignas(16) r32 sin_f[4];
+  VStore(sin_angles, sin_f);
+  const r32 inv_sin = 1.0f / sin_f[0];
+  const r32 wa = sin_f[1] * inv_sin;
+  const r32 wb = sin_f[2] * inv_sin * sign;
+  return Quat{_mm_add_ps(_mm_mul_ps(a.data, _mm_set1_ps(wa)),
+                         _mm_mul_ps(b.data, _mm_set1_ps(wb)))};
+}
+
+Mat4 MRotation(const Quat& q) {
+  Mat4 out_R;
+  MRotation(q, out_R);
+  return out_R;
+}
+void MRotation(const Quat& q, Mat4& out_R) {
+  MFromTransform(Transform{q, {0.0f, 0.0f, 0.0f}, 1.0f}, out_R);
+}
+
+Transform TCompose(const Transform& a, const Transform& b) {
+  Transform out_ab;
+  TCompose(a, b, out_ab);
+  return out_ab;
+}
+void TCompose(const Transform& a, const Transform& b, Transform& out_ab) {
+  __m128 q, ts;
+  TCompose(a, b, q, ts);
+  out_ab.rotation.data = q;
+  StoreTranslationScale(ts, out_ab);
+}
+void TComposeBatch(const Transform* parent, const Transform* child, u32 count,
+                   Transform* out) {
+  for (u32 i = 0; i < count; i++) {
+    __m128 q, ts;
+    TCompose(parent[i], child[i], q, ts);
+    out[i].rotation.data = q;
+    StoreTranslationScale(ts, out[i]);
+  }
+}
+Transform TInverse(const Transform& a) {
+  Transform out_ai;
+  TInverse(a, out_ai);
+  return out_ai;
+}
+void TInverse(const Transform& a, Transform& out_ai) {
+  const Quat q = QConjugate(a.rotation);
+  const r32 inv_scale = 1.0f / a.scale;
+  // -(q t) / s, then the inverse scale in w
+  const __m128 t = _mm_mul_ps(MaskW(LoadTranslationScale(a)),
+                              _mm_set1_ps(-inv_scale));
+  __m128 ts = QRotate(q.data, t);
+  ts = _mm_add_ps(ts, _mm_setr_ps(0.0f, 0.0f, 0.0f, inv_scale));
+  out_ai.rotation = q;
+  StoreTranslationScale(ts, out_ai);
+}
+Vec3 TTransformPoint(const Transform& a, const Vec3& p) {
+  const __m128 ts = LoadTranslationScale(a);
+  const __m128 s = Swizzle<ShuffleMask(3, 3, 3, 3)>(ts);
+  return Vec3{_mm_add_ps(QRotate(a.rotation.data, _mm_mul_ps(p.data, s)),
+                         MaskW(ts))};
+}
+
+Mat4 MFromTransform(const Transform& a) {
+  Mat4 out_M;
+  MFromTransform(a, out_M);
+  return out_M;
+}
+void MFromTransform(const Transform& a, Mat4& out_M) {
+  alignas(16) r32 q[4];
+  _mm_store_ps(q, a.rotation.data);
+  const r32 x = q[0], y = q[1], z = q[2], w = q[3];
+  const r32 s2 = 2.0f * a.scale;
+  out_M.cols[0].data =
+      _mm_setr_ps(a.scale - s2 * (y * y + z * z), s2 * (x * y + w * z),
+                  s2 * (x * z - w * y), 0.0f);
+  out_M.cols[1].data =
+      _mm_setr_ps(s2 * (x * y - w * z), a.scale - s2 * (x * x + z * z),
+                  s2 * (y * z + w * x), 0.0f);
+  out_M.cols[2].data =
+      _mm_setr_ps(s2 * (x * z + w * y), s2 * (y * z - w * x),
+                  a.scale - s2 * (x * x + y * y), 0.0f);
+  out_M.cols[3].data = _mm_setr_ps(a.translation.x, a.translation.y,
+                                   a.translation.z, 1.0f);
+}
+void MFromTransformBatch(const Transform* a, u32 count, Mat4* out) {
+  for (u32 i = 0; i < count; i++) MFromTransform(a[i], out[i]);
+}
+}  // namespace rally
\ No newline at end of file
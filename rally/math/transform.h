@@ -0,0 +1,59 @@
+#pragma once
+#include <rally/math/geometry.h>
+
+namespace rally {
+// Unit quaternion stored as x, y, z, w
+struct Quat {
+  __m128 data;
+};
+// Rotation, then uniform scale, then translation. Uniform scale keeps the
+// composition of two transforms a transform, and fits in half a Mat4.
+struct Transform {
+  Quat rotation;
+  Float3 translation;
+  r32 scale;
+};
+static_assert(sizeof(Transform) == 32, "Transform should be half a Mat4");
+
+constexpr Quat kQuatIdentity = {{0, 0, 0, 1}};
+constexpr Transform kTransformIdentity = {{{0, 0, 0, 1}}, {0, 0, 0}, 1};
+
+// Rotation of angle radians around unit axis
+Quat QAxisAngle(const Vec3& axis, r32 angle);
+// Same rotation as MRotation(rotx, roty, rotz)
+Quat QEuler(const r32 rotx, const r32 roty, const r32 rotz);
+// Hamilton product, rotates by b then by a
+Quat QMul(const Quat& a, const Quat& b);
+void QMul(const Quat& a, const Quat& b, Quat& out_ab);
+// Inverse of a unit quaternion
+Quat QConjugate(const Quat& q);
+Quat QNormalize(const Quat& q);
+r32 QDot(const Quat& a, const Quat& b);
+// Rotate v by unit quaternion q
+Vec3 QRotate(const Quat& q, const Vec3& v);
+void QRotate(const Quat& q, const Vec3& v, Vec3& out_v);
+// Interpolate along the shorter arc. Nlerp is cheaper but only follows the
+// arc at constant speed near t = 0, 0.5 and 1.
+Quat QNlerp(const Quat& a, const Quat& b, r32 t);
+Quat QSlerp(const Quat& a, const Quat& b, r32 t);
+
+// Rotation matrix of unit quaternion q
+Mat4 MRotation(const Quat& q);
+void MRotation(const Quat& q, Mat4& out_R);
+
+// Apply b then a, matches MMul(MFromTransform(a), MFromTransform(b))
+Transform TCompose(const Transform& a, const Transform& b);
+void TCompose(const Transform& a, const Transform& b, Transform& out_ab);
+// Compose each parent with its child, out may alias either input
+void TComposeBatch(const Transform* parent, const Transform* child, u32 count,
+                   Transform* out);
+// scale must not be zero
+Transform TInverse(const Transform& a);
+void TInverse(const Transform& a, Transform& out_ai);
+Vec3 TTransformPoint(const Transform& a, const Vec3& p);
+
+// Expand to the equivalent affine matrix
+Mat4 MFromTransform(const Transform& a);
+void MFromTransform(const Transform& a, Mat4& out_M);
+void MFromTransformBatch(const Transform* a, u32 count, Mat4* out);
+}  // namespace rally
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include <math.h>
+#include <rally/math/simd.h>
+#include <rally/math/transcendental.h>
 #include <rally/math/vec.h>
+#include <rally/math/vec_simd.h>
 
 namespace rally {
 Vec4 VAdd(const Vec4& a, const Vec4& b) {
@@ -11,20 +14,22 @@ void VAdd(const Vec4& a, const Vec4& b, Vec4& out_c) {
   out_c.data = _mm_add_ps(a.data, b.data);
 }
 
-bool VNear(const Vec4& a, const Vec4& b) {
-  __m128 diff = _mm_sub_ps(a.data, b.data);
-  r32 fdiff[4];
-  _mm_store_ps(fdiff, diff);
+bool VNear(const Vec4& a, const Vec4& b, r32 tolerance) {
+  alignas(16) r32 fa[4], fb[4];
+  _mm_store_ps(fa, a.data);
+  _mm_store_ps(fb, b.data);
   for (u32 i = 0; i < 4; i++) {
-    if (fdiff[i] > eps || fdiff[i] < -eps) return false;
+    // Absolute below 1, relative to the element's own magnitude above
+    r32 scale = fmaxf(1.0f, fmaxf(fabsf(fa[i]), fabsf(fb[i])));
+    if (fabsf(fa[i] - fb[i]) > tolerance * scale) return false;
   }
   return true;
 }
 
-bool MNear(const Mat4& a, const Mat4& b) {
+bool MNear(const Mat4& a, const Mat4& b, r32 tolerance) {
   bool is_near = true;
   for (u32 col_i = 0; col_i < 4; col_i++) {
-    is_near &= VNear(a.cols[col_i], b.cols[col_i]);
+    is_near &= VNear(a.cols[col_i], b.cols[col_i], tolerance);
   }
   return is_near;
 }
@@ -40,10 +45,6 @@ r32 VDot(const Vec4& a, const Vec4& b) {
   return ans;
 }
 
-inline static constexpr unsigned int ShuffleMask(u32 x, u32 y, u32 z, u32 w) {
-  return x | (y << 2) | (z << 4) | (w << 6);
-}
-
 Vec4 VMul(const Mat4& A, const Vec4& b) {
   Vec4 out_Ab;
   VMul(A, b, out_Ab);
@@ -51,10 +52,15 @@ Vec4 VMul(const Mat4& A, const Vec4& b) {
 }
 
 void VMul(const Mat4& A, const Vec4& b, Vec4& out_Ab) {
-  const __m128 bx = _mm_shuffle_ps(b.data, b.data, ShuffleMask(0, 0, 0, 0));
-  const __m128 by = _mm_shuffle_ps(b.data, b.data, ShuffleMask(1, 1, 1, 1));
-  const __m128 bz = _mm_shuffle_ps(b.data, b.data, ShuffleMask(2, 2, 2, 2));
-  const __m128 bw = _mm_shuffle_ps(b.data, b.data, ShuffleMask(3, 3, 3, 3));
+  // Masks are held in constants so GCC sees immediates in unoptimized builds
+  constexpr u32 kMaskX = ShuffleMask(0, 0, 0, 0);
+  constexpr u32 kMaskY = ShuffleMask(1, 1, 1, 1);
+  constexpr u32 kMaskZ = ShuffleMask(2, 2, 2, 2);
+  constexpr u32 kMaskW = ShuffleMask(3, 3, 3, 3);
+  const __m128 bx = _mm_shuffle_ps(b.data, b.data, kMaskX);
+  const __m128 by = _mm_shuffle_ps(b.data, b.data, kMaskY);
+  const __m128 bz = _mm_shuffle_ps(b.data, b.data, kMaskZ);
+  const __m128 bw = _mm_shuffle_ps(b.data, b.data, kMaskW);
   const __m128 abx = _mm_mul_ps(bx, A.cols[0].data);
   const __m128 aby = _mm_mul_ps(by, A.cols[1].data);
   const __m128 abz = _mm_mul_ps(bz, A.cols[2].data);
@@ -104,6 +110,80 @@ void MMul(const Mat4& A, const Mat4& B, Mat4& AB) {
   for (u32 i = 0; i < 4; i++) VMul(A, B.cols[i], AB.cols[i]);
 }
 
+void MMulBatch(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB) {
+  switch (GetSimdLevel()) {
+    case SimdLevel::kAvx512:
+      return MMulBatchAvx512(A, B, count, out_AB);
+    case SimdLevel::kAvx2:
+      return MMulBatchAvx2(A, B, count, out_AB);
+    default:
+      break;
+  }
+  for (u32 mat_i = 0; mat_i < count; mat_i++) {
+    // MMul reads A after writing columns of its output
+    Mat4 AB;
+    MMul(A[mat_i], B[mat_i], AB);
+    out_AB[mat_i] = AB;
+  }
+}
+
+void VMulBatch(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab) {
+  u32 vec_i = 0;
+  switch (GetSimdLevel()) {
+    case SimdLevel::kAvx512:
+      vec_i = VMulBatchAvx512(A, b, count, out_Ab);
+      break;
+    case SimdLevel::kAvx2:
+      vec_i = VMulBatchAvx2(A, b, count, out_Ab);
+      break;
+    default:
+      break;
+  }
+  for (; vec_i < count; vec_i++) VMul(A, b[vec_i], out_Ab[vec_i]);
+}
+
+void MTransformPoints(const Mat4& A, const PointStreams& points, u32 count,
+                      const PointStreams& out_points) {
+  u32 point_i = 0;
+  switch (GetSimdLevel()) {
+    case SimdLevel::kAvx512:
+      point_i = MTransformPointsAvx512(A, points, count, out_points);
+      break;
+    case SimdLevel::kAvx2:
+      point_i = MTransformPointsAvx2(A, points, count, out_points);
+      break;
+    default:
+      break;
+  }
+  // Element (row, col) of A broadcast to every lane
+  r32 a[16];
+  MStore(A, a);
+  __m128 rows[3][4];
+  for (u32 row_i = 0; row_i < 3; row_i++)
+    for (u32 col_i = 0; col_i < 4; col_i++)
+      rows[row_i][col_i] = _mm_set1_ps(a[row_i + col_i * 4]);
+  r32* out_streams[3] = {out_points.x, out_points.y, out_points.z};
+  for (; point_i + 4 <= count; point_i += 4) {
+    const __m128 x = _mm_loadu_ps(points.x + point_i);
+    const __m128 y = _mm_loadu_ps(points.y + point_i);
+    const __m128 z = _mm_loadu_ps(points.z + point_i);
+    for (u32 row_i = 0; row_i < 3; row_i++) {
+      __m128 out = _mm_add_ps(_mm_mul_ps(rows[row_i][2], z), rows[row_i][3]);
+      out = _mm_add_ps(_mm_mul_ps(rows[row_i][1], y), out);
+      out = _mm_add_ps(_mm_mul_ps(rows[row_i][0], x), out);
+      _mm_storeu_ps(out_streams[row_i] + point_i, out);
+    }
+  }
+  for (; point_i < count; point_i++) {
+    r32 x = points.x[point_i];
+    r32 y = points.y[point_i];
+    r32 z = points.z[point_i];
+    for (u32 row_i = 0; row_i < 3; row_i++)
+      out_streams[row_i][point_i] = a[row_i] * x + a[row_i + 4] * y +
+                                    a[row_i + 8] * z + a[row_i + 12];
+  }
+}
+
 // Gaussian Elimination without pivoting, numerical stability could be improved
 // by adding pivoting. This is a relatively expensive operation, SIMD
 // instructions might improve performance.
@@ -168,11 +248,68 @@ void ForwardSubstitution(const Mat4& L, const Vec4& b, Vec4& out_x) {
   VLoad(xf, out_x);
 }
 
-// Solve Ax = b, where A = LU is LU decomposition of A
-static void MSolveLU(const Mat4& L, const Mat4& U, const Vec4& b, Vec4& out_x) {
-  Vec4 y;
-  ForwardSubstitution(L, b, y);
-  BackSubstitution(U, y, out_x);
+// 2x2 matrices are packed row by row into one register
+static __m128 Mat2Mul(__m128 A, __m128 B) {
+  return _mm_add_ps(
+      _mm_mul_ps(A, Swizzle<ShuffleMask(0, 3, 0, 3)>(B)),
+      _mm_mul_ps(Swizzle<ShuffleMask(1, 0, 3, 2)>(A),
+                 Swizzle<ShuffleMask(2, 1, 2, 1)>(B)));
+}
+// adj(A) * B
+static __m128 Mat2AdjMul(__m128 A, __m128 B) {
+  return _mm_sub_ps(
+      _mm_mul_ps(Swizzle<ShuffleMask(3, 3, 0, 0)>(A), B),
+      _mm_mul_ps(Swizzle<ShuffleMask(1, 1, 2, 2)>(A),
+                 Swizzle<ShuffleMask(2, 3, 0, 1)>(B)));
+}
+// A * adj(B)
+static __m128 Mat2MulAdj(__m128 A, __m128 B) {
+  return _mm_sub_ps(
+      _mm_mul_ps(A, Swizzle<ShuffleMask(3, 0, 3, 0)>(B)),
+      _mm_mul_ps(Swizzle<ShuffleMask(1, 0, 3, 2)>(A),
+                 Swizzle<ShuffleMask(2, 1, 2, 1)>(B)));
+}
+// Translation column of an inverse with linear part cols, -(cols * t)
+static __m128 InverseTranslation(const __m128* cols, __m128 t) {
+  __m128 it = _mm_mul_ps(cols[0], Swizzle<ShuffleMask(0, 0, 0, 0)>(t));
+  it = _mm_add_ps(it, _mm_mul_ps(cols[1], Swizzle<ShuffleMask(1, 1, 1, 1)>(t)));
+  it = _mm_add_ps(it, _mm_mul_ps(cols[2], Swizzle<ShuffleMask(2, 2, 2, 2)>(t)));
+  return _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), it);
+}
+
+Vec3 VAdd(const Vec3& a, const Vec3& b) {
+  return Vec3{_mm_add_ps(a.data, b.data)};
+}
+Vec3 VSub(const Vec3& a, const Vec3& b) {
+  return Vec3{_mm_sub_ps(a.data, b.data)};
+}
+Vec3 VScale(const Vec3& a, r32 s) {
+  return Vec3{_mm_mul_ps(a.data, _mm_set1_ps(s))};
+}
+r32 VDot(const Vec3& a, const Vec3& b) {
+  return _mm_cvtss_f32(HorizontalSum(_mm_mul_ps(a.data, b.data)));
+}
+Vec3 VCross(const Vec3& a, const Vec3& b) {
+  Vec3 out_c;
+  VCross(a, b, out_c);
+  return out_c;
+}
+void VCross(const Vec3& a, const Vec3& b, Vec3& out_c) {
+  out_c.data = Cross(a.data, b.data);
+}
+r32 VLength(const Vec3& a) {
+  return _mm_cvtss_f32(
+      _mm_sqrt_ss(HorizontalSum(_mm_mul_ps(a.data, a.data))));
+}
+Vec3 VNormalize(const Vec3& a) {
+  Vec3 out_n;
+  VNormalize(a, out_n);
+  return out_n;
+}
+void VNormalize(const Vec3& a, Vec3& out_n) {
+  // Full division rather than rsqrt, which only has 12 bits
+  __m128 length = _mm_sqrt_ps(HorizontalSum(_mm_mul_ps(a.data, a.data)));
+  out_n.data = _mm_div_ps(a.data, length);
 }
 
 // Find Inverse of Matrix A
@@ -182,12 +319,90 @@ Mat4 MInverse(const Mat4& A) {
   return AI;
 }
 
+// Blockwise inversion with 2x2 adjugates. Written for rows, fed columns it
+// inverts the transpose, whose rows are the columns of the inverse.
 void MInverse(const Mat4& A, Mat4& AI) {
-  Mat4 L, U;
-  LUDecomposition(A, L, U);
-  for (u32 col_i = 0; col_i < 4; col_i++) {
-    MSolveLU(L, U, kIdentity.cols[col_i], AI.cols[col_i]);
-  }
+  const __m128 r0 = A.cols[0].data;
+  const __m128 r1 = A.cols[1].data;
+  const __m128 r2 = A.cols[2].data;
+  const __m128 r3 = A.cols[3].data;
+  // Blocks | X Y |
+  //        | Z W |
+  const __m128 X = Shuffle<ShuffleMask(0, 1, 0, 1)>(r0, r1);
+  const __m128 Y = Shuffle<ShuffleMask(2, 3, 2, 3)>(r0, r1);
+  const __m128 Z = Shuffle<ShuffleMask(0, 1, 0, 1)>(r2, r3);
+  const __m128 W = Shuffle<ShuffleMask(2, 3, 2, 3)>(r2, r3);
+  // Block determinants as (|X|, |Y|, |Z|, |W|)
+  const __m128 det_sub = _mm_sub_ps(
+      _mm_mul_ps(Shuffle<ShuffleMask(0, 2, 0, 2)>(r0, r2),
+                 Shuffle<ShuffleMask(1, 3, 1, 3)>(r1, r3)),
+      _mm_mul_ps(Shuffle<ShuffleMask(1, 3, 1, 3)>(r0, r2),
+                 Shuffle<ShuffleMask(0, 2, 0, 2)>(r1, r3)));
+  const __m128 det_x = Swizzle<ShuffleMask(0, 0, 0, 0)>(det_sub);
+  const __m128 det_y = Swizzle<ShuffleMask(1, 1, 1, 1)>(det_sub);
+  const __m128 det_z = Swizzle<ShuffleMask(2, 2, 2, 2)>(det_sub);
+  const __m128 det_w = Swizzle<ShuffleMask(3, 3, 3, 3)>(det_sub);
+  const __m128 adj_w_z = Mat2AdjMul(W, Z);
+  const __m128 adj_x_y = Mat2AdjMul(X, Y);
+  // Adjugates of the blocks of the inverse, scaled by |A|
+  __m128 ix = _mm_sub_ps(_mm_mul_ps(det_w, X), Mat2Mul(Y, adj_w_z));
+  __m128 iw = _mm_sub_ps(_mm_mul_ps(det_x, W), Mat2Mul(Z, adj_x_y));
+  __m128 iy = _mm_sub_ps(_mm_mul_ps(det_y, Z), Mat2MulAdj(W, adj_x_y));
+  __m128 iz = _mm_sub_ps(_mm_mul_ps(det_z, Y), Mat2MulAdj(X, adj_w_z));
+  // |A| = |X||W| + |Y||Z| - tr(adj(X)Y adj(W)Z)
+  __m128 det = _mm_add_ps(_mm_mul_ps(det_x, det_w), _mm_mul_ps(det_y, det_z));
+  __m128 trace = HorizontalSum(
+      _mm_mul_ps(adj_x_y, Swizzle<ShuffleMask(0, 2, 1, 3)>(adj_w_z)));
+  det = _mm_sub_ps(det, trace);
+  // Signs of the adjugate folded into the reciprocal
+  const __m128 rcp_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+  ix = _mm_mul_ps(ix, rcp_det);
+  iy = _mm_mul_ps(iy, rcp_det);
+  iz = _mm_mul_ps(iz, rcp_det);
+  iw = _mm_mul_ps(iw, rcp_det);
+  // Adjugate swizzle and block reassembly in one shuffle
+  AI.cols[0].data = Shuffle<ShuffleMask(3, 1, 3, 1)>(ix, iy);
+  AI.cols[1].data = Shuffle<ShuffleMask(2, 0, 2, 0)>(ix, iy);
+  AI.cols[2].data = Shuffle<ShuffleMask(3, 1, 3, 1)>(iz, iw);
+  AI.cols[3].data = Shuffle<ShuffleMask(2, 0, 2, 0)>(iz, iw);
+}
+
+Mat4 MInverseAffine(const Mat4& A) {
+  Mat4 AI;
+  MInverseAffine(A, AI);
+  return AI;
+}
+
+void MInverseAffine(const Mat4& A, Mat4& AI) {
+  // Rows of the inverse linear part are cross products of its columns
+  __m128 rows[4] = {Cross(A.cols[1].data, A.cols[2].data),
+                    Cross(A.cols[2].data, A.cols[0].data),
+                    Cross(A.cols[0].data, A.cols[1].data), _mm_setzero_ps()};
+  const __m128 det = HorizontalSum(_mm_mul_ps(A.cols[0].data, rows[0]));
+  const __m128 rcp_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+  rows[0] = _mm_mul_ps(rows[0], rcp_det);
+  rows[1] = _mm_mul_ps(rows[1], rcp_det);
+  rows[2] = _mm_mul_ps(rows[2], rcp_det);
+  // Transposed in place, rows holds the columns of the inverse from here
+  _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+  for (u32 col_i = 0; col_i < 3; col_i++) AI.cols[col_i].data = rows[col_i];
+  AI.cols[3].data = InverseTranslation(rows, A.cols[3].data);
+}
+
+Mat4 MInverseRigid(const Mat4& A) {
+  Mat4 AI;
+  MInverseRigid(A, AI);
+  return AI;
+}
+
+void MInverseRigid(const Mat4& A, Mat4& AI) {
+  // Inverse rotation is the transpose
+  __m128 cols[4] = {A.cols[0].data, A.cols[1].data, A.cols[2].data,
+                    _mm_setzero_ps()};
+  _MM_TRANSPOSE4_PS(cols[0], cols[1], cols[2], cols[3]);
+  const __m128 t = A.cols[3].data;
+  for (u32 col_i = 0; col_i < 3; col_i++) AI.cols[col_i].data = cols[col_i];
+  AI.cols[3].data = InverseTranslation(cols, t);
 }
 
 // View-to-Projection transform for a Perspective camera with fovx radians, and
@@ -200,7 +415,9 @@ Mat4 MPerspective(const r32 fovx, const r32 aspect_ratio, const r32 near_plane,
 }
 void MPerspective(const r32 fovx, const r32 aspect_ratio, const r32 near_plane,
                   const r32 far_plane, Mat4& out_P) {
-  r32 halfcot = 1.0f / tanf(fovx / 2.0f);
+  Vec4 sin_half, cos_half;
+  VSinCos4(Vec4{_mm_set1_ps(fovx / 2.0f)}, sin_half, cos_half);
+  r32 halfcot = _mm_cvtss_f32(cos_half.data) / _mm_cvtss_f32(sin_half.data);
   float P[16] = {halfcot,
                  0.0f,
                  0.0f,
@@ -228,9 +445,15 @@ Mat4 MRotation(const r32 rotx, const r32 roty, const r32 rotz) {
 }
 
 void MRotation(const r32 rotx, const r32 roty, const r32 rotz, Mat4& out_R) {
-  r32 cz = cos(rotz), sz = sin(rotz);
-  r32 cy = cos(roty), sy = sin(roty);
-  r32 cx = cos(rotx), sx = sin(rotx);
+  // One approximation for all three angles instead of six libm calls
+  Vec4 sin_xyz, cos_xyz;
+  VSinCos4(Vec4{rotx, roty, rotz, 0.0f}, sin_xyz, cos_xyz);
+  alignas(16) r32 sin_f[4], cos_f[4];
+  VStore(sin_xyz, sin_f);
+  VStore(cos_xyz, cos_f);
+  r32 cz = cos_f[2], sz = sin_f[2];
+  r32 cy = cos_f[1], sy = sin_f[1];
+  r32 cx = cos_f[0], sx = sin_f[0];
   r32 R[16] = {cz * cy, //cy
                sz * cy, // 0
                -sy, // -sy
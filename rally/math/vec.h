@@ -2,8 +2,10 @@
 #include <rally/types.h>
 #include <xmmintrin.h>
 namespace rally {
-// LU Decomposition is the limiting factor for this epsilon
-constexpr r32 eps = 1e-2;
+// Tolerance of VNear and MNear per element, scaled by the magnitude of the
+// element when above 1.
+// Products with the cofactor inverse stay well within it.
+constexpr r32 eps = 1e-4;
 
 struct Vec2 {
   alignas(8) r32 x;
@@ -18,18 +20,36 @@ struct Vec4 {
 struct Mat4 {
   Vec4 cols[4];
 };
+// Points split into one array per coordinate
+struct PointStreams {
+  r32* x;
+  r32* y;
+  r32* z;
+};
 
 constexpr Mat4 kIdentity = {
     {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
 
 // Are all elements in the containers close? (determined by epsilon)
-bool VNear(const Vec4& a, const Vec4& b);
-bool MNear(const Mat4& A, const Mat4& B);
+bool VNear(const Vec4& a, const Vec4& b, r32 tolerance = eps);
+bool MNear(const Mat4& A, const Mat4& B, r32 tolerance = eps);
 
 // Element-wise addition
 Vec4 VAdd(const Vec4& a, const Vec4& b);
 void VAdd(const Vec4& a, const Vec4& b, Vec4& out_c);
 
+// Vec3 routines keep the padding lane at zero
+Vec3 VAdd(const Vec3& a, const Vec3& b);
+Vec3 VSub(const Vec3& a, const Vec3& b);
+Vec3 VScale(const Vec3& a, r32 s);
+r32 VDot(const Vec3& a, const Vec3& b);
+Vec3 VCross(const Vec3& a, const Vec3& b);
+void VCross(const Vec3& a, const Vec3& b, Vec3& out_c);
+r32 VLength(const Vec3& a);
+// a must not be zero
+Vec3 VNormalize(const Vec3& a);
+void VNormalize(const Vec3& a, Vec3& out_n);
+
 // Dot product of two vectors
 r32 VDot(const Vec4& a, const Vec4& b);
 
@@ -41,6 +61,16 @@ void VMul(const Mat4& A, const Vec4& b, Vec4& out_Ab);
 Mat4 MMul(const Mat4& A, const Mat4& B);
 void MMul(const Mat4& A, const Mat4& B, Mat4& out_AB);
 
+// Batched routines, dispatched to the widest instruction set GetSimdLevel
+// allows. Outputs may alias inputs of the same index.
+// Pairwise Matrix-Matrix multiplication, out_AB[i] = A[i] * B[i]
+void MMulBatch(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB);
+// Matrix-Vector multiplication of every vector, out_Ab[i] = A * b[i]
+void VMulBatch(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab);
+// Transform points with w = 1, ignoring the projective row of A
+void MTransformPoints(const Mat4& A, const PointStreams& points, u32 count,
+                      const PointStreams& out_points);
+
 // Move vector/matrix contents to float array
 // Matrix is stored in column order!
 void VStore(const Vec4& a, r32* const out_arr);
@@ -63,9 +93,15 @@ void BackSubstitution(const Mat4& U, const Vec4& b, Vec4& out_x);
 // Solve Lx=b where L is lower-triangular
 Vec4 ForwardSubstitution(const Mat4& L, const Vec4& b);
 void ForwardSubstitution(const Mat4& L, const Vec4& b, Vec4& out_x);
-// Find Inverse of Matrix A
+// Find Inverse of Matrix A, cofactor-based
 Mat4 MInverse(const Mat4& A);
 void MInverse(const Mat4& A, Mat4& out_AI);
+// Inverse of an affine transform, the last row of A must be (0, 0, 0, 1)
+Mat4 MInverseAffine(const Mat4& A);
+void MInverseAffine(const Mat4& A, Mat4& out_AI);
+// Inverse of a rotation followed by a translation, no scale or shear
+Mat4 MInverseRigid(const Mat4& A);
+void MInverseRigid(const Mat4& A, Mat4& out_AI);
 
 // Matrix Transformation Routines
 // View-to-Projection transform for a Perspective camera with fovx radians, and
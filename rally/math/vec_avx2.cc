@@ -0,0 +1,70 @@
+#include <immintrin.h>
+#include <rally/math/vec_simd.h>
+
+// Compiled with AVX2 and FMA, only reached when GetSimdLevel allows it
+namespace rally {
+void MMulBatchAvx2(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB) {
+  for (u32 mat_i = 0; mat_i < count; mat_i++) {
+    // Columns of A in both lanes, each lane computes one column of AB
+    const __m256 a0 = _mm256_broadcast_ps(&A[mat_i].cols[0].data);
+    const __m256 a1 = _mm256_broadcast_ps(&A[mat_i].cols[1].data);
+    const __m256 a2 = _mm256_broadcast_ps(&A[mat_i].cols[2].data);
+    const __m256 a3 = _mm256_broadcast_ps(&A[mat_i].cols[3].data);
+    const r32* b = (const r32*)&B[mat_i];
+    const __m256 b01 = _mm256_loadu_ps(b);
+    const __m256 b23 = _mm256_loadu_ps(b + 8);
+    __m256 ab01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+    __m256 ab23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+    ab01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), ab01);
+    ab23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), ab23);
+    ab01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), ab01);
+    ab23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), ab23);
+    ab01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), ab01);
+    ab23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), ab23);
+    r32* ab = (r32*)&out_AB[mat_i];
+    _mm256_storeu_ps(ab, ab01);
+    _mm256_storeu_ps(ab + 8, ab23);
+  }
+}
+u32 VMulBatchAvx2(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab) {
+  const __m256 a0 = _mm256_broadcast_ps(&A.cols[0].data);
+  const __m256 a1 = _mm256_broadcast_ps(&A.cols[1].data);
+  const __m256 a2 = _mm256_broadcast_ps(&A.cols[2].data);
+  const __m256 a3 = _mm256_broadcast_ps(&A.cols[3].data);
+  u32 vec_i = 0;
+  // Two vectors per iteration, one per lane
+  for (; vec_i + 2 <= count; vec_i += 2) {
+    const __m256 bb = _mm256_loadu_ps((const r32*)&b[vec_i]);
+    __m256 ab = _mm256_mul_ps(a0, _mm256_permute_ps(bb, 0x00));
+    ab = _mm256_fmadd_ps(a1, _mm256_permute_ps(bb, 0x55), ab);
+    ab = _mm256_fmadd_ps(a2, _mm256_permute_ps(bb, 0xAA), ab);
+    ab = _mm256_fmadd_ps(a3, _mm256_permute_ps(bb, 0xFF), ab);
+    _mm256_storeu_ps((r32*)&out_Ab[vec_i], ab);
+  }
+  return vec_i;
+}
+u32 MTransformPointsAvx2(const Mat4& A, const PointStreams& points, u32 count,
+                         const PointStreams& out_points) {
+  // Element (row, col) of A broadcast to every lane
+  r32 a[16];
+  MStore(A, a);
+  __m256 rows[3][4];
+  for (u32 row_i = 0; row_i < 3; row_i++)
+    for (u32 col_i = 0; col_i < 4; col_i++)
+      rows[row_i][col_i] = _mm256_set1_ps(a[row_i + col_i * 4]);
+  r32* out_streams[3] = {out_points.x, out_points.y, out_points.z};
+  u32 point_i = 0;
+  for (; point_i + 8 <= count; point_i += 8) {
+    const __m256 x = _mm256_loadu_ps(points.x + point_i);
+    const __m256 y = _mm256_loadu_ps(points.y + point_i);
+    const __m256 z = _mm256_loadu_ps(points.z + point_i);
+    for (u32 row_i = 0; row_i < 3; row_i++) {
+      __m256 out = _mm256_fmadd_ps(rows[row_i][2], z, rows[row_i][3]);
+      out = _mm256_fmadd_ps(rows[row_i][1], y, out);
+      out = _mm256_fmadd_ps(rows[row_i][0], x, out);
+      _mm256_storeu_ps(out_streams[row_i] + point_i, out);
+    }
+  }
+  return point_i;
+}
+}  // namespace rally
\ No newline at end of file
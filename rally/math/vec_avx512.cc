@@ -0,0 +1,62 @@
+#include <immintrin.h>
+#include <rally/math/vec_simd.h>
+
+// Compiled with AVX-512F, only reached when GetSimdLevel allows it
+namespace rally {
+void MMulBatchAvx512(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB) {
+  for (u32 mat_i = 0; mat_i < count; mat_i++) {
+    // Columns of A in all four lanes, each lane computes one column of AB
+    const __m512 a0 = _mm512_broadcast_f32x4(A[mat_i].cols[0].data);
+    const __m512 a1 = _mm512_broadcast_f32x4(A[mat_i].cols[1].data);
+    const __m512 a2 = _mm512_broadcast_f32x4(A[mat_i].cols[2].data);
+    const __m512 a3 = _mm512_broadcast_f32x4(A[mat_i].cols[3].data);
+    const __m512 b = _mm512_loadu_ps((const r32*)&B[mat_i]);
+    __m512 ab = _mm512_mul_ps(a0, _mm512_permute_ps(b, 0x00));
+    ab = _mm512_fmadd_ps(a1, _mm512_permute_ps(b, 0x55), ab);
+    ab = _mm512_fmadd_ps(a2, _mm512_permute_ps(b, 0xAA), ab);
+    ab = _mm512_fmadd_ps(a3, _mm512_permute_ps(b, 0xFF), ab);
+    _mm512_storeu_ps((r32*)&out_AB[mat_i], ab);
+  }
+}
+u32 VMulBatchAvx512(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab) {
+  const __m512 a0 = _mm512_broadcast_f32x4(A.cols[0].data);
+  const __m512 a1 = _mm512_broadcast_f32x4(A.cols[1].data);
+  const __m512 a2 = _mm512_broadcast_f32x4(A.cols[2].data);
+  const __m512 a3 = _mm512_broadcast_f32x4(A.cols[3].data);
+  u32 vec_i = 0;
+  // Four vectors per iteration, one per lane
+  for (; vec_i + 4 <= count; vec_i += 4) {
+    const __m512 bb = _mm512_loadu_ps((const r32*)&b[vec_i]);
+    __m512 ab = _mm512_mul_ps(a0, _mm512_permute_ps(bb, 0x00));
+    ab = _mm512_fmadd_ps(a1, _mm512_permute_ps(bb, 0x55), ab);
+    ab = _mm512_fmadd_ps(a2, _mm512_permute_ps(bb, 0xAA), ab);
+    ab = _mm512_fmadd_ps(a3, _mm512_permute_ps(bb, 0xFF), ab);
+    _mm512_storeu_ps((r32*)&out_Ab[vec_i], ab);
+  }
+  return vec_i;
+}
+u32 MTransformPointsAvx512(const Mat4& A, const PointStreams& points,
+                           u32 count, const PointStreams& out_points) {
+  // Element (row, col) of A broadcast to every lane
+  r32 a[16];
+  MStore(A, a);
+  __m512 rows[3][4];
+  for (u32 row_i = 0; row_i < 3; row_i++)
+    for (u32 col_i = 0; col_i < 4; col_i++)
+      rows[row_i][col_i] = _mm512_set1_ps(a[row_i + col_i * 4]);
+  r32* out_streams[3] = {out_points.x, out_points.y, out_points.z};
+  u32 point_i = 0;
+  for (; point_i + 16 <= count; point_i += 16) {
+    const __m512 x = _mm512_loadu_ps(points.x + point_i);
+    const __m512 y = _mm512_loadu_ps(points.y + point_i);
+    const __m512 z = _mm512_loadu_ps(points.z + point_i);
+    for (u32 row_i = 0; row_i < 3; row_i++) {
+      __m512 out = _mm512_fmadd_ps(rows[row_i][2], z, rows[row_i][3]);
+      out = _mm512_fmadd_ps(rows[row_i][1], y, out);
+      out = _mm512_fmadd_ps(rows[row_i][0], x, out);
+      _mm512_storeu_ps(out_streams[row_i] + point_i, out);
+    }
+  }
+  return point_i;
+}
+}  // namespace rally
\ No newline at end of file
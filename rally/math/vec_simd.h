@@ -0,0 +1,42 @@
+#pragma once
+#include <rally/math/vec.h>
+
+namespace rally {
+// Lane selectors of _mm_shuffle_ps, x is the first output lane
+inline constexpr u32 ShuffleMask(u32 x, u32 y, u32 z, u32 w) {
+  return x | (y << 2) | (z << 4) | (w << 6);
+}
+// Mask as a template argument so it stays an immediate in unoptimized builds
+template <u32 kMask>
+inline __m128 Shuffle(__m128 a, __m128 b) {
+  return _mm_shuffle_ps(a, b, kMask);
+}
+template <u32 kMask>
+inline __m128 Swizzle(__m128 a) {
+  return _mm_shuffle_ps(a, a, kMask);
+}
+// Every lane holds the sum of the lanes of a
+inline __m128 HorizontalSum(__m128 a) {
+  __m128 sum = _mm_add_ps(a, Swizzle<ShuffleMask(2, 3, 0, 1)>(a));
+  return _mm_add_ps(sum, Swizzle<ShuffleMask(1, 0, 3, 2)>(sum));
+}
+// Cross product of the xyz lanes, w is zero
+inline __m128 Cross(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(Swizzle<ShuffleMask(1, 2, 0, 3)>(a),
+                               Swizzle<ShuffleMask(2, 0, 1, 3)>(b)),
+                    _mm_mul_ps(Swizzle<ShuffleMask(2, 0, 1, 3)>(a),
+                               Swizzle<ShuffleMask(1, 2, 0, 3)>(b)));
+}
+
+// Batch kernels of vec.h per instruction set, each file is compiled for its
+// own level. Call the dispatching functions in vec.h instead. Kernels return
+// how many elements they handled, the caller finishes the rest.
+void MMulBatchAvx2(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB);
+u32 VMulBatchAvx2(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab);
+u32 MTransformPointsAvx2(const Mat4& A, const PointStreams& points, u32 count,
+                         const PointStreams& out_points);
+void MMulBatchAvx512(const Mat4* A, const Mat4* B, u32 count, Mat4* out_AB);
+u32 VMulBatchAvx512(const Mat4& A, const Vec4* b, u32 count, Vec4* out_Ab);
+u32 MTransformPointsAvx512(const Mat4& A, const PointStreams& points,
+                           u32 count, const PointStreams& out_points);
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <rally/memory/concurrentallocator.h>
+#include <rally/thread/thread.h>
+
+namespace rally {
+constexpr s64 kBlockAlign = kCacheLineSize;
+constexpr s64 kBlockHeaderSize =
+    (sizeof(ConcurrentBlock) + kBlockAlign - 1) / kBlockAlign * kBlockAlign;
+static char* GetBlockData(ConcurrentBlock* block) {
+  return (char*)block + kBlockHeaderSize;
+}
+static ConcurrentBlock* CreateConcurrentBlock(StackAllocator* parent,
+                                              s64 block_size) {
+  ConcurrentBlock* block = (ConcurrentBlock*)StackAllocate(
+      parent, kBlockHeaderSize + block_size, kBlockAlign);
+  if (block == nullptr) return nullptr;
+  block->next = nullptr;
+  block->size = block_size;
+  block->occupied.store(0);
+  return block;
+}
+static void* BlockAllocate(ConcurrentBlock* block, s64 alloc_size,
+                           s64 alloc_align) {
+  // Align addresses rather than offsets, the parent only guarantees the
+  // alignment of its own base
+  s64 base = (s64)(uintptr_t)GetBlockData(block);
+  s64 occupied = block->occupied.load(std::memory_order_relaxed);
+  while (true) {
+    s64 alloc_blocks = (base + occupied + alloc_align - 1) / alloc_align;
+    s64 begin_alloc = alloc_blocks * alloc_align - base;
+    s64 end_alloc = begin_alloc + alloc_size;
+    // Leave occupied untouched on failure so a larger block can take over
+    if (end_alloc > block->size) return nullptr;
+    if (block->occupied.compare_exchange_weak(occupied, end_alloc,
+                                              std::memory_order_relaxed))
+      return GetBlockData(block) + begin_alloc;
+  }
+}
+// Move past the full block, reusing blocks from before the last reset when
+// they are large enough. Returns true if no block could be found.
+static bool GrowConcurrentAllocator(ConcurrentAllocator* alloc,
+                                    ConcurrentBlock* full, s64 min_size) {
+  b32 expected = false;
+  while (!alloc->growing.compare_exchange_weak(expected, true,
+                                               std::memory_order_acquire)) {
+    expected = false;
+    CpuRelax();
+  }
+  bool failed = false;
+  // Another thread may have grown the allocator while we waited
+  if (alloc->current.load(std::memory_order_relaxed) == full) {
+    ConcurrentBlock* next = full->next;
+    if (next == nullptr || next->size < min_size) {
+      s64 block_size =
+          min_size > alloc->block_size ? min_size : alloc->block_size;
+      next = CreateConcurrentBlock(alloc->parent, block_size);
+      if (next != nullptr) {
+        next->next = full->next;
+        full->next = next;
+      }
+    }
+    if (next != nullptr)
+      alloc->current.store(next, std::memory_order_release);
+    else
+      failed = true;
+  }
+  alloc->growing.store(false, std::memory_order_release);
+  return failed;
+}
+ConcurrentAllocator* CreateConcurrentAllocator(StackAllocator* parent,
+                                               s64 block_size) {
+  ConcurrentAllocator* alloc = SALLOC(parent, ConcurrentAllocator, 1);
+  if (alloc == nullptr) return nullptr;
+  alloc->block_size = block_size;
+  alloc->parent = parent;
+  alloc->growing.store(false);
+  alloc->first = CreateConcurrentBlock(parent, block_size);
+  if (alloc->first == nullptr) return nullptr;
+  alloc->current.store(alloc->first);
+  return alloc;
+}
+void* ConcurrentAllocate(ConcurrentAllocator* alloc, s64 alloc_size,
+                         s64 alloc_align) {
+  return ConcurrentAllocateArray(alloc, 1, alloc_size, alloc_align);
+}
+void* ConcurrentAllocateArray(ConcurrentAllocator* alloc, s64 array_len,
+                              s64 alloc_size, s64 alloc_align) {
+  s64 total_size = array_len * alloc_size;
+  while (true) {
+    ConcurrentBlock* block = alloc->current.load(std::memory_order_acquire);
+    void* data = BlockAllocate(block, total_size, alloc_align);
+    if (data != nullptr) return data;
+    if (GrowConcurrentAllocator(alloc, block, total_size + alloc_align))
+      return nullptr;
+  }
+}
+void ResetConcurrentAllocator(ConcurrentAllocator* alloc) {
+  for (ConcurrentBlock* block = alloc->first; block != nullptr;
+       block = block->next) {
+    block->occupied.store(0);
+  }
+  alloc->current.store(alloc->first);
+}
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+#include <atomic>
+
+#define CALLOC(alloc, type, array_len)                            \
+  (type*)ConcurrentAllocateArray((alloc), (array_len), sizeof(type), \
+                                 alignof(type))
+
+namespace rally {
+// Block of a concurrent allocator, data follows the header
+struct ConcurrentBlock {
+  ConcurrentBlock* next;
+  s64 size;
+  alignas(kCacheLineSize) std::atomic<s64> occupied;
+};
+// Linear allocator any number of threads can allocate from at once. Blocks
+// are bumped with compare-exchange and chained from overflow blocks taken
+// from the parent StackAllocator when full. There is no individual free, the
+// allocator is reset as a whole.
+struct ConcurrentAllocator {
+  std::atomic<ConcurrentBlock*> current;
+  ConcurrentBlock* first;
+  s64 block_size;
+  // Parent is only used while holding the growing lock
+  StackAllocator* parent;
+  std::atomic<b32> growing;
+};
+// Nothing else may allocate from parent while other threads can allocate
+// from the returned allocator
+ConcurrentAllocator* CreateConcurrentAllocator(StackAllocator* parent,
+                                               s64 block_size);
+// Same rounding as StackAllocateArray, applied to the address so alignment
+// holds whatever the alignment of the parent's memory
+void* ConcurrentAllocate(ConcurrentAllocator* alloc, s64 alloc_size,
+                         s64 alloc_align);
+void* ConcurrentAllocateArray(ConcurrentAllocator* alloc, s64 array_len,
+                              s64 alloc_size, s64 alloc_align);
+// Free every allocation, blocks are kept and reused. No thread may be
+// allocating concurrently.
+void ResetConcurrentAllocator(ConcurrentAllocator* alloc);
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include <rally/dev/dev.h>
+#include <rally/memory/frameallocator.h>
+
+namespace rally {
+FrameAllocator* CreateFrameAllocator(StackAllocator* parent, u32 frame_count,
+                                     s64 frame_size) {
+  ASSERT(frame_count > 0 && frame_count <= kMaxAllocatorFrames,
+         "Invalid frame count!");
+  FrameAllocator* frame_alloc = SALLOCZ(parent, FrameAllocator, 1);
+  if (frame_alloc == nullptr) return nullptr;
+  frame_alloc->frame_count = frame_count;
+  for (u32 frame_i = 0; frame_i < frame_count; frame_i++) {
+    void* frame_data = StackAllocate(parent, frame_size, alignof(s64));
+    if (frame_data == nullptr) return nullptr;
+    frame_alloc->frames[frame_i] = CreateStackAllocator(frame_data, frame_size);
+  }
+  return frame_alloc;
+}
+StackAllocator* BeginAllocatorFrame(FrameAllocator* frame_alloc, u32 frame_i) {
+  ASSERT(frame_i < frame_alloc->frame_count, "Invalid frame index!");
+  StackAllocator* frame = frame_alloc->frames[frame_i];
+  ResetStackAllocator(frame);
+  frame_alloc->frame_i = frame_i;
+  return frame;
+}
+void* FrameAllocate(FrameAllocator* frame_alloc, s64 alloc_size,
+                    s64 alloc_align) {
+  return FrameAllocateArray(frame_alloc, 1, alloc_size, alloc_align);
+}
+void* FrameAllocateArray(FrameAllocator* frame_alloc, s64 array_len,
+                         s64 alloc_size, s64 alloc_align) {
+  StackAllocator* frame = frame_alloc->frames[frame_alloc->frame_i];
+  void* data = StackAllocateArray(frame, array_len, alloc_size, alloc_align);
+  if (data != nullptr && frame->occupied > frame_alloc->peak_size)
+    frame_alloc->peak_size = frame->occupied;
+  return data;
+}
+}  // namespace rally
\ No newline at end of file
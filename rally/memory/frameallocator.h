@@ -0,0 +1,31 @@
+#pragma once
+
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+#define FALLOC(alloc, type, array_len)                          \
+  (type*)FrameAllocateArray((alloc), (array_len), sizeof(type), \
+                            alignof(type))
+
+namespace rally {
+constexpr u32 kMaxAllocatorFrames = 8;
+// One stack per frame in flight, a frame's stack is reset when its frame
+// index comes around again so its data lives until then
+struct FrameAllocator {
+  u32 frame_count;
+  u32 frame_i;
+  StackAllocator* frames[kMaxAllocatorFrames];
+  // Largest size used by any frame, for sizing frame_size
+  s64 peak_size;
+};
+FrameAllocator* CreateFrameAllocator(StackAllocator* parent, u32 frame_count,
+                                     s64 frame_size);
+// Free everything allocated the last time frame_i was current and make it
+// current, returns the frame's stack
+StackAllocator* BeginAllocatorFrame(FrameAllocator* frame_alloc, u32 frame_i);
+// Allocate from the current frame
+void* FrameAllocate(FrameAllocator* frame_alloc, s64 alloc_size,
+                    s64 alloc_align);
+void* FrameAllocateArray(FrameAllocator* frame_alloc, s64 array_len,
+                         s64 alloc_size, s64 alloc_align);
+}  // namespace rally
\ No newline at end of file
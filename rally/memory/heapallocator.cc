@@ -0,0 +1,295 @@
+#include <rally/dev/dev.h>
+#include <rally/memory/heapallocator.h>
+#include <string.h>
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+namespace rally {
+constexpr s64 kHeapHeaderSize = 2 * sizeof(void*);
+// A free block must hold its free list links
+constexpr s64 kHeapMinSize = 2 * sizeof(void*);
+constexpr s64 kHeapMinBlockSize = kHeapHeaderSize + kHeapMinSize;
+constexpr u32 kHeapFLShift = kHeapSLLog2 + 4;
+constexpr s64 kHeapSmallSize = (s64)1 << kHeapFLShift;
+constexpr s64 kHeapFreeBit = 1;
+static_assert(kHeapHeaderSize % kHeapAlign == 0, "Misaligned heap payloads!");
+
+static u32 FindFirstSet(u32 word) {
+#ifdef _WIN32
+  unsigned long index;
+  _BitScanForward(&index, word);
+  return index;
+#else
+  return __builtin_ctz(word);
+#endif
+}
+static u32 FindLastSet(s64 word) {
+#ifdef _WIN32
+  unsigned long index;
+  _BitScanReverse64(&index, word);
+  return index;
+#else
+  return 63 - __builtin_clzll(word);
+#endif
+}
+static s64 GetBlockSize(HeapBlock* block) {
+  return block->size & ~kHeapFreeBit;
+}
+static bool IsBlockFree(HeapBlock* block) {
+  return (block->size & kHeapFreeBit) != 0;
+}
+static char* GetBlockPayload(HeapBlock* block) {
+  return (char*)block + kHeapHeaderSize;
+}
+static HeapBlock* GetPayloadBlock(void* data) {
+  return (HeapBlock*)((char*)data - kHeapHeaderSize);
+}
+static HeapBlock* GetNextBlock(HeapBlock* block) {
+  return (HeapBlock*)(GetBlockPayload(block) + GetBlockSize(block));
+}
+// Size class containing size
+static void MapHeapSize(s64 size, u32* fl, u32* sl) {
+  if (size < kHeapSmallSize) {
+    *fl = 0;
+    *sl = (u32)(size / (kHeapSmallSize / kHeapSLCount));
+  } else {
+    u32 last_set = FindLastSet(size);
+    *sl = (u32)(size >> (last_set - kHeapSLLog2)) ^ kHeapSLCount;
+    *fl = last_set - kHeapFLShift + 1;
+  }
+}
+// Round up to the next size class so any block found there is large enough
+static s64 RoundHeapSize(s64 size) {
+  if (size < kHeapSmallSize) return size;
+  s64 round = ((s64)1 << (FindLastSet(size) - kHeapSLLog2)) - 1;
+  return size + round;
+}
+static void InsertFreeBlock(HeapAllocator* heap, HeapBlock* block) {
+  u32 fl, sl;
+  MapHeapSize(GetBlockSize(block), &fl, &sl);
+  HeapBlock* head = heap->free_lists[fl][sl];
+  block->size |= kHeapFreeBit;
+  block->next_free = head;
+  block->prev_free = nullptr;
+  if (head != nullptr) head->prev_free = block;
+  heap->free_lists[fl][sl] = block;
+  heap->fl_bitmap |= 1u << fl;
+  heap->sl_bitmaps[fl] |= 1u << sl;
+}
+static void RemoveFreeBlock(HeapAllocator* heap, HeapBlock* block) {
+  u32 fl, sl;
+  MapHeapSize(GetBlockSize(block), &fl, &sl);
+  if (block->prev_free != nullptr)
+    block->prev_free->next_free = block->next_free;
+  else
+    heap->free_lists[fl][sl] = block->next_free;
+  if (block->next_free != nullptr)
+    block->next_free->prev_free = block->prev_free;
+  block->size &= ~kHeapFreeBit;
+  if (heap->free_lists[fl][sl] == nullptr) {
+    heap->sl_bitmaps[fl] &= ~(1u << sl);
+    if (heap->sl_bitmaps[fl] == 0) heap->fl_bitmap &= ~(1u << fl);
+  }
+}
+static HeapBlock* FindFreeBlock(HeapAllocator* heap, s64 size) {
+  u32 fl, sl;
+  MapHeapSize(RoundHeapSize(size), &fl, &sl);
+  if (fl >= kHeapFLCount) return nullptr;
+  u32 sl_bitmap = heap->sl_bitmaps[fl] & (~0u << sl);
+  if (sl_bitmap == 0) {
+    u32 fl_bitmap = fl + 1 < kHeapFLCount ? heap->fl_bitmap & (~0u << (fl + 1))
+                                          : 0;
+    if (fl_bitmap == 0) return nullptr;
+    fl = FindFirstSet(fl_bitmap);
+    sl_bitmap = heap->sl_bitmaps[fl];
+  }
+  return heap->free_lists[fl][FindFirstSet(sl_bitmap)];
+}
+// Split a used block so it has size bytes, the remainder becomes free
+static void TrimBlock(HeapAllocator* heap, HeapBlock* block, s64 size) {
+  s64 remaining = GetBlockSize(block) - size;
+  if (remaining < kHeapMinBlockSize) return;
+  HeapBlock* next = GetNextBlock(block);
+  HeapBlock* remainder = (HeapBlock*)(GetBlockPayload(block) + size);
+  remainder->prev_physical = block;
+  remainder->size = remaining - kHeapHeaderSize;
+  block->size = size;
+  // The following block may be free when shrinking a used block
+  if (IsBlockFree(next)) {
+    RemoveFreeBlock(heap, next);
+    remainder->size += kHeapHeaderSize + GetBlockSize(next);
+    next = GetNextBlock(next);
+  }
+  next->prev_physical = remainder;
+  InsertFreeBlock(heap, remainder);
+}
+static s64 AlignHeapSize(s64 size) {
+  if (size < kHeapMinSize) size = kHeapMinSize;
+  return (size + kHeapAlign - 1) / kHeapAlign * kHeapAlign;
+}
+HeapAllocator* CreateHeapAllocator(StackAllocator* parent, s64 heap_size) {
+  HeapAllocator* heap = SALLOCZ(parent, HeapAllocator, 1);
+  if (heap == nullptr) return nullptr;
+  // Parent alignment is relative to its base, align the address instead
+  char* data = (char*)StackAllocate(parent, heap_size, 1);
+  if (data == nullptr) return nullptr;
+  uintptr_t address = (uintptr_t)data + kHeapAlign - 1;
+  heap->data = (char*)(address - address % kHeapAlign);
+  heap->size = (heap_size - (heap->data - data)) / kHeapAlign * kHeapAlign;
+  ASSERT(heap->size >= 2 * kHeapHeaderSize + kHeapMinSize, "Heap too small!");
+  ASSERT(FindLastSet(heap->size) - kHeapFLShift + 1 < kHeapFLCount,
+         "Heap too large!");
+  // One free block spanning the heap, then an empty used block so merging
+  // never walks off the end
+  heap->first = (HeapBlock*)heap->data;
+  heap->first->prev_physical = nullptr;
+  heap->first->size = heap->size - 2 * kHeapHeaderSize;
+  HeapBlock* sentinel = GetNextBlock(heap->first);
+  sentinel->prev_physical = heap->first;
+  sentinel->size = 0;
+  InsertFreeBlock(heap, heap->first);
+  return heap;
+}
+void* HeapAllocate(HeapAllocator* heap, s64 alloc_size, s64 alloc_align) {
+  s64 size = AlignHeapSize(alloc_size);
+  // Larger alignments need room to split a free block off the front
+  s64 search_size = size;
+  if (alloc_align > kHeapAlign) search_size += alloc_align + kHeapMinBlockSize;
+  HeapBlock* block = FindFreeBlock(heap, search_size);
+  if (block == nullptr) return nullptr;
+  RemoveFreeBlock(heap, block);
+  if (alloc_align > kHeapAlign) {
+    uintptr_t payload = (uintptr_t)GetBlockPayload(block);
+    uintptr_t aligned = (payload + alloc_align - 1) / alloc_align * alloc_align;
+    if (aligned != payload && aligned - payload < (uintptr_t)kHeapMinBlockSize)
+      aligned = (payload + kHeapMinBlockSize + alloc_align - 1) / alloc_align *
+                alloc_align;
+    s64 gap = (s64)(aligned - payload);
+    if (gap > 0) {
+      HeapBlock* aligned_block = (HeapBlock*)((char*)block + gap);
+      aligned_block->prev_physical = block;
+      aligned_block->size = GetBlockSize(block) - gap;
+      GetNextBlock(aligned_block)->prev_physical = aligned_block;
+      block->size = gap - kHeapHeaderSize;
+      InsertFreeBlock(heap, block);
+      block = aligned_block;
+    }
+  }
+  TrimBlock(heap, block, size);
+  heap->used_size += GetBlockSize(block);
+  if (heap->used_size > heap->peak_used_size)
+    heap->peak_used_size = heap->used_size;
+  heap->allocation_count++;
+  // Slack past alloc_size stays zeroed so reallocation can grow into it
+  memset(GetBlockPayload(block), 0, GetBlockSize(block));
+  return GetBlockPayload(block);
+}
+void* HeapReallocate(HeapAllocator* heap, void* data, s64 alloc_size,
+                     s64 alloc_align) {
+  if (data == nullptr) return HeapAllocate(heap, alloc_size, alloc_align);
+  HeapBlock* block = GetPayloadBlock(data);
+  s64 old_size = GetBlockSize(block);
+  s64 size = AlignHeapSize(alloc_size);
+  ASSERT((uintptr_t)data % alloc_align == 0, "Alignment changed!");
+  HeapBlock* next = GetNextBlock(block);
+  if (size > old_size && IsBlockFree(next) &&
+      old_size + kHeapHeaderSize + GetBlockSize(next) >= size) {
+    // Absorb the following free block
+    RemoveFreeBlock(heap, next);
+    block->size += kHeapHeaderSize + GetBlockSize(next);
+    GetNextBlock(block)->prev_physical = block;
+  }
+  if (GetBlockSize(block) >= size) {
+    TrimBlock(heap, block, size);
+    heap->used_size += GetBlockSize(block) - old_size;
+    if (heap->used_size > heap->peak_used_size)
+      heap->peak_used_size = heap->used_size;
+    if (size > old_size)
+      memset((char*)data + old_size, 0, GetBlockSize(block) - old_size);
+    else
+      memset((char*)data + alloc_size, 0, GetBlockSize(block) - alloc_size);
+    return data;
+  }
+  void* new_data = HeapAllocate(heap, alloc_size, alloc_align);
+  if (new_data == nullptr) return nullptr;
+  memcpy(new_data, data, old_size);
+  HeapFree(heap, data);
+  return new_data;
+}
+void HeapFree(HeapAllocator* heap, void* data) {
+  if (data == nullptr) return;
+  HeapBlock* block = GetPayloadBlock(data);
+  ASSERT(!IsBlockFree(block), "Heap block freed twice!");
+  heap->used_size -= GetBlockSize(block);
+  heap->allocation_count--;
+  // Merge with free neighbours
+  HeapBlock* prev = block->prev_physical;
+  if (prev != nullptr && IsBlockFree(prev)) {
+    RemoveFreeBlock(heap, prev);
+    prev->size += kHeapHeaderSize + GetBlockSize(block);
+    block = prev;
+  }
+  HeapBlock* next = GetNextBlock(block);
+  if (IsBlockFree(next)) {
+    RemoveFreeBlock(heap, next);
+    block->size += kHeapHeaderSize + GetBlockSize(next);
+    next = GetNextBlock(block);
+  }
+  next->prev_physical = block;
+  InsertFreeBlock(heap, block);
+}
+void GetHeapStats(HeapAllocator* heap, HeapStats* stats) {
+  *stats = {};
+  stats->size = heap->size;
+  stats->used_size = heap->used_size;
+  stats->peak_used_size = heap->peak_used_size;
+  stats->allocation_count = heap->allocation_count;
+  for (HeapBlock* block = heap->first; GetBlockSize(block) != 0;
+       block = GetNextBlock(block)) {
+    if (!IsBlockFree(block)) continue;
+    s64 block_size = GetBlockSize(block);
+    stats->free_size += block_size;
+    stats->free_block_count++;
+    if (block_size > stats->largest_free_size)
+      stats->largest_free_size = block_size;
+  }
+  if (stats->free_size > 0)
+    stats->fragmentation =
+        1.0f - (r32)stats->largest_free_size / (r32)stats->free_size;
+}
+bool CheckHeapAllocator(HeapAllocator* heap) {
+  u32 free_block_count = 0;
+  HeapBlock* prev = nullptr;
+  HeapBlock* block = heap->first;
+  for (; GetBlockSize(block) != 0; block = GetNextBlock(block)) {
+    if (block->prev_physical != prev) return true;
+    if ((char*)GetNextBlock(block) > heap->data + heap->size) return true;
+    if (IsBlockFree(block)) {
+      // Free neighbours are always merged
+      if (prev != nullptr && IsBlockFree(prev)) return true;
+      free_block_count++;
+    }
+    prev = block;
+  }
+  if (block->prev_physical != prev) return true;
+  u32 listed_count = 0;
+  for (u32 fl = 0; fl < kHeapFLCount; fl++) {
+    for (u32 sl = 0; sl < kHeapSLCount; sl++) {
+      bool listed = heap->free_lists[fl][sl] != nullptr;
+      if (listed != ((heap->sl_bitmaps[fl] >> sl) & 1)) return true;
+      for (HeapBlock* free_block = heap->free_lists[fl][sl];
+           free_block != nullptr; free_block = free_block->next_free) {
+        u32 block_fl, block_sl;
+        MapHeapSize(GetBlockSize(free_block), &block_fl, &block_sl);
+        if (!IsBlockFree(free_block) || block_fl != fl || block_sl != sl)
+          return true;
+        if (++listed_count > free_block_count) return true;
+      }
+    }
+    if ((heap->sl_bitmaps[fl] != 0) != ((heap->fl_bitmap >> fl) & 1))
+      return true;
+  }
+  return listed_count != free_block_count;
+}
+}  // namespace rally
\ No newline at end of file
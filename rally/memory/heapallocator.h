@@ -0,0 +1,60 @@
+#pragma once
+
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+#define HALLOC(heap, type, array_len) \
+  (type*)HeapAllocate((heap), sizeof(type) * (array_len), alignof(type))
+
+namespace rally {
+// Two-level segregated fit: first level splits sizes by power of two, second
+// level splits each power of two into kHeapSLCount linear classes
+constexpr u32 kHeapSLLog2 = 4;
+constexpr u32 kHeapSLCount = 1 << kHeapSLLog2;
+constexpr u32 kHeapFLCount = 32;
+constexpr s64 kHeapAlign = 16;
+// Blocks are a header followed by their payload. Free blocks keep their free
+// list links at the start of the payload.
+struct HeapBlock {
+  HeapBlock* prev_physical;
+  // Payload size, the low bit is set while the block is free
+  s64 size;
+  HeapBlock* next_free;
+  HeapBlock* prev_free;
+};
+// General purpose heap managing a sub-range of a parent StackAllocator, with
+// O(1) allocation and free. Not thread-safe.
+struct HeapAllocator {
+  char* data;
+  s64 size;
+  HeapBlock* first;
+  u32 fl_bitmap;
+  u32 sl_bitmaps[kHeapFLCount];
+  HeapBlock* free_lists[kHeapFLCount][kHeapSLCount];
+  s64 used_size;
+  s64 peak_used_size;
+  u32 allocation_count;
+};
+struct HeapStats {
+  s64 size;
+  s64 used_size;
+  s64 peak_used_size;
+  s64 free_size;
+  s64 largest_free_size;
+  u32 allocation_count;
+  u32 free_block_count;
+  // 0 when all free memory is one block, towards 1 as it splinters
+  r32 fragmentation;
+};
+HeapAllocator* CreateHeapAllocator(StackAllocator* parent, s64 heap_size);
+// Returns zeroed memory, or nullptr if no free block is large enough
+void* HeapAllocate(HeapAllocator* heap, s64 alloc_size, s64 alloc_align);
+// Grows in place when the following block is free, new memory is zeroed
+void* HeapReallocate(HeapAllocator* heap, void* data, s64 alloc_size,
+                     s64 alloc_align);
+void HeapFree(HeapAllocator* heap, void* data);
+// Walks every block, O(block count)
+void GetHeapStats(HeapAllocator* heap, HeapStats* stats);
+// Returns true if the block structure or free lists are inconsistent
+bool CheckHeapAllocator(HeapAllocator* heap);
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include <rally/dev/dev.h>
+#include <rally/memory/poolallocator.h>
+#include <string.h>
+
+namespace rally {
+static char* GetPoolSlot(PoolAllocator* pool, u32 slot_i) {
+  return pool->slots + pool->slot_stride * slot_i;
+}
+// Free slots store the next free index + 1 in their first bytes. Concurrent
+// pops may read a link that is being overwritten, the tagged CAS then fails.
+static std::atomic<u32>* GetPoolLink(PoolAllocator* pool, u32 slot_i) {
+  return (std::atomic<u32>*)GetPoolSlot(pool, slot_i);
+}
+static bool IsPoolPoisonIntact(PoolAllocator* pool, u32 slot_i) {
+  char* slot = GetPoolSlot(pool, slot_i);
+  for (s64 byte_i = sizeof(u32); byte_i < pool->slot_size; byte_i++)
+    if (slot[byte_i] != kPoolPoison) return false;
+  return true;
+}
+static bool IsPoolGuardIntact(PoolAllocator* pool, u32 slot_i) {
+  char* guard = GetPoolSlot(pool, slot_i) + pool->slot_size;
+  for (s64 byte_i = 0; byte_i < kPoolGuardSize; byte_i++)
+    if (guard[byte_i] != kPoolGuard) return false;
+  return true;
+}
+static void PushPoolSlot(PoolAllocator* pool, u32 slot_i) {
+  std::atomic<u32>* link = GetPoolLink(pool, slot_i);
+  u64 head = pool->free_head.load(std::memory_order_relaxed);
+  while (true) {
+    link->store((u32)head, std::memory_order_relaxed);
+    u64 new_head = (((head >> 32) + 1) << 32) | (slot_i + 1);
+    if (!pool->concurrent) {
+      pool->free_head.store(new_head, std::memory_order_relaxed);
+      return;
+    }
+    if (pool->free_head.compare_exchange_weak(head, new_head,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed))
+      return;
+  }
+}
+// Returns slot index + 1, 0 when the pool is exhausted
+static u32 PopPoolSlot(PoolAllocator* pool) {
+  u64 head = pool->free_head.load(std::memory_order_acquire);
+  while (true) {
+    u32 slot_id = (u32)head;
+    if (slot_id == 0) return 0;
+    u32 next = GetPoolLink(pool, slot_id - 1)->load(std::memory_order_relaxed);
+    u64 new_head = (((head >> 32) + 1) << 32) | next;
+    if (!pool->concurrent) {
+      pool->free_head.store(new_head, std::memory_order_relaxed);
+      return slot_id;
+    }
+    if (pool->free_head.compare_exchange_weak(head, new_head,
+                                              std::memory_order_acquire))
+      return slot_id;
+  }
+}
+PoolAllocator* CreatePoolAllocator(StackAllocator* parent,
+                                   PoolAllocatorCreateInfo* pool_ci) {
+  ASSERT(pool_ci->slot_count > 0, "Pool needs at least one slot!");
+  PoolAllocator* pool = SALLOCZ(parent, PoolAllocator, 1);
+  if (pool == nullptr) return nullptr;
+  s64 slot_align =
+      pool_ci->slot_align > alignof(u32) ? pool_ci->slot_align : alignof(u32);
+  // Free slots must hold a link
+  pool->slot_size =
+      pool_ci->slot_size > sizeof(u32) ? pool_ci->slot_size : sizeof(u32);
+  s64 stride = pool->slot_size;
+  if (pool_ci->debug_flags & kPoolDebugGuard) stride += kPoolGuardSize;
+  pool->slot_stride = (stride + slot_align - 1) / slot_align * slot_align;
+  pool->slot_count = pool_ci->slot_count;
+  pool->concurrent = pool_ci->concurrent;
+  pool->debug_flags = pool_ci->debug_flags;
+  // Parent alignment is relative to its base, align the address instead
+  char* slots = (char*)StackAllocate(
+      parent, pool->slot_stride * pool->slot_count + slot_align - 1, 1);
+  if (slots == nullptr) return nullptr;
+  uintptr_t slots_address = (uintptr_t)slots + slot_align - 1;
+  pool->slots = (char*)(slots_address - slots_address % slot_align);
+  pool->free_head.store(0);
+  pool->used_count.store(0);
+  // Push in reverse so slots are handed out in address order
+  for (u32 slot_i = pool->slot_count; slot_i > 0; slot_i--) {
+    char* slot = GetPoolSlot(pool, slot_i - 1);
+    if (pool->debug_flags & kPoolDebugPoison)
+      memset(slot, kPoolPoison, pool->slot_size);
+    if (pool->debug_flags & kPoolDebugGuard)
+      memset(slot + pool->slot_size, kPoolGuard, kPoolGuardSize);
+    PushPoolSlot(pool, slot_i - 1);
+  }
+  return pool;
+}
+void* PoolAllocate(PoolAllocator* pool) {
+  u32 slot_id = PopPoolSlot(pool);
+  if (slot_id == 0) return nullptr;
+  pool->used_count.fetch_add(1, std::memory_order_relaxed);
+  if (pool->debug_flags & kPoolDebugPoison)
+    ASSERT(IsPoolPoisonIntact(pool, slot_id - 1), "Pool slot used after free!");
+  char* slot = GetPoolSlot(pool, slot_id - 1);
+  memset(slot, 0, pool->slot_size);
+  return slot;
+}
+void PoolFree(PoolAllocator* pool, void* slot) {
+  if (slot == nullptr) return;
+  // Addresses are compared before subtracting, s64 offsets are unsigned
+  ASSERT((char*)slot >= pool->slots &&
+             (char*)slot < pool->slots + pool->slot_stride * pool->slot_count,
+         "Slot does not belong to this pool!");
+  s64 offset = (char*)slot - pool->slots;
+  ASSERT(offset % pool->slot_stride == 0, "Slot does not belong to this pool!");
+  u32 slot_i = (u32)(offset / pool->slot_stride);
+  if (pool->debug_flags & kPoolDebugGuard)
+    ASSERT(IsPoolGuardIntact(pool, slot_i), "Pool slot overrun!");
+  if (pool->debug_flags & kPoolDebugPoison)
+    memset(slot, kPoolPoison, pool->slot_size);
+  pool->used_count.fetch_sub(1, std::memory_order_relaxed);
+  PushPoolSlot(pool, slot_i);
+}
+bool CheckPoolAllocator(PoolAllocator* pool) {
+  if (pool->debug_flags & kPoolDebugGuard) {
+    for (u32 slot_i = 0; slot_i < pool->slot_count; slot_i++)
+      if (!IsPoolGuardIntact(pool, slot_i)) return true;
+  }
+  if (pool->debug_flags & kPoolDebugPoison) {
+    u32 slot_id = (u32)pool->free_head.load();
+    // A free list longer than the pool means an overwritten link
+    for (u32 free_i = 0; slot_id != 0; free_i++) {
+      if (free_i == pool->slot_count || slot_id > pool->slot_count) return true;
+      if (!IsPoolPoisonIntact(pool, slot_id - 1)) return true;
+      slot_id = GetPoolLink(pool, slot_id - 1)->load();
+    }
+  }
+  return false;
+}
+}  // namespace rally
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+#include <atomic>
+
+namespace rally {
+enum PoolDebugFlags : u32 {
+  // Fill freed slots with kPoolPoison and check it is intact on allocation
+  kPoolDebugPoison = 1,
+  // Follow every slot with kPoolGuardSize bytes checked on free
+  kPoolDebugGuard = 2,
+};
+constexpr char kPoolPoison = (char)0xDD;
+constexpr char kPoolGuard = (char)0xFD;
+constexpr s64 kPoolGuardSize = 16;
+struct PoolAllocatorCreateInfo {
+  s64 slot_size;
+  s64 slot_align;
+  u32 slot_count;
+  // Allow allocation and free from any number of threads
+  b32 concurrent;
+  u32 debug_flags;
+};
+// Fixed-size slots carved from a parent StackAllocator, free slots form an
+// intrusive list through their first bytes
+struct PoolAllocator {
+  char* slots;
+  s64 slot_size;
+  s64 slot_stride;
+  u32 slot_count;
+  b32 concurrent;
+  u32 debug_flags;
+  // Free list head, low half is slot index + 1 (0 when empty), high half is a
+  // tag bumped on every change so concurrent pops can't suffer from ABA
+  std::atomic<u64> free_head;
+  std::atomic<u32> used_count;
+};
+PoolAllocator* CreatePoolAllocator(StackAllocator* parent,
+                                   PoolAllocatorCreateInfo* pool_ci);
+// Returns zeroed memory, or nullptr when every slot is in use
+void* PoolAllocate(PoolAllocator* pool);
+void PoolFree(PoolAllocator* pool, void* slot);
+// Returns true if a guard or the poison of a free slot was overwritten. Not
+// safe to call while other threads allocate.
+bool CheckPoolAllocator(PoolAllocator* pool);
+}  // namespace rally
\ No newline at end of file
@@ -1,13 +1,99 @@
+#include <rally/dev/dev.h>
 #include <rally/memory/stackallocator.h>
+#include <rally/memory/virtualmemory.h>
+#include <stdio.h>
 #include <string.h>
 
 namespace rally {
-StackAllocator* CreateStackAllocator(void* data, s64 data_size) {
-  memset(data, 0, data_size);
+// Virtual arenas commit at least this much at a time
+constexpr s64 kMinCommitSize = Kilobytes(64);
+// Commit steps past occupied kept before freeing decommits, so a stack that
+// oscillates around a boundary doesn't commit and decommit every frame
+constexpr s64 kDecommitSteps = 4;
+#ifdef RALLY_MEMORY_TAGS
+// Tagged markers pack the previous occupied size, the tag and the padding of
+// their allocation so StackFree can attribute the freed bytes
+constexpr u32 kMarkerTagShift = 40;
+constexpr u32 kMarkerPaddingShift = 48;
+constexpr s64 kMarkerOccupiedMask = ((s64)1 << kMarkerTagShift) - 1;
+static s64 EncodeMarker(s64 occupied, MemoryTag tag, s64 padding) {
+  return occupied | ((s64)tag << kMarkerTagShift) |
+         (padding << kMarkerPaddingShift);
+}
+static void TrackAllocation(StackAllocator* stack_alloc, MemoryTag tag,
+                            s64 size, s64 padding) {
+  MemoryTagStats* stats = &stack_alloc->tag_stats[(u32)tag];
+  stats->size += size;
+  stats->padding += padding;
+  stats->allocation_count++;
+  if (stats->size > stats->peak_size) stats->peak_size = stats->size;
+  if (stack_alloc->occupied > stack_alloc->peak_occupied)
+    stack_alloc->peak_occupied = stack_alloc->occupied;
+}
+#endif
+static s64 RoundToCommit(StackAllocator* stack_alloc, s64 size) {
+  return (size + stack_alloc->commit_size - 1) / stack_alloc->commit_size *
+         stack_alloc->commit_size;
+}
+// Returns true if the OS could not back end_alloc bytes
+static bool GrowCommitted(StackAllocator* stack_alloc, s64 end_alloc) {
+  s64 committed = RoundToCommit(stack_alloc, end_alloc);
+  if (committed > stack_alloc->size) committed = stack_alloc->size;
+  if (CommitVirtualMemory((char*)stack_alloc->data + stack_alloc->committed,
+                          committed - stack_alloc->committed,
+                          stack_alloc->huge_pages))
+    return true;
+  stack_alloc->committed = committed;
+  return false;
+}
+static void ShrinkCommitted(StackAllocator* stack_alloc) {
+  s64 keep = RoundToCommit(stack_alloc, stack_alloc->occupied) +
+             stack_alloc->commit_size;
+  if (stack_alloc->committed < keep + kDecommitSteps * stack_alloc->commit_size)
+    return;
+  if (DecommitVirtualMemory((char*)stack_alloc->data + keep,
+                            stack_alloc->committed - keep))
+    return;
+  stack_alloc->committed = keep;
+  // Decommitted pages come back zeroed
+  if (stack_alloc->dirty > keep) stack_alloc->dirty = keep;
+}
+static StackAllocator* InitStackAllocator(void* data, s64 data_size,
+                                          s64 committed) {
+  // Only the header is cleared, the rest is zeroed on request
+  memset(data, 0, sizeof(StackAllocator));
   StackAllocator* alloc = (StackAllocator*)data;
   alloc->size = data_size;
   alloc->occupied = sizeof(StackAllocator);
   alloc->data = data;
+  alloc->committed = committed;
+  alloc->dirty = data_size;
+#ifdef RALLY_MEMORY_TAGS
+  ASSERT(data_size <= kMarkerOccupiedMask, "Too large for tagged markers!");
+  alloc->peak_occupied = alloc->occupied;
+#endif
+  return alloc;
+}
+StackAllocator* CreateStackAllocator(void* data, s64 data_size) {
+  return InitStackAllocator(data, data_size, data_size);
+}
+StackAllocator* CreateVirtualStackAllocator(s64 reserve_size, b32 huge_pages) {
+  s64 commit_size = GetVirtualPageSize(huge_pages);
+  if (commit_size < kMinCommitSize) commit_size = kMinCommitSize;
+  s64 size = (reserve_size + commit_size - 1) / commit_size * commit_size;
+  void* data = nullptr;
+  if (ReserveVirtualMemory(size, huge_pages, &data)) return nullptr;
+  // Fresh pages are zero, only the header needs backing
+  s64 committed =
+      (sizeof(StackAllocator) + commit_size - 1) / commit_size * commit_size;
+  if (CommitVirtualMemory(data, committed, huge_pages)) {
+    ReleaseVirtualMemory(data, size);
+    return nullptr;
+  }
+  StackAllocator* alloc = InitStackAllocator(data, size, committed);
+  alloc->commit_size = commit_size;
+  alloc->dirty = alloc->occupied;
+  alloc->huge_pages = huge_pages;
   return alloc;
 }
 void* StackAllocate(StackAllocator* stack_alloc, s64 alloc_size,
@@ -22,24 +108,137 @@ void* StackAllocateArray(StackAllocator* stack_alloc, s64 array_len,
   s64 mark_block = (end_data + alignof(s64) - 1) / alignof(s64);
   s64 mark = mark_block * alignof(s64);
   s64 end_alloc = mark + sizeof(s64);
-  if (end_alloc > stack_alloc->size) return nullptr;
+  if (end_alloc > stack_alloc->size) {
+#ifdef RALLY_MEMORY_TAGS
+    DEBUG_OUTPUT("Stack allocator exhausted!\n");
+    DumpMemoryTags(stack_alloc);
+#endif
+    return nullptr;
+  }
+  if (end_alloc > stack_alloc->committed &&
+      GrowCommitted(stack_alloc, end_alloc))
+    return nullptr;
   // Write marker
   s64* marker = (s64*)((char*)stack_alloc->data + mark);
+#ifdef RALLY_MEMORY_TAGS
+  s64 padding = (begin_alloc - stack_alloc->occupied) + (mark - end_data);
+  ASSERT(padding >> (64 - kMarkerPaddingShift) == 0,
+         "Alignment too large for tagged markers!");
+  *marker = EncodeMarker(stack_alloc->occupied, stack_alloc->tag, padding);
+  s64 old_occupied = stack_alloc->occupied;
+  stack_alloc->occupied = end_alloc;
+  TrackAllocation(stack_alloc, stack_alloc->tag, end_alloc - old_occupied,
+                  padding);
+#else
   *marker = stack_alloc->occupied;
   stack_alloc->occupied = end_alloc;
+#endif
+  if (end_alloc > stack_alloc->dirty) stack_alloc->dirty = end_alloc;
   return (char*)stack_alloc->data + begin_alloc;
 }
+void* StackAllocateZeroed(StackAllocator* stack_alloc, s64 alloc_size,
+                          s64 alloc_align) {
+  return StackAllocateArrayZeroed(stack_alloc, 1, alloc_size, alloc_align);
+}
+void* StackAllocateArrayZeroed(StackAllocator* stack_alloc, s64 array_len,
+                               s64 alloc_size, s64 alloc_align) {
+  s64 dirty = stack_alloc->dirty;
+  s64 begin = stack_alloc->occupied;
+  char* data = (char*)StackAllocateArray(stack_alloc, array_len, alloc_size,
+                                         alloc_align);
+  if (data == nullptr) return nullptr;
+  // Alignment padding is cleared with the data, so blocks built from zeroed
+  // allocations are reproducible byte for byte. Only the marker is left.
+  s64 end = stack_alloc->occupied - sizeof(s64);
+  if (end > dirty) end = dirty;
+  if (end > begin) memset((char*)stack_alloc->data + begin, 0, end - begin);
+  return data;
+}
 s64 StackFree(StackAllocator* stack_alloc) {
-  if (stack_alloc->occupied == 0) return 0;
+  if (stack_alloc->occupied <= sizeof(StackAllocator)) return 0;
   s64* mark =
       (s64*)((char*)stack_alloc->data + stack_alloc->occupied - sizeof(s64));
   s64 old_occupied = stack_alloc->occupied;
+#ifdef RALLY_MEMORY_TAGS
+  s64 marker = *mark;
+  stack_alloc->occupied = marker & kMarkerOccupiedMask;
+  u32 tag = (u32)((marker >> kMarkerTagShift) & 0xFF);
+  MemoryTagStats* stats = &stack_alloc->tag_stats[tag];
+  stats->size -= old_occupied - stack_alloc->occupied;
+  stats->padding -= marker >> kMarkerPaddingShift;
+  stats->allocation_count--;
+#else
   stack_alloc->occupied = *mark;
+#endif
   s64 free_size = old_occupied - stack_alloc->occupied;
-  memset((char*)stack_alloc->data + stack_alloc->occupied, 0, free_size);
+  if (stack_alloc->commit_size != 0) ShrinkCommitted(stack_alloc);
   return free_size;
 }
+void ResetStackAllocator(StackAllocator* stack_alloc) {
+  stack_alloc->occupied = sizeof(StackAllocator);
+  if (stack_alloc->commit_size != 0) ShrinkCommitted(stack_alloc);
+#ifdef RALLY_MEMORY_TAGS
+  // High-water marks outlive resets
+  for (u32 tag_i = 0; tag_i < kMemoryTagCount; tag_i++) {
+    stack_alloc->tag_stats[tag_i].size = 0;
+    stack_alloc->tag_stats[tag_i].padding = 0;
+    stack_alloc->tag_stats[tag_i].allocation_count = 0;
+  }
+#endif
+}
 void DestroyStackAllocator(StackAllocator* stack_alloc) {
-  // Do nothing, we don't manage our own mememory
+  // Fixed blocks belong to the caller
+  if (stack_alloc->commit_size != 0)
+    ReleaseVirtualMemory(stack_alloc->data, stack_alloc->size);
+}
+#ifdef RALLY_MEMORY_TAGS
+MemoryTag SetMemoryTag(StackAllocator* stack_alloc, MemoryTag tag) {
+  MemoryTag old_tag = stack_alloc->tag;
+  stack_alloc->tag = tag;
+  return old_tag;
+}
+bool GetMemoryTagStats(StackAllocator* stack_alloc, MemoryTag tag,
+                       MemoryTagStats* stats) {
+  *stats = stack_alloc->tag_stats[(u32)tag];
+  return false;
+}
+#else
+bool GetMemoryTagStats(StackAllocator*, MemoryTag, MemoryTagStats* stats) {
+  *stats = {};
+  return true;
+}
+#endif
+const char* GetMemoryTagName(MemoryTag tag) {
+  static const char* tag_names[kMemoryTagCount] = {
+      "untagged", "application", "heap",  "threadpool",
+      "scene",    "renderer",    "script"};
+  if ((u32)tag >= kMemoryTagCount) return "invalid";
+  return tag_names[(u32)tag];
+}
+void DumpMemoryTags(StackAllocator* stack_alloc) {
+#ifdef RALLY_MEMORY_TAGS
+  char line[160];
+  snprintf(line, sizeof(line), "%-12s %14s %14s %10s %8s\n", "tag", "size",
+           "peak", "padding", "count");
+  DEBUG_OUTPUT(line);
+  for (u32 tag_i = 0; tag_i < kMemoryTagCount; tag_i++) {
+    MemoryTagStats* stats = &stack_alloc->tag_stats[tag_i];
+    if (stats->peak_size == 0) continue;
+    snprintf(line, sizeof(line), "%-12s %14llu %14llu %10llu %8u\n",
+             GetMemoryTagName((MemoryTag)tag_i),
+             (unsigned long long)stats->size,
+             (unsigned long long)stats->peak_size,
+             (unsigned long long)stats->padding, stats->allocation_count);
+    DEBUG_OUTPUT(line);
+  }
+  snprintf(line, sizeof(line), "%-12s %14llu %14llu of %llu\n", "total",
+           (unsigned long long)stack_alloc->occupied,
+           (unsigned long long)stack_alloc->peak_occupied,
+           (unsigned long long)stack_alloc->size);
+  DEBUG_OUTPUT(line);
+#else
+  (void)stack_alloc;
+  DEBUG_OUTPUT("Memory tags are disabled in release builds\n");
+#endif
 }
 }  // namespace rally
\ No newline at end of file
@@ -4,18 +4,87 @@
 
 #define SALLOC(alloc, type, array_len) \
   (type*)StackAllocateArray((alloc), (array_len), sizeof(type), alignof(type))
+#define SALLOCZ(alloc, type, array_len)                                 \
+  (type*)StackAllocateArrayZeroed((alloc), (array_len), sizeof(type), \
+                                  alignof(type))
+
+// Per-tag usage is only tracked in debug builds
+#ifndef NDEBUG
+#define RALLY_MEMORY_TAGS
+#endif
 
 namespace rally {
+// Subsystem an allocation is attributed to
+enum class MemoryTag : u32 {
+  kUntagged = 0,
+  kApplication = 1,
+  kHeap = 2,
+  kThreadPool = 3,
+  kScene = 4,
+  kRenderer = 5,
+  kScript = 6,
+  kCount = 7,
+};
+constexpr u32 kMemoryTagCount = (u32)MemoryTag::kCount;
+struct MemoryTagStats {
+  // Bytes in use including padding and StackFree markers
+  s64 size;
+  s64 peak_size;
+  // Alignment padding within size
+  s64 padding;
+  u32 allocation_count;
+};
 struct StackAllocator {
   s64 size;
   s64 occupied;
   void* data;
+  // Bytes backed by memory, virtual arenas commit pages as occupied grows
+  s64 committed;
+  // Commit granularity, 0 for fixed blocks
+  s64 commit_size;
+  // Bytes past dirty were never written since they were backed and read as
+  // zero, equal to size for fixed blocks whose contents are unknown
+  s64 dirty;
+  b32 huge_pages;
+#ifdef RALLY_MEMORY_TAGS
+  MemoryTag tag;
+  s64 peak_occupied;
+  MemoryTagStats tag_stats[kMemoryTagCount];
+#endif
 };
 StackAllocator* CreateStackAllocator(void* data, s64 data_size);
+// Reserve reserve_size bytes of address space, pages are committed as they
+// are allocated and decommitted when enough is freed
+StackAllocator* CreateVirtualStackAllocator(s64 reserve_size, b32 huge_pages);
 void* StackAllocate(StackAllocator* stack_alloc, s64 alloc_size,
                     s64 alloc_align);
 void* StackAllocateArray(StackAllocator* stack_alloc, s64 array_len,
                          s64 alloc_size, s64 alloc_align);
+// Memory is not cleared, use the zeroed variants when relying on zero. They
+// also clear the alignment padding around the allocation, and only clear what
+// was written before, fresh virtual pages are left alone.
+void* StackAllocateZeroed(StackAllocator* stack_alloc, s64 alloc_size,
+                          s64 alloc_align);
+void* StackAllocateArrayZeroed(StackAllocator* stack_alloc, s64 array_len,
+                               s64 alloc_size, s64 alloc_align);
 s64 StackFree(StackAllocator* stack_alloc);
+// Free every allocation at once
+void ResetStackAllocator(StackAllocator* stack_alloc);
+// Releases the reservation of virtual arenas
 void DestroyStackAllocator(StackAllocator* stack_alloc);
+
+// Attribute following allocations to tag, returns the previous tag
+#ifdef RALLY_MEMORY_TAGS
+MemoryTag SetMemoryTag(StackAllocator* stack_alloc, MemoryTag tag);
+#else
+inline MemoryTag SetMemoryTag(StackAllocator*, MemoryTag) {
+  return MemoryTag::kUntagged;
+}
+#endif
+// Returns true if memory tags are compiled out
+bool GetMemoryTagStats(StackAllocator* stack_alloc, MemoryTag tag,
+                       MemoryTagStats* stats);
+const char* GetMemoryTagName(MemoryTag tag);
+// Write usage, high-water marks and padding per tag to the debug output
+void DumpMemoryTags(StackAllocator* stack_alloc);
 }  // namespace rally
\ No newline at end of file
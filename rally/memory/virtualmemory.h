@@ -0,0 +1,15 @@
+#pragma once
+#include <rally/types.h>
+
+namespace rally {
+// Granularity of commits, larger pages are committed in larger steps
+s64 GetVirtualPageSize(b32 huge_pages);
+// Reserve address space without backing memory, the base is aligned to the
+// page size
+bool ReserveVirtualMemory(s64 size, b32 huge_pages, void** out_data);
+// Back a page-aligned range of reserved memory, it reads as zero
+bool CommitVirtualMemory(void* data, s64 size, b32 huge_pages);
+// Return a page-aligned range to the OS, it stays reserved
+bool DecommitVirtualMemory(void* data, s64 size);
+void ReleaseVirtualMemory(void* data, s64 size);
+}  // namespace rally
\ No newline at end of file
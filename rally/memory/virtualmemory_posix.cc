@@ -0,0 +1,45 @@
+#include <rally/memory/virtualmemory.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rally {
+// Transparent huge pages on x86-64
+constexpr s64 kHugePageSize = Megabytes(2);
+s64 GetVirtualPageSize(b32 huge_pages) {
+  if (huge_pages) return kHugePageSize;
+  long page_size = sysconf(_SC_PAGESIZE);
+  return page_size > 0 ? (s64)page_size : Kilobytes(4);
+}
+bool ReserveVirtualMemory(s64 size, b32 huge_pages, void** out_data) {
+  s64 page_size = GetVirtualPageSize(huge_pages);
+  // Over-reserve so the base can be aligned to a huge page
+  s64 reserve_size = huge_pages ? size + page_size : size;
+  void* data = mmap(nullptr, reserve_size, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (data == MAP_FAILED) return true;
+  if (huge_pages) {
+    uintptr_t base = (uintptr_t)data;
+    uintptr_t aligned = (base + page_size - 1) / page_size * page_size;
+    if (aligned != base) munmap(data, aligned - base);
+    s64 tail = (s64)(base + reserve_size - (aligned + size));
+    if (tail > 0) munmap((char*)aligned + size, tail);
+    data = (void*)aligned;
+  }
+  *out_data = data;
+  return false;
+}
+bool CommitVirtualMemory(void* data, s64 size, b32 huge_pages) {
+  if (mprotect(data, size, PROT_READ | PROT_WRITE) != 0) return true;
+#ifdef MADV_HUGEPAGE
+  // Only a hint, regular pages are used when THP is disabled
+  if (huge_pages) madvise(data, size, MADV_HUGEPAGE);
+#endif
+  return false;
+}
+bool DecommitVirtualMemory(void* data, s64 size) {
+  // Private anonymous pages are zero-filled when touched again
+  if (madvise(data, size, MADV_DONTNEED) != 0) return true;
+  return mprotect(data, size, PROT_NONE) != 0;
+}
+void ReleaseVirtualMemory(void* data, s64 size) { munmap(data, size); }
+}  // namespace rally
\ No newline at end of file
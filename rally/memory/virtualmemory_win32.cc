@@ -0,0 +1,28 @@
+#include <rally/memory/virtualmemory.h>
+#include <windows.h>
+
+namespace rally {
+s64 GetVirtualPageSize(b32 huge_pages) {
+  // Large pages must be committed when reserved, which defeats lazy commits,
+  // so commits step by the allocation granularity instead
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  return huge_pages ? (s64)system_info.dwAllocationGranularity
+                    : (s64)system_info.dwPageSize;
+}
+bool ReserveVirtualMemory(s64 size, b32 huge_pages, void** out_data) {
+  void* data = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+  if (data == NULL) return true;
+  *out_data = data;
+  return false;
+}
+bool CommitVirtualMemory(void* data, s64 size, b32 huge_pages) {
+  return VirtualAlloc(data, size, MEM_COMMIT, PAGE_READWRITE) == NULL;
+}
+bool DecommitVirtualMemory(void* data, s64 size) {
+  return VirtualFree(data, size, MEM_DECOMMIT) == 0;
+}
+void ReleaseVirtualMemory(void* data, s64 size) {
+  VirtualFree(data, 0, MEM_RELEASE);
+}
+}  // namespace rally
\ No newline at end of file
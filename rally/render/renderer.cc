@@ -4,11 +4,15 @@
 #include <rally/math/geometry.h>
 #include <rally/render/renderer.h>
 #include <rally/render/shaders/shader.hlsl.h>
+#include <rally/thread/jobgraph.h>
 
 #ifndef NDEBUG
 #define RENDER_DEBUG
 #endif
 
+// Vertex streams, index and material buffers, registers t1 onwards
+constexpr u32 kGeometrySrvCount = kVertexStreamCount + 2;
+
 #define DXCHECK(hr)                    \
   do {                                 \
     if (FAILED(hr)) {                  \
@@ -115,7 +119,8 @@ static bool CreateFormatLibrary(Renderer* renderer) {
   renderer->format_library.swapchain = DXGI_FORMAT_R8G8B8A8_UNORM;
   renderer->format_library.depth = DXGI_FORMAT_D24_UNORM_S8_UINT;
   renderer->format_library.texture = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-  renderer->format_library.index = DXGI_FORMAT_R32_UINT;
+  renderer->format_library.index16 = DXGI_FORMAT_R16_UINT;
+  renderer->format_library.index32 = DXGI_FORMAT_R32_UINT;
   renderer->format_library.vertex_position = DXGI_FORMAT_R32G32B32_FLOAT;
   return false;
 }
@@ -204,7 +209,8 @@ static bool CreateRootSignatures(Renderer* renderer) {
     CD3DX12_DESCRIPTOR_RANGE uav_desc{};
     uav_desc.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
     CD3DX12_DESCRIPTOR_RANGE geometry_srv_desc{};
-    geometry_srv_desc.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 3, 1);
+    geometry_srv_desc.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, kGeometrySrvCount,
+                           1);
     CD3DX12_ROOT_PARAMETER root_params[3];
     root_params[0].InitAsDescriptorTable(1, &uav_desc);
     root_params[1].InitAsShaderResourceView(0);
@@ -230,7 +236,8 @@ static bool CreateRootSignatures(Renderer* renderer) {
     desc_range[0] =
         CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1);
     desc_range[1] =
-        CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 4);
+        CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1,
+                                 1 + kGeometrySrvCount);
     CD3DX12_ROOT_PARAMETER root_params[1];
     root_params[0].InitAsDescriptorTable(2, desc_range);
     CD3DX12_ROOT_SIGNATURE_DESC root_desc(1, root_params);
@@ -243,13 +250,14 @@ static bool CreateRootSignatures(Renderer* renderer) {
 
 // Create descriptor heap. Modify this when you need more resources
 // [0,Frame_Count) = Raytracing output UAVs
-// [Frame_Count,Frame_Count+3) = Geometry SRVs (Vertex,Index,Material)
-// [Frame_Count+3,Frame_Count*3+3) = Hitgroup DT (CBV, Instance SRV)
+// [Frame_Count,Frame_Count+6) = Geometry SRVs (Position,Normal,TangentFrame,Uv,
+// Index,Material)
+// [Frame_Count+6,Frame_Count*3+6) = Hitgroup DT (CBV, Instance SRV)
 static bool CreateDescriptorHeaps(Renderer* renderer) {
   // Create descriptor heap for CBV, SRV, UAV types
   D3D12_DESCRIPTOR_HEAP_DESC heap_desc{};
   heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-  heap_desc.NumDescriptors = renderer->frame_count * 3 + 3;
+  heap_desc.NumDescriptors = renderer->frame_count * 3 + kGeometrySrvCount;
   heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
   heap_desc.NodeMask = 0;
   HRESULT hr = renderer->device->CreateDescriptorHeap(
@@ -416,16 +424,28 @@ static bool CreateUavBuffer(Renderer* renderer, s64 data_size,
 }
 
 // TODO: Replace this with Device-Local Buffers
-// Create vertex, index and material buffers for the scene
+// Create vertex stream, index and material buffers for the scene
 static bool CreateGeometry(Application* app) {
   Renderer* renderer = app->renderer;
   Scene* scene = app->scene;
-  bool failed =
-      CreateUploadBuffer(renderer, scene->resources->vertices,
-                         scene->resources->vertex_count * sizeof(Vertex),
-                         &renderer->vertex_buffer);
+  // Vertex streams in shader register order, positions also feed the BLAS
+  const VertexStreams& vertices = scene->resources->vertices;
+  u32 vertex_count = scene->resources->vertex_count;
+  void* stream_data[kVertexStreamCount] = {vertices.positions, vertices.normals,
+                                           vertices.tangent_frames,
+                                           vertices.uvs};
+  u32 stream_strides[kVertexStreamCount] = {
+      sizeof(Float3), sizeof(OctNormal), sizeof(TangentFrame), sizeof(HalfUv)};
+  bool failed = false;
+  for (u32 stream_i = 0; stream_i < kVertexStreamCount; stream_i++) {
+    failed |= CreateUploadBuffer(renderer, stream_data[stream_i],
+                                 vertex_count * stream_strides[stream_i],
+                                 &renderer->vertex_streams[stream_i]);
+  }
+  // Raw views address whole 32-bit words
+  u32 index_words = (scene->resources->index_bytes + 3) / 4;
   failed |= CreateUploadBuffer(renderer, scene->resources->indices,
-                               scene->resources->index_count * sizeof(Index),
+                               index_words * sizeof(u32),
                                &renderer->index_buffer);
   failed |=
       CreateUploadBuffer(renderer, scene->resources->materials,
@@ -439,22 +459,23 @@ static bool CreateGeometry(Application* app) {
       renderer->descriptor_heap->GetCPUDescriptorHandleForHeapStart(),
       renderer->frame_count, heap_size);
 
-  // SRV for Vertex Buffer
+  // SRV for each Vertex Stream
   D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc{};
   srv_desc.Buffer.FirstElement = 0;
-  srv_desc.Buffer.NumElements = scene->resources->vertex_count;
-  srv_desc.Buffer.StructureByteStride = sizeof(Vertex);
+  srv_desc.Buffer.NumElements = vertex_count;
   srv_desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
   srv_desc.Format = DXGI_FORMAT_UNKNOWN;
   srv_desc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
   srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-  renderer->device->CreateShaderResourceView(renderer->vertex_buffer, &srv_desc,
-                                             cpu_handle);
-  cpu_handle.Offset(1, heap_size);
+  for (u32 stream_i = 0; stream_i < kVertexStreamCount; stream_i++) {
+    srv_desc.Buffer.StructureByteStride = stream_strides[stream_i];
+    renderer->device->CreateShaderResourceView(
+        renderer->vertex_streams[stream_i], &srv_desc, cpu_handle);
+    cpu_handle.Offset(1, heap_size);
+  }
 
   // SRV for Index Buffer
-  srv_desc.Buffer.NumElements = scene->resources->index_count;
+  srv_desc.Buffer.NumElements = index_words;
   srv_desc.Buffer.StructureByteStride = 0;
   srv_desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
   srv_desc.Format = DXGI_FORMAT_R32_TYPELESS;
@@ -482,7 +503,7 @@ static bool CreateHitgroupResources(Application* app) {
       D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
   CD3DX12_CPU_DESCRIPTOR_HANDLE cpu_handle(
       renderer->descriptor_heap->GetCPUDescriptorHandleForHeapStart(),
-      renderer->frame_count + 3, desc_size);
+      renderer->frame_count + kGeometrySrvCount, desc_size);
   for (u32 frame_i = 0; frame_i < renderer->frame_count; frame_i++) {
     failed |=
         CreateUploadBuffer(renderer, sizeof(HitGroupConstant),
@@ -553,14 +574,16 @@ static bool CreateAccelerationStructures(RendererJobParams* job_params) {
     geometry_desc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
     D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC tri_desc{};
     tri_desc.IndexBuffer = renderer->index_buffer->GetGPUVirtualAddress() +
-                           mesh.index_offset * sizeof(Index);
+                           mesh.index_offset;
     tri_desc.IndexCount = mesh.index_count;
-    tri_desc.IndexFormat = renderer->format_library.index;
+    tri_desc.IndexFormat = mesh.index_size == sizeof(u16)
+                               ? renderer->format_library.index16
+                               : renderer->format_library.index32;
     tri_desc.Transform3x4 = 0;
     tri_desc.VertexBuffer.StartAddress =
-        renderer->vertex_buffer->GetGPUVirtualAddress() +
-        mesh.vertex_offset * sizeof(Vertex);
-    tri_desc.VertexBuffer.StrideInBytes = sizeof(Vertex);
+        renderer->vertex_streams[0]->GetGPUVirtualAddress() +
+        mesh.vertex_offset * sizeof(Float3);
+    tri_desc.VertexBuffer.StrideInBytes = sizeof(Float3);
     tri_desc.VertexCount = mesh.vertex_count;
     tri_desc.VertexFormat = renderer->format_library.vertex_position;
     geometry_desc.Triangles = tri_desc;
@@ -755,7 +778,7 @@ static bool CreateShaderTableResources(RendererJobParams* job_params) {
     for (u32 frame_i = 0; frame_i < renderer->frame_count; frame_i++) {
       auto hitgroup_dt_handle = CD3DX12_GPU_DESCRIPTOR_HANDLE(
           renderer->descriptor_heap->GetGPUDescriptorHandleForHeapStart(),
-          renderer->frame_count + 3 + frame_i * 2,
+          renderer->frame_count + kGeometrySrvCount + frame_i * 2,
           renderer->device->GetDescriptorHandleIncrementSize(
               D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
       UINT shader_record_stride = shader_id_size + sizeof(hitgroup_dt_handle);
@@ -779,23 +802,45 @@ static bool CreateShaderTableResources(RendererJobParams* job_params) {
   return false;
 }
 
+struct InitialFrameParams {
+  Renderer* renderer;
+  RendererJobParams* job_params;
+  u32 job_count;
+  u32 frame_i;
+};
+
+// Begin the frame used during renderer creation, and share its index with the
+// command list jobs recorded into it
+static bool BeginInitialFrame(InitialFrameParams* frame_params) {
+  bool failed = BeginFrame(frame_params->renderer, &frame_params->frame_i);
+  for (u32 job_i = 0; job_i < frame_params->job_count; job_i++)
+    frame_params->job_params[job_i].frame_i = frame_params->frame_i;
+  return failed;
+}
+
 bool CreateRenderer(RendererCreateInfo* renderer_ci, Application* app) {
   // Allocate data
   // TODO: Move this to its own function?
-  app->renderer =
-      (Renderer*)StackAllocate(app->alloc, sizeof(Renderer), alignof(Renderer));
+  app->renderer = SALLOCZ(app->alloc, Renderer, 1);
   u32 mesh_count = app->scene->resources->mesh_count;
-  app->renderer->rt_blas = SALLOC(app->alloc, ID3D12Resource*, mesh_count);
+  app->renderer->rt_blas = SALLOCZ(app->alloc, ID3D12Resource*, mesh_count);
   app->renderer->rt_geometries =
-      SALLOC(app->alloc, D3D12_RAYTRACING_GEOMETRY_DESC, mesh_count);
-  app->renderer->rt_blas_inputs = SALLOC(
-      app->alloc, D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS, 1);
-  for (u32 frame_i = 0; frame_i < renderer_ci->frame_count; frame_i++) {
-    app->renderer->rt_instances[frame_i] = SALLOC(
-        app->alloc, D3D12_RAYTRACING_INSTANCE_DESC, (app->scene->max_entities));
-    app->renderer->instances[frame_i] =
-        SALLOC(app->alloc, Instance, (app->scene->max_entities));
-  }
+      SALLOCZ(app->alloc, D3D12_RAYTRACING_GEOMETRY_DESC, mesh_count);
+  app->renderer->rt_blas_inputs =
+      SALLOCZ(app->alloc, D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS,
+              mesh_count);
+  // Each frame holds a TLAS instance and a shader instance per entity, plus
+  // alignment padding and a marker per allocation
+  s64 instance_memory_size =
+      (s64)app->scene->max_entities *
+          (sizeof(D3D12_RAYTRACING_INSTANCE_DESC) + sizeof(Instance)) +
+      alignof(D3D12_RAYTRACING_INSTANCE_DESC) + alignof(Instance) +
+      4 * sizeof(s64);
+  s64 frame_memory_size = max(renderer_ci->frame_memory_size,
+                              instance_memory_size);
+  app->renderer->frame_alloc = CreateFrameAllocator(
+      app->alloc, renderer_ci->frame_count, frame_memory_size);
+  if (app->renderer->frame_alloc == nullptr) return true;
 
   Renderer* renderer = app->renderer;
   // Fill renderer details
@@ -834,60 +879,74 @@ bool CreateRenderer(RendererCreateInfo* renderer_ci, Application* app) {
   // Gather formats
   if (CreateFormatLibrary(renderer)) return true;
 
-  // Thread Pool to create resources
-  JobQueue* queue = app->threadpool->queue;
-  Job* jobs =
-      (Job*)StackAllocateArray(app->alloc, 10, sizeof(Job), alignof(Job));
-  jobs[0] = {(job_func)CreateCommandQueue, renderer};
-  jobs[1] = {(job_func)CreateCommandAllocators, renderer};
-  jobs[2] = {(job_func)CreateFences, renderer};
-  jobs[3] = {(job_func)CreateRootSignatures, renderer};
-  jobs[4] = {(job_func)CreateDescriptorHeaps, renderer};
-  PushJobs(queue, jobs, 5);
-  WaitThreadQueue(queue);
-  jobs[0] = {(job_func)CreateSwapchain, app};
-  jobs[1] = {(job_func)CreateCommandLists, renderer};
-  jobs[2] = {(job_func)CreateRaytracingOutputBuffers, renderer};
-  jobs[3] = {(job_func)CreateRaytracingPipeline, renderer};
-  PushJobs(queue, jobs, 4);
-  WaitThreadQueue(queue);
-  jobs[0] = {(job_func)CreateGeometry, app};
-  PushJobs(queue, jobs, 1);
-  WaitThreadQueue(queue);
-  jobs[0] = {(job_func)CreateHitgroupResources, app};
-  PushJobs(queue, jobs, 1);
-  WaitThreadQueue(queue);
-
-  // Begin a non-present frame for this
-  u32 frame_i = 0;
-  BeginFrame(renderer, &frame_i);
-
   // These operations require Command Lists
   // Examples: Transfer to GPU, Build Acceleration Structures, etc.
   // Allocate Params for them
+  u32 num_cmd_jobs = 2;
   RendererJobParams* job_params = (RendererJobParams*)StackAllocateArray(
-      app->alloc, renderer->thread_count, sizeof(RendererJobParams),
+      app->alloc, num_cmd_jobs, sizeof(RendererJobParams),
       alignof(RendererJobParams));
-  for (u32 thread_i = 0; thread_i < renderer->thread_count; thread_i++)
-    job_params[thread_i] = {app, frame_i, thread_i};
-
-  u32 num_jobs = 2;
-  jobs[0].callback = (job_func)CreateAccelerationStructures;
-  jobs[1].callback = (job_func)CreateShaderTableResources;
-
-  for (u32 job_i = 0; job_i < num_jobs; job_i += renderer->thread_count) {
-    u32 batch_size = (job_i + renderer->thread_count <= num_jobs)
-                         ? (renderer->thread_count)
-                         : (num_jobs - job_i);
-    for (u32 thread_i = 0; thread_i < batch_size; thread_i++)
-      jobs[job_i + thread_i].data = job_params + thread_i;
-    PushJobs(queue, jobs + job_i, batch_size);
-    WaitThreadQueue(queue);
-  }
-  EndFrame(renderer, frame_i, false);
-
+  if (job_params == nullptr) return true;
+  for (u32 job_i = 0; job_i < num_cmd_jobs; job_i++)
+    job_params[job_i] = {app, 0, job_i % renderer->thread_count};
+  InitialFrameParams frame_params = {renderer, job_params, num_cmd_jobs};
+
+  // Resource creation runs as a dependency graph on the thread pool, each job
+  // starts as soon as the resources it uses exist
+  JobGraph* graph = CreateJobGraph(app->alloc, 16);
+  if (graph == nullptr) return true;
+  JobNode* command_queue =
+      AddJobNode(graph, {(job_func)CreateCommandQueue, renderer});
+  JobNode* command_allocs =
+      AddJobNode(graph, {(job_func)CreateCommandAllocators, renderer});
+  JobNode* fences = AddJobNode(graph, {(job_func)CreateFences, renderer});
+  JobNode* root_signatures =
+      AddJobNode(graph, {(job_func)CreateRootSignatures, renderer});
+  JobNode* descriptor_heaps =
+      AddJobNode(graph, {(job_func)CreateDescriptorHeaps, renderer});
+  JobNode* swapchain = AddJobNode(graph, {(job_func)CreateSwapchain, app});
+  AddJobDependency(swapchain, command_queue);
+  JobNode* command_lists =
+      AddJobNode(graph, {(job_func)CreateCommandLists, renderer});
+  AddJobDependency(command_lists, command_allocs);
+  JobNode* output_buffers =
+      AddJobNode(graph, {(job_func)CreateRaytracingOutputBuffers, renderer});
+  AddJobDependency(output_buffers, descriptor_heaps);
+  JobNode* pipeline =
+      AddJobNode(graph, {(job_func)CreateRaytracingPipeline, renderer});
+  AddJobDependency(pipeline, root_signatures);
+  JobNode* geometry = AddJobNode(graph, {(job_func)CreateGeometry, app});
+  AddJobDependency(geometry, descriptor_heaps);
+  JobNode* hitgroup =
+      AddJobNode(graph, {(job_func)CreateHitgroupResources, app});
+  AddJobDependency(hitgroup, descriptor_heaps);
+
+  // Begin a non-present frame for command list work
+  JobNode* begin_frame =
+      AddJobNode(graph, {(job_func)BeginInitialFrame, &frame_params});
+  AddJobDependency(begin_frame, swapchain);
+  AddJobDependency(begin_frame, fences);
+  AddJobDependency(begin_frame, command_lists);
+  JobNode* acceleration_structures = AddJobNode(
+      graph, {(job_func)CreateAccelerationStructures, &job_params[0]});
+  AddJobDependency(acceleration_structures, begin_frame);
+  AddJobDependency(acceleration_structures, geometry);
+  JobNode* shader_tables = AddJobNode(
+      graph, {(job_func)CreateShaderTableResources, &job_params[1]});
+  AddJobDependency(shader_tables, begin_frame);
+  AddJobDependency(shader_tables, pipeline);
+  AddJobDependency(shader_tables, hitgroup);
+  // Jobs sharing a command list must not record at the same time
+  if (renderer->thread_count < num_cmd_jobs)
+    AddJobDependency(shader_tables, acceleration_structures);
+
+  bool failed = RunJobGraph(app->threadpool->queue, graph);
+  EndFrame(renderer, frame_params.frame_i, false);
+
+  DestroyJobGraph(graph);
+  // Free job params
   StackFree(app->alloc);
-  return false;
+  return failed;
 }
 
 bool BuildTlas(RendererJobParams* job_params) {
@@ -923,7 +982,7 @@ bool BuildTlas(RendererJobParams* job_params) {
     // Fill instance buffer
     renderer->instances[frame_i][entity_i] = {
         (i32)mesh.vertex_offset, (i32)mesh.index_offset,
-        (i32)app->scene->material_ids[entity_i]};
+        (i32)app->scene->material_ids[entity_i], (i32)mesh.index_size};
   }
 
   // Write to resource
@@ -965,6 +1024,20 @@ void UpdateRenderer(Application* app) {
   BeginFrame(renderer, &frame_i);
   ID3D12GraphicsCommandList6* cmd = renderer->command_lists[frame_i][0];
 
+  // Size instance data by the entities alive this frame
+  BeginAllocatorFrame(renderer->frame_alloc, frame_i);
+  u32 entity_count = app->scene->entity_count;
+  renderer->rt_instances[frame_i] =
+      FALLOC(renderer->frame_alloc, D3D12_RAYTRACING_INSTANCE_DESC,
+             entity_count);
+  renderer->instances[frame_i] =
+      FALLOC(renderer->frame_alloc, Instance, entity_count);
+  // Frames are sized for max_entities in CreateRenderer
+  ASSERT(entity_count <= app->scene->max_entities, "Too many entities!");
+  ASSERT(renderer->rt_instances[frame_i] != nullptr &&
+             renderer->instances[frame_i] != nullptr,
+         "Frame memory exhausted!");
+
   // Copy raygen constant buffer
   RaygenConstant raygen = {{-1.0f, 1.0f, 1.0f, -1.0f},
                            *(app->scene->main_camera)};
@@ -1087,7 +1160,8 @@ void DestroyRenderer(Application* app) {
     DXRELEASE(renderer->rt_output_buffers[frame_i]);
   }
 
-  DXRELEASE(renderer->vertex_buffer);
+  for (u32 stream_i = 0; stream_i < kVertexStreamCount; stream_i++)
+    DXRELEASE(renderer->vertex_streams[stream_i]);
   DXRELEASE(renderer->index_buffer);
   DXRELEASE(renderer->material_buffer);
 
@@ -3,6 +3,7 @@
 #include <dxgi1_4.h>
 #include <rally/application/application.h>
 #include <rally/math/geometry.h>
+#include <rally/memory/frameallocator.h>
 #include <rally/types.h>
 
 namespace rally {
@@ -10,6 +11,7 @@ struct Application;
 constexpr u32 kMaxFrameCount = 6;
 constexpr u32 kMaxRenderThreads = 2;
 constexpr u32 kMaxPointLights = 10;
+constexpr u32 kVertexStreamCount = 4;
 struct Viewport {
   float left;
   float top;
@@ -29,7 +31,8 @@ struct FormatLibrary {
   DXGI_FORMAT swapchain;
   DXGI_FORMAT depth;
   DXGI_FORMAT texture;
-  DXGI_FORMAT index;
+  DXGI_FORMAT index16;
+  DXGI_FORMAT index32;
   DXGI_FORMAT vertex_position;
 };
 struct Renderer {
@@ -71,7 +74,8 @@ struct Renderer {
   ID3D12RootSignature* raygen_local_signature;
   ID3D12RootSignature* hitgroup_local_signature;
 
-  // Scene instance data
+  // Scene instance data, reallocated from frame_alloc every frame
+  FrameAllocator* frame_alloc;
   D3D12_RAYTRACING_INSTANCE_DESC* rt_instances[kMaxFrameCount];
   Instance* instances[kMaxFrameCount];
 
@@ -80,7 +84,8 @@ struct Renderer {
   D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS* rt_blas_inputs;
 
   // Scene Data
-  ID3D12Resource* vertex_buffer;
+  // Positions, normals, tangent frames and uvs, positions feed the BLAS
+  ID3D12Resource* vertex_streams[kVertexStreamCount];
   ID3D12Resource* index_buffer;
   ID3D12Resource* material_buffer;
   ID3D12Resource* instance_buffer[kMaxFrameCount];
@@ -100,6 +105,9 @@ struct RendererCreateInfo {
   u32 height;
   u32 frame_count;
   u32 thread_count;
+  // Transient CPU memory per frame, raised to fit the instance data of
+  // scene->max_entities so the per-frame allocations cannot run out
+  s64 frame_memory_size;
 };
 bool CreateRenderer(RendererCreateInfo* renderer_ci, Application* app);
 void UpdateRenderer(Application* renderer);
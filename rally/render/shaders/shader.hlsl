@@ -24,20 +24,6 @@ struct RayGenConstantBuffer
     PerspectiveCamera camera;
 };
 
-struct Vertex
-{
-    float3 position;
-    float _pad0;
-    float3 normal;
-    float _pad1;
-    float3 tangent;
-    float _pad2;
-    float3 bitangent;
-    float _pad3;
-    float2 uv;
-    float2 _pad4;
-};
-
 struct Material
 {
     float3 albedo;
@@ -69,7 +55,7 @@ struct InstanceBuffer{
     int vertex_offset;
     int index_offset;
     int material_id;
-    int _pad;
+    int index_size;
 };
 
 // Global DXR descriptors
@@ -80,13 +66,20 @@ RWTexture2D<float4> RenderTarget : register(u0);
 ConstantBuffer<RayGenConstantBuffer> g_rayGenCB : register(b0);
 
 // Global Descriptor Table
-StructuredBuffer<Vertex> vertex_buffer: register(t1, space0);
-ByteAddressBuffer index_buffer : register(t2, space0);
-StructuredBuffer<Material> material_buffer : register(t3, space0);
+// One buffer per vertex stream, formats are in rally/math/packing.h
+StructuredBuffer<float3> position_buffer : register(t1, space0);
+// Octahedral snorm16x2 normals
+StructuredBuffer<uint> normal_buffer : register(t2, space0);
+// Snorm16x4 quaternion tangent frames
+StructuredBuffer<uint2> tangent_frame_buffer : register(t3, space0);
+// Half float uvs
+StructuredBuffer<uint> uv_buffer : register(t4, space0);
+ByteAddressBuffer index_buffer : register(t5, space0);
+StructuredBuffer<Material> material_buffer : register(t6, space0);
 
 // Local Hit Group Descriptor Table
 ConstantBuffer<HitGroupConstantBuffer> hitgroup_cb : register(b1);
-StructuredBuffer<InstanceBuffer> instance_buffer : register(t4, space0);
+StructuredBuffer<InstanceBuffer> instance_buffer : register(t7, space0);
 
 typedef BuiltInTriangleIntersectionAttributes BarycentricAttributes;
 struct CameraRayPayload
@@ -136,6 +129,55 @@ float3 InterpolateFloat3(in float3 a0, in float3 a1, in float3 a2, in float2 bar
     return a0+barycentrics.x*(a1-a0)+barycentrics.y*(a2-a0);
 }
 
+float2 DecodeSnorm16x2(in uint packed){
+    int2 q = int2((int)(packed << 16) >> 16, (int)packed >> 16);
+    return max(float2(q) / 32767.0f, -1.0f);
+}
+
+float3 DecodeOctNormal(in uint packed){
+    float2 f = DecodeSnorm16x2(packed);
+    float3 n = float3(f.x, f.y, 1.0f - abs(f.x) - abs(f.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+// Columns of the quaternion's rotation, the sign of w flips the bitangent
+void DecodeTangentFrame(in uint2 packed, out float3 normal, out float3 tangent,
+                        out float3 bitangent){
+    float4 q = float4(DecodeSnorm16x2(packed.x), DecodeSnorm16x2(packed.y));
+    float handedness = q.w < 0.0f ? -1.0f : 1.0f;
+    q = normalize(q);
+    tangent = float3(1.0f - 2.0f * (q.y * q.y + q.z * q.z),
+                     2.0f * (q.x * q.y + q.w * q.z),
+                     2.0f * (q.x * q.z - q.w * q.y));
+    bitangent = handedness * float3(2.0f * (q.x * q.y - q.w * q.z),
+                                    1.0f - 2.0f * (q.x * q.x + q.z * q.z),
+                                    2.0f * (q.y * q.z + q.w * q.x));
+    normal = float3(2.0f * (q.x * q.z + q.w * q.y),
+                    2.0f * (q.y * q.z - q.w * q.x),
+                    1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+}
+
+float2 DecodeHalfUv(in uint packed){
+    return f16tof32(uint2(packed & 0xffff, packed >> 16));
+}
+
+// Indices of triangle pidx, index_offset is in bytes
+uint3 LoadIndices(in uint index_offset, in uint index_size, in uint pidx){
+    if(index_size == 2){
+        // 16-bit triangles straddle 32-bit words, load both and pick halves
+        uint byte_offset = index_offset+pidx*6;
+        uint aligned_offset = byte_offset & ~3;
+        uint2 words = index_buffer.Load2(aligned_offset);
+        if(byte_offset == aligned_offset)
+            return uint3(words.x & 0xffff, words.x >> 16, words.y & 0xffff);
+        return uint3(words.x >> 16, words.y & 0xffff, words.y >> 16);
+    }
+    return index_buffer.Load3(index_offset+pidx*12);
+}
+
 float3 GetWorldPos(){
     return WorldRayOrigin()+WorldRayDirection()*RayTCurrent();
 }
@@ -147,13 +189,14 @@ float3 ComputeRadiance(in BarycentricAttributes attr, in bool recurse){
 
     float3 barycentrics = float3(1 - attr.barycentrics.x - attr.barycentrics.y, attr.barycentrics.x, attr.barycentrics.y);
     uint pidx = PrimitiveIndex();
-    uint3 idx = index_buffer.Load3((pidx*3+index_offset)*4);
+    int index_size = instance_buffer[instance_id].index_size;
+    uint3 idx = LoadIndices(index_offset, index_size, pidx);
     idx += vertex_offset;
     
     // Get normal
-    float3 n0 = vertex_buffer[idx.x].normal;
-    float3 n1 = vertex_buffer[idx.y].normal;
-    float3 n2 = vertex_buffer[idx.z].normal;
+    float3 n0 = DecodeOctNormal(normal_buffer[idx.x]);
+    float3 n1 = DecodeOctNormal(normal_buffer[idx.y]);
+    float3 n2 = DecodeOctNormal(normal_buffer[idx.z]);
     float3 ni = InterpolateFloat3(n0,n1,n2,attr.barycentrics);
     float3 world_normal = mul(ObjectToWorld3x4(),float4(ni,0.0f));
 
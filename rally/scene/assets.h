@@ -5,7 +5,10 @@ namespace rally{
 struct Mesh{
   u32 vertex_offset;
   u32 vertex_count;
+  // Byte offset into the scene index buffer, aligned to index_size
   u32 index_offset;
   u32 index_count;
+  // 2 for meshes with at most 65536 vertices, 4 otherwise
+  u32 index_size;
 };
 }
\ No newline at end of file
@@ -31,8 +31,11 @@ bool ImportScene(Application* app) {
   FIXUP_POINT(sp->resources, sp, SceneResources);
   SceneResources* sr = sp->resources;
   FIXUP_POINT(sr->meshes, sp, Mesh);
-  FIXUP_POINT(sr->vertices, sp, Vertex);
-  FIXUP_POINT(sr->indices, sp, Index);
+  FIXUP_POINT(sr->vertices.positions, sp, Float3);
+  FIXUP_POINT(sr->vertices.normals, sp, OctNormal);
+  FIXUP_POINT(sr->vertices.tangent_frames, sp, TangentFrame);
+  FIXUP_POINT(sr->vertices.uvs, sp, HalfUv);
+  FIXUP_POINT(sr->indices, sp, char);
   FIXUP_POINT(sr->materials, sp, Material);
 
   return false;
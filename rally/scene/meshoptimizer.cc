@@ -0,0 +1,164 @@
+#include <rally/dev/dev.h>
+#include <rally/scene/meshoptimizer.h>
+#include <string.h>
+
+namespace rally {
+constexpr u32 kUnusedVertex = ~0u;
+
+bool AnalyzeVertexCache(StackAllocator* temp_alloc, const u32* indices,
+                        u32 index_count, u32 vertex_count, u32 cache_size,
+                        VertexCacheStats* out_stats) {
+  // Miss count when each vertex was last loaded, 0 if never
+  u32* loaded_at = SALLOC(temp_alloc, u32, vertex_count);
+  if (loaded_at == nullptr) return true;
+  memset(loaded_at, 0, vertex_count * sizeof(u32));
+  u32 misses = 0;
+  for (u32 index_i = 0; index_i < index_count; index_i++) {
+    u32 vert_i = indices[index_i];
+    // FIFO holds the last cache_size missed vertices
+    if (loaded_at[vert_i] != 0 && misses - loaded_at[vert_i] < cache_size)
+      continue;
+    loaded_at[vert_i] = ++misses;
+  }
+  u32 used_count = 0;
+  for (u32 vert_i = 0; vert_i < vertex_count; vert_i++)
+    used_count += loaded_at[vert_i] != 0;
+  StackFree(temp_alloc);
+  u32 triangle_count = index_count / 3;
+  out_stats->acmr = triangle_count > 0 ? (r32)misses / triangle_count : 0.0f;
+  out_stats->atvr = used_count > 0 ? (r32)misses / used_count : 0.0f;
+  return false;
+}
+
+bool OptimizeVertexCache(StackAllocator* temp_alloc, u32* indices,
+                         u32 index_count, u32 vertex_count, u32 cache_size) {
+  ASSERT(index_count % 3 == 0, "Indices must form a triangle list!");
+  u32 triangle_count = index_count / 3;
+  if (triangle_count == 0 || vertex_count == 0) return false;
+  // One block for every temporary, freed together
+  s64 block_size = ((s64)(vertex_count + 1) + 2 * vertex_count +
+                    3 * (s64)index_count) * sizeof(u32) +
+                   triangle_count;
+  char* block = (char*)StackAllocate(temp_alloc, block_size, alignof(u32));
+  if (block == nullptr) return true;
+  // Vertex to triangle adjacency, triangles of vertex v are
+  // adjacency[adjacency_offsets[v], adjacency_offsets[v+1])
+  u32* adjacency_offsets = (u32*)block;
+  u32* live_counts = adjacency_offsets + vertex_count + 1;
+  u32* cache_times = live_counts + vertex_count;
+  u32* adjacency = cache_times + vertex_count;
+  u32* dead_ends = adjacency + index_count;
+  u32* output = dead_ends + index_count;
+  char* emitted = (char*)(output + index_count);
+  memset(block, 0, block_size);
+
+  for (u32 index_i = 0; index_i < index_count; index_i++)
+    live_counts[indices[index_i]]++;
+  for (u32 vert_i = 0; vert_i < vertex_count; vert_i++) {
+    adjacency_offsets[vert_i + 1] =
+        adjacency_offsets[vert_i] + live_counts[vert_i];
+    // Fill cursor, cleared again below
+    cache_times[vert_i] = adjacency_offsets[vert_i];
+  }
+  for (u32 index_i = 0; index_i < index_count; index_i++)
+    adjacency[cache_times[indices[index_i]]++] = index_i / 3;
+  memset(cache_times, 0, vertex_count * sizeof(u32));
+
+  u32 output_count = 0;
+  u32 dead_end_count = 0;
+  u32 timestamp = cache_size + 1;
+  u32 scan_i = 0;
+  i64 fan_vertex = 0;
+  while (fan_vertex >= 0) {
+    // Emit every remaining triangle around the fanning vertex, their
+    // vertices are the candidates for the next one
+    u32 candidates_begin = output_count;
+    for (u32 adjacent_i = adjacency_offsets[fan_vertex];
+         adjacent_i < adjacency_offsets[fan_vertex + 1]; adjacent_i++) {
+      u32 triangle_i = adjacency[adjacent_i];
+      if (emitted[triangle_i]) continue;
+      for (u32 corner_i = 0; corner_i < 3; corner_i++) {
+        u32 vert_i = indices[triangle_i * 3 + corner_i];
+        output[output_count++] = vert_i;
+        dead_ends[dead_end_count++] = vert_i;
+        live_counts[vert_i]--;
+        if (timestamp - cache_times[vert_i] > cache_size)
+          cache_times[vert_i] = timestamp++;
+      }
+      emitted[triangle_i] = 1;
+    }
+
+    // Prefer the oldest candidate that will still be cached after its
+    // remaining triangles are emitted
+    fan_vertex = -1;
+    i64 best_priority = -1;
+    for (u32 output_i = candidates_begin; output_i < output_count;
+         output_i++) {
+      u32 vert_i = output[output_i];
+      if (live_counts[vert_i] == 0) continue;
+      i64 priority = 0;
+      u32 age = timestamp - cache_times[vert_i];
+      if (age + 2 * live_counts[vert_i] <= cache_size) priority = age;
+      if (priority > best_priority) {
+        best_priority = priority;
+        fan_vertex = vert_i;
+      }
+    }
+    // Dead end: back up to a recently used vertex, then fall back to a scan
+    while (fan_vertex < 0 && dead_end_count > 0) {
+      u32 vert_i = dead_ends[--dead_end_count];
+      if (live_counts[vert_i] > 0) fan_vertex = vert_i;
+    }
+    for (; fan_vertex < 0 && scan_i < vertex_count; scan_i++) {
+      if (live_counts[scan_i] > 0) fan_vertex = scan_i;
+    }
+  }
+  ASSERT(output_count == index_count, "Triangles were dropped!");
+  memcpy(indices, output, index_count * sizeof(u32));
+  StackFree(temp_alloc);
+  return false;
+}
+
+template <typename T>
+static void PermuteStream(T* stream, const u32* remap, u32 vertex_count,
+                          void* scratch) {
+  memcpy(scratch, stream, vertex_count * sizeof(T));
+  const T* source = (const T*)scratch;
+  for (u32 vert_i = 0; vert_i < vertex_count; vert_i++) {
+    if (remap[vert_i] != kUnusedVertex) stream[remap[vert_i]] = source[vert_i];
+  }
+}
+bool OptimizeVertexFetch(StackAllocator* temp_alloc, VertexStreams* streams,
+                         u32 vertex_offset, u32 vertex_count, u32* indices,
+                         u32 index_count, u32* out_vertex_count) {
+  *out_vertex_count = 0;
+  if (vertex_count == 0) return false;
+  u32* remap = SALLOC(temp_alloc, u32, vertex_count);
+  if (remap == nullptr) return true;
+  // Sized for the widest stream
+  void* scratch = StackAllocate(temp_alloc, vertex_count * sizeof(Float3),
+                                alignof(Float3));
+  if (scratch == nullptr) {
+    StackFree(temp_alloc);
+    return true;
+  }
+  memset(remap, 0xff, vertex_count * sizeof(u32));
+  u32 used_count = 0;
+  for (u32 index_i = 0; index_i < index_count; index_i++) {
+    u32 vert_i = indices[index_i];
+    if (remap[vert_i] == kUnusedVertex) remap[vert_i] = used_count++;
+    indices[index_i] = remap[vert_i];
+  }
+  PermuteStream(streams->positions + vertex_offset, remap, vertex_count,
+                scratch);
+  PermuteStream(streams->normals + vertex_offset, remap, vertex_count,
+                scratch);
+  PermuteStream(streams->tangent_frames + vertex_offset, remap, vertex_count,
+                scratch);
+  PermuteStream(streams->uvs + vertex_offset, remap, vertex_count, scratch);
+  StackFree(temp_alloc);
+  StackFree(temp_alloc);
+  *out_vertex_count = used_count;
+  return false;
+}
+}  // namespace rally
\ No newline at end of file
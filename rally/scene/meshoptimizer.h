@@ -0,0 +1,35 @@
+#pragma once
+#include <rally/math/geometry.h>
+#include <rally/memory/stackallocator.h>
+#include <rally/types.h>
+
+namespace rally {
+// Entries in the simulated post-transform FIFO cache
+constexpr u32 kVertexCacheSize = 16;
+
+struct VertexCacheStats {
+  // Average cache miss ratio, transformed vertices per triangle
+  r32 acmr;
+  // Average transform to vertex ratio, 1 is optimal
+  r32 atvr;
+};
+// Simulate a FIFO cache of cache_size over a triangle list, indices are
+// below vertex_count. Returns true if temp_alloc is out of memory.
+bool AnalyzeVertexCache(StackAllocator* temp_alloc, const u32* indices,
+                        u32 index_count, u32 vertex_count, u32 cache_size,
+                        VertexCacheStats* out_stats);
+
+// Reorder triangles in place for post-transform cache locality with Tipsify
+// (Sander, Nehab and Barczak 2007). Triangle winding is kept. Returns true if
+// temp_alloc is out of memory.
+bool OptimizeVertexCache(StackAllocator* temp_alloc, u32* indices,
+                         u32 index_count, u32 vertex_count, u32 cache_size);
+
+// Renumber vertices in [vertex_offset, vertex_offset+vertex_count) in order
+// of first use, permuting the streams and rewriting indices to match.
+// Unreferenced vertices are dropped and out_vertex_count receives the new
+// vertex count. Returns true if temp_alloc is out of memory.
+bool OptimizeVertexFetch(StackAllocator* temp_alloc, VertexStreams* streams,
+                         u32 vertex_offset, u32 vertex_count, u32* indices,
+                         u32 index_count, u32* out_vertex_count);
+}  // namespace rally
\ No newline at end of file
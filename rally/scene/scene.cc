@@ -1,28 +1,134 @@
+#include <float.h>
+#include <rally/container/hashmap.h>
 #include <rally/scene/scene.h>
+#include <string.h>
 
 namespace rally {
 bool CreateScene(SceneCreateInfo* scene_ci, Application* application) {
-  application->scene = SALLOC(application->alloc, Scene, 1);
+  application->scene = SALLOCZ(application->alloc, Scene, 1);
   Scene* scene = application->scene;
 
   scene->max_entities = scene_ci->max_entities;
   scene->max_lights = scene_ci->max_lights;
-  scene->transforms = SALLOC(application->alloc, Mat4, scene->max_entities);
-  scene->entities = SALLOC(application->alloc, u32, scene->max_entities);
-  scene->material_ids = SALLOC(application->alloc, u32, scene->max_entities);
-  scene->lights = SALLOC(application->alloc, PointLight, scene->max_lights);
-  scene->main_camera = SALLOC(application->alloc, PerspectiveCamera, 1);
+  // Zeroed, the asset exporter writes whole scenes including unused tails
+  scene->transforms = SALLOCZ(application->alloc, Mat4, scene->max_entities);
+  scene->entities = SALLOCZ(application->alloc, u32, scene->max_entities);
+  scene->material_ids = SALLOCZ(application->alloc, u32, scene->max_entities);
+  scene->lights = SALLOCZ(application->alloc, PointLight, scene->max_lights);
+  scene->main_camera = SALLOCZ(application->alloc, PerspectiveCamera, 1);
 
-  scene->resources = SALLOC(application->alloc, SceneResources, 1);
+  scene->resources = SALLOCZ(application->alloc, SceneResources, 1);
   SceneResources* res = scene->resources;
   res->max_meshes = scene_ci->max_meshes;
   res->max_vertices = scene_ci->max_vertices;
-  res->max_indices = scene_ci->max_indices;
+  res->max_index_bytes = scene_ci->max_index_bytes;
   res->max_materials = scene_ci->max_materials;
-  res->meshes = SALLOC(application->alloc, Mesh, res->max_meshes);
-  res->vertices = SALLOC(application->alloc, Vertex, res->max_vertices);
-  res->indices = SALLOC(application->alloc, Index, res->max_indices);
-  res->materials = SALLOC(application->alloc, Material, res->max_materials);
+  res->meshes = SALLOCZ(application->alloc, Mesh, res->max_meshes);
+  VertexStreams& vertices = res->vertices;
+  vertices.positions = SALLOCZ(application->alloc, Float3, res->max_vertices);
+  vertices.normals = SALLOCZ(application->alloc, OctNormal, res->max_vertices);
+  vertices.tangent_frames =
+      SALLOCZ(application->alloc, TangentFrame, res->max_vertices);
+  vertices.uvs = SALLOCZ(application->alloc, HalfUv, res->max_vertices);
+  res->indices = (char*)StackAllocateZeroed(
+      application->alloc, res->max_index_bytes, alignof(u32));
+  res->materials = SALLOCZ(application->alloc, Material, res->max_materials);
+  return false;
+}
+Bounds ComputeMeshBounds(const SceneResources* resources, const Mesh& mesh) {
+  const Float3* positions = resources->vertices.positions + mesh.vertex_offset;
+  __m128 lo = _mm_set1_ps(FLT_MAX);
+  __m128 hi = _mm_set1_ps(-FLT_MAX);
+  if (mesh.vertex_count > 0) {
+    // 16-byte loads read one float into the next vertex, so the last vertex
+    // is loaded separately
+    u32 last_i = mesh.vertex_count - 1;
+    for (u32 vert_i = 0; vert_i < last_i; vert_i++) {
+      __m128 p = _mm_loadu_ps(&positions[vert_i].x);
+      lo = _mm_min_ps(lo, p);
+      hi = _mm_max_ps(hi, p);
+    }
+    const Float3& last = positions[last_i];
+    __m128 p = _mm_setr_ps(last.x, last.y, last.z, 0.0f);
+    lo = _mm_min_ps(lo, p);
+    hi = _mm_max_ps(hi, p);
+  }
+  alignas(16) r32 lo_out[4], hi_out[4];
+  _mm_store_ps(lo_out, lo);
+  _mm_store_ps(hi_out, hi);
+  return {{lo_out[0], lo_out[1], lo_out[2]}, {hi_out[0], hi_out[1], hi_out[2]}};
+}
+
+// Every encoded attribute of a vertex, compared bitwise
+struct WeldKey {
+  Float3 position;
+  OctNormal normal;
+  TangentFrame tangent_frame;
+  HalfUv uv;
+  bool operator==(const WeldKey& other) const {
+    return memcmp(this, &other, sizeof(WeldKey)) == 0;
+  }
+};
+static_assert(sizeof(WeldKey) == 28, "WeldKey must not contain padding");
+static u64 HashKey(const WeldKey& key) {
+  u32 words[sizeof(WeldKey) / sizeof(u32)];
+  memcpy(words, &key, sizeof(words));
+  u64 hash = 0;
+  for (u32 word : words) hash = rally::HashKey(hash ^ word);
+  return hash;
+}
+bool WeldVertices(StackAllocator* temp_alloc, VertexStreams* streams,
+                  u32 vertex_offset, u32 vertex_count, u32* out_remap,
+                  u32* out_welded_count) {
+  HashMap<WeldKey, u32> welded;
+  if (CreateHashMap(temp_alloc, vertex_count, &welded)) return true;
+  Float3* positions = streams->positions + vertex_offset;
+  OctNormal* normals = streams->normals + vertex_offset;
+  TangentFrame* tangent_frames = streams->tangent_frames + vertex_offset;
+  HalfUv* uvs = streams->uvs + vertex_offset;
+  u32 welded_count = 0;
+  for (u32 vert_i = 0; vert_i < vertex_count; vert_i++) {
+    WeldKey key{positions[vert_i], normals[vert_i], tangent_frames[vert_i],
+                uvs[vert_i]};
+    u32* existing = FindHashMap(&welded, key);
+    if (existing != nullptr) {
+      out_remap[vert_i] = *existing;
+      continue;
+    }
+    // Welded index never exceeds vert_i, so compacting in place is safe
+    u32 welded_i = welded_count++;
+    InsertHashMap(&welded, key, welded_i);
+    positions[welded_i] = key.position;
+    normals[welded_i] = key.normal;
+    tangent_frames[welded_i] = key.tangent_frame;
+    uvs[welded_i] = key.uv;
+    out_remap[vert_i] = welded_i;
+  }
+  StackFree(temp_alloc);
+  *out_welded_count = welded_count;
+  return false;
+}
+
+bool AppendMeshIndices(SceneResources* resources, Mesh* mesh,
+                       const u32* indices, u32 index_count) {
+  u32 index_size = mesh->vertex_count <= 65536 ? sizeof(u16) : sizeof(u32);
+  // GPUs require index buffers aligned to their index size
+  u32 index_offset =
+      (resources->index_bytes + index_size - 1) & ~(index_size - 1);
+  if (index_offset + index_count * index_size > resources->max_index_bytes)
+    return true;
+  char* dst = resources->indices + index_offset;
+  for (u32 index_i = 0; index_i < index_count; index_i++) {
+    ASSERT(indices[index_i] < mesh->vertex_count, "Index out of range!");
+    if (index_size == sizeof(u16))
+      ((u16*)dst)[index_i] = (u16)indices[index_i];
+    else
+      ((u32*)dst)[index_i] = indices[index_i];
+  }
+  mesh->index_offset = index_offset;
+  mesh->index_count = index_count;
+  mesh->index_size = index_size;
+  resources->index_bytes = index_offset + index_count * index_size;
   return false;
 }
 }  // namespace rally
\ No newline at end of file
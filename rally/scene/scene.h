@@ -4,19 +4,21 @@
 #include <rally/types.h>
 
 namespace rally {
+struct Application;
 struct PerspectiveCamera;
 struct SceneResources {
   Mesh* meshes;
   u32 mesh_count;
   u32 max_meshes;
 
-  Vertex* vertices;
+  VertexStreams vertices;
   u32 vertex_count;
   u32 max_vertices;
 
-  Index* indices;
-  u32 index_count;
-  u32 max_indices;
+  // 16 and 32-bit indices, see Mesh::index_size
+  char* indices;
+  u32 index_bytes;
+  u32 max_index_bytes;
 
   Material* materials;
   u32 material_count;
@@ -39,11 +41,33 @@ struct SceneCreateInfo {
   u32 max_lights;
   u32 max_meshes;
   u32 max_vertices;
-  u32 max_indices;
+  u32 max_index_bytes;
   u32 max_materials;
 };
 struct SceneImportInfo {
   b32 import_scene;
 };
 bool CreateScene(SceneCreateInfo* scene_ci, Application* application);
+// Object space bounds of a mesh, reads only the position stream
+Bounds ComputeMeshBounds(const SceneResources* resources, const Mesh& mesh);
+// Merge vertices in [vertex_offset, vertex_offset+vertex_count) whose encoded
+// attributes are bit-identical. The streams are compacted in place,
+// out_remap receives the welded index of every input vertex and
+// out_welded_count the welded vertex count. Returns true if temp_alloc is out
+// of memory.
+bool WeldVertices(StackAllocator* temp_alloc, VertexStreams* streams,
+                  u32 vertex_offset, u32 vertex_count, u32* out_remap,
+                  u32* out_welded_count);
+// Append indices relative to mesh->vertex_offset, sized by
+// mesh->vertex_count. Fills the index fields of mesh, returns true if the
+// index buffer is full.
+bool AppendMeshIndices(SceneResources* resources, Mesh* mesh,
+                       const u32* indices, u32 index_count);
+// Index index_i of a mesh, relative to its vertex_offset
+inline u32 GetMeshIndex(const SceneResources* resources, const Mesh& mesh,
+                        u32 index_i) {
+  const char* indices = resources->indices + mesh.index_offset;
+  if (mesh.index_size == sizeof(u16)) return ((const u16*)indices)[index_i];
+  return ((const u32*)indices)[index_i];
+}
 }  // namespace rally
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <rally/application/application.h>
 
 namespace rally{
+struct Application;
 struct ScriptCreateInfo{
   bool (*create_func)(Application*);
   bool (*update_func)(Application*);
@@ -0,0 +1,71 @@
+#include <rally/dev/dev.h>
+#include <rally/thread/jobgraph.h>
+
+namespace rally {
+static bool PerformJobNode(JobNode* node) {
+  JobGraph* graph = node->graph;
+  if (node->job.callback(node->job.data)) graph->failed.store(true);
+  for (u32 dependent_i = 0; dependent_i < node->dependent_count;
+       dependent_i++) {
+    SignalJobCounter(graph->queue,
+                     &node->dependents[dependent_i]->dependencies);
+  }
+  return false;
+}
+JobGraph* CreateJobGraph(StackAllocator* alloc, u32 max_nodes) {
+  JobGraph* graph = SALLOCZ(alloc, JobGraph, 1);
+  if (graph == nullptr) return nullptr;
+  graph->nodes = SALLOC(alloc, JobNode, max_nodes);
+  if (graph->nodes == nullptr) return nullptr;
+  graph->node_count = 0;
+  graph->max_nodes = max_nodes;
+  graph->queue = nullptr;
+  graph->alloc = alloc;
+  return graph;
+}
+void DestroyJobGraph(JobGraph* graph) {
+  StackAllocator* alloc = graph->alloc;
+  // Nodes, then the graph itself
+  StackFree(alloc);
+  StackFree(alloc);
+  ASSERT((char*)alloc->data + alloc->occupied <= (char*)graph,
+         "Job graph was not on top of its allocator!");
+}
+JobNode* AddJobNode(JobGraph* graph, Job job) {
+  ASSERT(graph->node_count < graph->max_nodes, "Job graph overflow!");
+  ASSERT(job.counter == nullptr, "Job graph nodes signal their dependents!");
+  JobNode* node = &graph->nodes[graph->node_count++];
+  node->job = job;
+  node->graph = graph;
+  node->dependency_count = 0;
+  node->dependent_count = 0;
+  return node;
+}
+void AddJobDependency(JobNode* node, JobNode* dependency) {
+  ASSERT(node->graph == dependency->graph, "Nodes are in different graphs!");
+  ASSERT(dependency < node, "Dependency must be added before node!");
+  ASSERT(dependency->dependent_count < kMaxJobDependents,
+         "Too many dependents!");
+  dependency->dependents[dependency->dependent_count++] = node;
+  node->dependency_count++;
+}
+bool RunJobGraph(JobQueue* queue, JobGraph* graph) {
+  graph->queue = queue;
+  graph->failed.store(false);
+  SetJobCounter(&graph->remaining, graph->node_count, {});
+  // Arm every counter before the first push, nodes start finishing right away
+  for (u32 node_i = 0; node_i < graph->node_count; node_i++) {
+    JobNode* node = &graph->nodes[node_i];
+    Job run_node = {(job_func)PerformJobNode, node, &graph->remaining,
+                    node->job.priority};
+    SetJobCounter(&node->dependencies, node->dependency_count, run_node);
+  }
+  for (u32 node_i = 0; node_i < graph->node_count; node_i++) {
+    JobNode* node = &graph->nodes[node_i];
+    if (node->dependency_count == 0)
+      PushJob(queue, node->dependencies.continuation);
+  }
+  WaitJobCounter(queue, &graph->remaining);
+  return graph->failed.load();
+}
+}  // namespace rally
@@ -0,0 +1,42 @@
+#pragma once
+#include <rally/memory/stackallocator.h>
+#include <rally/thread/threadpool.h>
+#include <rally/types.h>
+
+#include <atomic>
+
+namespace rally {
+constexpr u32 kMaxJobDependents = 16;
+struct JobGraph;
+// Job that is pushed once all of its dependencies have completed
+struct JobNode {
+  Job job;
+  JobGraph* graph;
+  JobCounter dependencies;
+  u32 dependency_count;
+  u32 dependent_count;
+  JobNode* dependents[kMaxJobDependents];
+};
+// Directed acyclic graph of jobs, can be run any number of times
+struct JobGraph {
+  JobNode* nodes;
+  u32 node_count;
+  u32 max_nodes;
+  JobQueue* queue;
+  StackAllocator* alloc;
+  JobCounter remaining;
+  std::atomic<b32> failed;
+};
+// Returns nullptr if alloc is out of memory
+JobGraph* CreateJobGraph(StackAllocator* alloc, u32 max_nodes);
+// Frees the graph from alloc, it must be the most recent allocation there
+void DestroyJobGraph(JobGraph* graph);
+// Node is pushed with job.priority once its dependencies have completed
+JobNode* AddJobNode(JobGraph* graph, Job job);
+// Node runs after dependency has completed, dependency must have been added to
+// the graph before node, which rules out cycles
+void AddJobDependency(JobNode* node, JobNode* dependency);
+// Push all nodes without dependencies and perform jobs until the whole graph
+// has completed. Returns true if any job callback returned true (failed).
+bool RunJobGraph(JobQueue* queue, JobGraph* graph);
+}  // namespace rally
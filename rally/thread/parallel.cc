@@ -0,0 +1,98 @@
+#include <rally/dev/dev.h>
+#include <rally/thread/parallel.h>
+#include <string.h>
+
+namespace rally {
+// Chunks per thread when picking a grain, more balances uneven chunks better
+// at the cost of more claims
+constexpr u32 kChunksPerThread = 4;
+struct ParallelState {
+  // 64 bit so claims past end cannot wrap around
+  alignas(kCacheLineSize) std::atomic<u64> next;
+  u32 end;
+  u32 grain;
+  parallel_for_func for_fn;
+  parallel_reduce_func reduce_fn;
+  void* ctx;
+};
+struct ParallelTask {
+  ParallelState* state;
+  void* partial;
+};
+static bool PerformParallelChunks(ParallelTask* task) {
+  ParallelState* state = task->state;
+  while (true) {
+    u64 begin = state->next.fetch_add(state->grain);
+    if (begin >= state->end) break;
+    u64 end = begin + state->grain;
+    if (end > state->end) end = state->end;
+    if (state->for_fn != nullptr)
+      state->for_fn((u32)begin, (u32)end, state->ctx);
+    else
+      state->reduce_fn((u32)begin, (u32)end, state->ctx, task->partial);
+  }
+  return false;
+}
+// Run chunks on up to one job per worker plus the calling thread, returns the
+// number of tasks that took part
+static u32 RunParallel(JobQueue* queue, ParallelState* state, u32 begin,
+                       u32 grain, ParallelTask* tasks) {
+  u32 count = state->end - begin;
+  u32 thread_count = queue->threadpool->thread_count;
+  if (grain == 0) {
+    grain = count / ((thread_count + 1) * kChunksPerThread);
+    if (grain == 0) grain = 1;
+  }
+  state->next.store(begin);
+  state->grain = grain;
+  u32 chunk_count = (u32)(((u64)count + grain - 1) / grain);
+  // Calling thread takes part, so one chunk needs no jobs at all
+  u32 job_count = chunk_count > 0 ? chunk_count - 1 : 0;
+  if (job_count > thread_count) job_count = thread_count;
+  JobCounter counter;
+  SetJobCounter(&counter, job_count, {});
+  for (u32 job_i = 0; job_i < job_count; job_i++)
+    PushJob(queue, {(job_func)PerformParallelChunks, &tasks[job_i + 1],
+                    &counter, JobPriority::kNormal});
+  PerformParallelChunks(&tasks[0]);
+  WaitJobCounter(queue, &counter);
+  return job_count + 1;
+}
+void ParallelFor(JobQueue* queue, u32 begin, u32 end, u32 grain,
+                 parallel_for_func fn, void* ctx) {
+  if (begin >= end) return;
+  ParallelState state;
+  state.end = end;
+  state.for_fn = fn;
+  state.reduce_fn = nullptr;
+  state.ctx = ctx;
+  ParallelTask tasks[kMaxThreadCount + 1];
+  u32 max_tasks = queue->threadpool->thread_count + 1;
+  for (u32 task_i = 0; task_i < max_tasks; task_i++)
+    tasks[task_i] = {&state, nullptr};
+  RunParallel(queue, &state, begin, grain, tasks);
+}
+void ParallelReduce(JobQueue* queue, u32 begin, u32 end, u32 grain,
+                    parallel_reduce_func fn, parallel_join_func join,
+                    void* ctx, const void* identity, u32 result_size,
+                    void* result) {
+  ASSERT(result_size <= kMaxReduceSize, "Reduce result too large!");
+  if (begin >= end) return;
+  ParallelState state;
+  state.end = end;
+  state.for_fn = nullptr;
+  state.reduce_fn = fn;
+  state.ctx = ctx;
+  // Partials live on this stack, no allocation per call
+  alignas(16) char partials[kMaxThreadCount + 1][kMaxReduceSize];
+  ParallelTask tasks[kMaxThreadCount + 1];
+  u32 max_tasks = queue->threadpool->thread_count + 1;
+  for (u32 task_i = 0; task_i < max_tasks; task_i++) {
+    memcpy(partials[task_i], identity, result_size);
+    tasks[task_i] = {&state, partials[task_i]};
+  }
+  u32 task_count = RunParallel(queue, &state, begin, grain, tasks);
+  for (u32 task_i = 0; task_i < task_count; task_i++)
+    join(result, partials[task_i], ctx);
+}
+}  // namespace rally
\ No newline at end of file
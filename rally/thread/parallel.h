@@ -0,0 +1,31 @@
+#pragma once
+#include <rally/thread/threadpool.h>
+#include <rally/types.h>
+
+#include <atomic>
+
+namespace rally {
+// Largest accumulator ParallelReduce keeps per participating thread
+constexpr u32 kMaxReduceSize = 64;
+// Performs indices [begin, end)
+typedef void (*parallel_for_func)(u32 begin, u32 end, void* ctx);
+// Accumulates indices [begin, end) into partial
+typedef void (*parallel_reduce_func)(u32 begin, u32 end, void* ctx,
+                                     void* partial);
+// Folds partial into result
+typedef void (*parallel_join_func)(void* result, const void* partial,
+                                   void* ctx);
+
+// Split [begin, end) into chunks of grain indices, claimed dynamically by the
+// calling thread and the workers. A zero grain picks one from the range size
+// and thread count. Returns once every index has been performed.
+void ParallelFor(JobQueue* queue, u32 begin, u32 end, u32 grain,
+                 parallel_for_func fn, void* ctx);
+// Like ParallelFor, each participating thread accumulates into its own copy of
+// identity, which are then joined into result in thread order. Chunks reach
+// threads in any order, so join must be associative and commutative.
+void ParallelReduce(JobQueue* queue, u32 begin, u32 end, u32 grain,
+                    parallel_reduce_func fn, parallel_join_func join,
+                    void* ctx, const void* identity, u32 result_size,
+                    void* result);
+}  // namespace rally
\ No newline at end of file
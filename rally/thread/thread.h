@@ -0,0 +1,88 @@
+#pragma once
+#include <rally/types.h>
+
+#include <atomic>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <ucontext.h>
+#endif
+#include <immintrin.h>
+
+namespace rally {
+typedef u32 (*thread_func)(void*);
+// Platform thread, proc and param are kept so the platform entry point can
+// forward to a portable thread_func
+struct Thread {
+#ifdef _WIN32
+  HANDLE handle;
+#else
+  pthread_t handle;
+#endif
+  thread_func proc;
+  void* param;
+};
+typedef void (*fiber_func)(void*);
+// Cooperatively scheduled execution context with its own stack
+struct Fiber {
+#ifdef _WIN32
+  LPVOID handle;
+#else
+  ucontext_t context;
+#endif
+  fiber_func proc;
+  void* param;
+};
+// Win32 allocates fiber stacks itself, the stack passed at creation is ignored
+#ifdef _WIN32
+constexpr b32 kPlatformFiberOwnsStack = true;
+#else
+constexpr b32 kPlatformFiberOwnsStack = false;
+#endif
+// Counting semaphore used to put idle threads to sleep
+struct Semaphore {
+#ifdef _WIN32
+  HANDLE handle;
+#elif defined(__linux__)
+  std::atomic<u32> count;  // Futex word
+  std::atomic<u32> waiters;
+  u32 max_count;
+#else
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  u32 count;
+  u32 max_count;
+#endif
+};
+
+// Spin-wait hint for busy loops
+inline void CpuRelax() { _mm_pause(); }
+
+// Number of logical processors available to this process
+u32 GetProcessorCount();
+
+// Thread creation/destruction
+bool CreatePlatformThread(Thread* thread, thread_func proc, void* param);
+void JoinPlatformThread(Thread* thread);
+// Restrict thread to run on a single logical processor
+bool SetPlatformThreadAffinity(Thread* thread, u32 processor_i);
+
+// A thread must be converted to a fiber before switching to other fibers. proc
+// must never return.
+bool ConvertThreadToPlatformFiber(Fiber* fiber);
+void ConvertPlatformFiberToThread(Fiber* fiber);
+bool CreatePlatformFiber(Fiber* fiber, fiber_func proc, void* param,
+                         void* stack, s64 stack_size);
+// Save the running context to from and resume to, from must be the running
+// fiber
+void SwitchToPlatformFiber(Fiber* from, Fiber* to);
+void DestroyPlatformFiber(Fiber* fiber);
+
+// Counting semaphore, signals past max_count are dropped so the count
+// saturates at max_count on every platform
+void CreatePlatformSemaphore(Semaphore* semaphore, u32 max_count);
+void SignalPlatformSemaphore(Semaphore* semaphore, u32 count);
+void WaitPlatformSemaphore(Semaphore* semaphore);
+void DestroyPlatformSemaphore(Semaphore* semaphore);
+}  // namespace rally
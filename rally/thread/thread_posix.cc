@@ -0,0 +1,135 @@
+#include <rally/thread/thread.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+namespace rally {
+static void* PosixThreadProc(void* param) {
+  Thread* thread = (Thread*)param;
+  thread->proc(thread->param);
+  return nullptr;
+}
+u32 GetProcessorCount() {
+  long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+  return processor_count > 0 ? (u32)processor_count : 1;
+}
+bool CreatePlatformThread(Thread* thread, thread_func proc, void* param) {
+  thread->proc = proc;
+  thread->param = param;
+  return pthread_create(&thread->handle, nullptr, PosixThreadProc, thread) != 0;
+}
+void JoinPlatformThread(Thread* thread) { pthread_join(thread->handle, nullptr); }
+bool SetPlatformThreadAffinity(Thread* thread, u32 processor_i) {
+#ifdef __linux__
+  if (processor_i >= CPU_SETSIZE) return true;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(processor_i, &cpu_set);
+  return pthread_setaffinity_np(thread->handle, sizeof(cpu_set), &cpu_set) !=
+         0;
+#else
+  // No portable affinity API, scheduler decides
+  return true;
+#endif
+}
+
+// makecontext only forwards int arguments, the fiber pointer is split in two
+static void PosixFiberProc(u32 fiber_hi, u32 fiber_lo) {
+  Fiber* fiber = (Fiber*)(uintptr_t)(((u64)fiber_hi << 32) | fiber_lo);
+  fiber->proc(fiber->param);
+}
+bool ConvertThreadToPlatformFiber(Fiber* fiber) {
+  // Context is saved by the first switch away from the thread
+  fiber->proc = nullptr;
+  fiber->param = nullptr;
+  return false;
+}
+void ConvertPlatformFiberToThread(Fiber*) {}
+bool CreatePlatformFiber(Fiber* fiber, fiber_func proc, void* param,
+                         void* stack, s64 stack_size) {
+  fiber->proc = proc;
+  fiber->param = param;
+  if (getcontext(&fiber->context) != 0) return true;
+  fiber->context.uc_stack.ss_sp = stack;
+  fiber->context.uc_stack.ss_size = stack_size;
+  fiber->context.uc_link = nullptr;
+  u64 address = (u64)(uintptr_t)fiber;
+  makecontext(&fiber->context, (void (*)())PosixFiberProc, 2,
+              (u32)(address >> 32), (u32)address);
+  return false;
+}
+void SwitchToPlatformFiber(Fiber* from, Fiber* to) {
+  swapcontext(&from->context, &to->context);
+}
+void DestroyPlatformFiber(Fiber*) {
+  // Stack belongs to the caller
+}
+
+#ifdef __linux__
+static long Futex(std::atomic<u32>* word, int op, u32 value) {
+  return syscall(SYS_futex, (u32*)word, op, value, nullptr, nullptr, 0);
+}
+void CreatePlatformSemaphore(Semaphore* semaphore, u32 max_count) {
+  semaphore->count.store(0);
+  semaphore->waiters.store(0);
+  semaphore->max_count = max_count;
+}
+void SignalPlatformSemaphore(Semaphore* semaphore, u32 count) {
+  u32 old_count = semaphore->count.load();
+  u32 new_count;
+  do {
+    new_count = old_count + count;
+    if (new_count > semaphore->max_count) new_count = semaphore->max_count;
+    if (new_count == old_count) break;
+  } while (!semaphore->count.compare_exchange_weak(old_count, new_count));
+  // Sequentially consistent ordering against the waiter count: either we see
+  // the waiter, or the waiter sees the new count in FUTEX_WAIT
+  if (semaphore->waiters.load() > 0)
+    Futex(&semaphore->count, FUTEX_WAKE_PRIVATE, count);
+}
+void WaitPlatformSemaphore(Semaphore* semaphore) {
+  while (true) {
+    u32 count = semaphore->count.load();
+    while (count > 0) {
+      if (semaphore->count.compare_exchange_weak(count, count - 1)) return;
+    }
+    semaphore->waiters.fetch_add(1);
+    Futex(&semaphore->count, FUTEX_WAIT_PRIVATE, 0);
+    semaphore->waiters.fetch_sub(1);
+  }
+}
+void DestroyPlatformSemaphore(Semaphore*) {
+  // Futex words own no kernel resources
+}
+#else
+void CreatePlatformSemaphore(Semaphore* semaphore, u32 max_count) {
+  pthread_mutex_init(&semaphore->mutex, nullptr);
+  pthread_cond_init(&semaphore->cond, nullptr);
+  semaphore->count = 0;
+  semaphore->max_count = max_count;
+}
+void SignalPlatformSemaphore(Semaphore* semaphore, u32 count) {
+  pthread_mutex_lock(&semaphore->mutex);
+  semaphore->count += count;
+  if (semaphore->count > semaphore->max_count)
+    semaphore->count = semaphore->max_count;
+  pthread_cond_broadcast(&semaphore->cond);
+  pthread_mutex_unlock(&semaphore->mutex);
+}
+void WaitPlatformSemaphore(Semaphore* semaphore) {
+  pthread_mutex_lock(&semaphore->mutex);
+  while (semaphore->count == 0)
+    pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+  semaphore->count--;
+  pthread_mutex_unlock(&semaphore->mutex);
+}
+void DestroyPlatformSemaphore(Semaphore* semaphore) {
+  pthread_cond_destroy(&semaphore->cond);
+  pthread_mutex_destroy(&semaphore->mutex);
+}
+#endif
+}  // namespace rally
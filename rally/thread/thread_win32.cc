@@ -0,0 +1,71 @@
+#include <rally/thread/thread.h>
+
+namespace rally {
+static DWORD WINAPI Win32ThreadProc(LPVOID lpParameter) {
+  Thread* thread = (Thread*)lpParameter;
+  return thread->proc(thread->param);
+}
+u32 GetProcessorCount() {
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  return system_info.dwNumberOfProcessors;
+}
+bool CreatePlatformThread(Thread* thread, thread_func proc, void* param) {
+  thread->proc = proc;
+  thread->param = param;
+  DWORD thread_id;
+  thread->handle = CreateThread(NULL, 0, Win32ThreadProc, thread, 0, &thread_id);
+  return thread->handle == NULL;
+}
+void JoinPlatformThread(Thread* thread) {
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+}
+bool SetPlatformThreadAffinity(Thread* thread, u32 processor_i) {
+  // Affinity masks only address the first processor group
+  if (processor_i >= sizeof(DWORD_PTR) * 8) return true;
+  DWORD_PTR mask = (DWORD_PTR)1 << processor_i;
+  return SetThreadAffinityMask(thread->handle, mask) == 0;
+}
+static VOID WINAPI Win32FiberProc(LPVOID lpParameter) {
+  Fiber* fiber = (Fiber*)lpParameter;
+  fiber->proc(fiber->param);
+}
+bool ConvertThreadToPlatformFiber(Fiber* fiber) {
+  fiber->proc = nullptr;
+  fiber->param = nullptr;
+  fiber->handle = ConvertThreadToFiberEx(NULL, FIBER_FLAG_FLOAT_SWITCH);
+  return fiber->handle == NULL;
+}
+void ConvertPlatformFiberToThread(Fiber* fiber) { ConvertFiberToThread(); }
+bool CreatePlatformFiber(Fiber* fiber, fiber_func proc, void* param,
+                         void* stack, s64 stack_size) {
+  fiber->proc = proc;
+  fiber->param = param;
+  fiber->handle = CreateFiberEx(stack_size, stack_size, FIBER_FLAG_FLOAT_SWITCH,
+                                Win32FiberProc, fiber);
+  return fiber->handle == NULL;
+}
+void SwitchToPlatformFiber(Fiber* from, Fiber* to) {
+  SwitchToFiber(to->handle);
+}
+void DestroyPlatformFiber(Fiber* fiber) { DeleteFiber(fiber->handle); }
+void CreatePlatformSemaphore(Semaphore* semaphore, u32 max_count) {
+  semaphore->handle =
+      CreateSemaphoreExW(NULL, 0, max_count, NULL, 0, SEMAPHORE_ALL_ACCESS);
+}
+void SignalPlatformSemaphore(Semaphore* semaphore, u32 count) {
+  // ReleaseSemaphore releases nothing when count would pass the maximum, so
+  // fall back to single releases until the semaphore is full
+  if (ReleaseSemaphore(semaphore->handle, count, NULL) || count == 1) return;
+  for (u32 release_i = 0; release_i < count; release_i++) {
+    if (!ReleaseSemaphore(semaphore->handle, 1, NULL)) return;
+  }
+}
+void WaitPlatformSemaphore(Semaphore* semaphore) {
+  WaitForSingleObject(semaphore->handle, INFINITE);
+}
+void DestroyPlatformSemaphore(Semaphore* semaphore) {
+  CloseHandle(semaphore->handle);
+}
+}  // namespace rally
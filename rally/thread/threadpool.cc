@@ -2,86 +2,574 @@
 #include <rally/thread/threadpool.h>
 
 namespace rally {
-static void DeactivateQueue(JobQueue* queue, u32 thread_count) {
-  InterlockedAnd((LONG volatile*)&queue->active, 0);
-  ReleaseSemaphore(queue->semaphore, thread_count, NULL);
+// Worker running on this thread, null on threads outside any pool
+static thread_local ThreadInfo* current_thread_info = nullptr;
+
+// Parked fibers may resume on another worker, keep the compiler from caching
+// the thread local address across fiber switches
+#ifdef _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static ThreadInfo* GetCurrentThreadInfo() {
+  return current_thread_info;
+}
+// Stand-in for threads outside the pool that help drain the queue
+static ThreadInfo ForeignThreadInfo() {
+  ThreadInfo thread_info = {};
+  thread_info.thread_id = 99;
+  thread_info.random_state = 0x9e3779b9;
+  return thread_info;
+}
+
+static void DeactivateQueue(ThreadPool* threadpool) {
+  JobQueue* queue = threadpool->queue;
+  queue->active.store(false);
+  SignalPlatformSemaphore(&queue->semaphore, threadpool->thread_count);
+  SignalPlatformSemaphore(&queue->io_semaphore, threadpool->io_thread_count);
+}
+
+// Wake up to count parked threads. The fence pairs with the one in
+// ParkWorker, either the waker sees the sleeper or the sleeper sees the job.
+static void WakeThreads(JobQueue* queue, Semaphore* semaphore,
+                        std::atomic<u32>* sleeping_count, u32 count) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  u32 sleeping = sleeping_count->load(std::memory_order_relaxed);
+  if (sleeping == 0 || count == 0) return;
+  queue->wake_count.fetch_add(1, std::memory_order_relaxed);
+  SignalPlatformSemaphore(semaphore, count < sleeping ? count : sleeping);
+}
+static void WakeWorkers(JobQueue* queue, u32 count) {
+  WakeThreads(queue, &queue->semaphore, &queue->sleeping_count, count);
+}
+static void WakeIOThreads(JobQueue* queue, u32 count) {
+  WakeThreads(queue, &queue->io_semaphore, &queue->io_sleeping_count, count);
+}
+
+// Shared rings, one per priority
+static MpmcRing<Job>* GetJobRing(JobQueue* queue, JobPriority priority) {
+  return &queue->rings[(u32)priority];
+}
+// Reserve a background thread first so racing workers cannot exceed the limit
+static bool DequeueBackgroundJob(JobQueue* queue, Job* out_job) {
+  if (queue->background_count.load(std::memory_order_relaxed) >=
+      queue->background_limit)
+    return false;
+  if (queue->background_count.fetch_add(1) < queue->background_limit &&
+      !PopMpmcRing(GetJobRing(queue, JobPriority::kBackground), out_job))
+    return true;
+  queue->background_count.fetch_sub(1);
+  return false;
+}
+
+// Worker deque, only the owning thread may push and take
+static bool PushDequeJob(WorkDeque* deque, Job job) {
+  i64 bottom = deque->bottom.load(std::memory_order_relaxed);
+  i64 top = deque->top.load(std::memory_order_acquire);
+  if (bottom - top >= (i64)kMaxJobCount) return false;
+  deque->jobs[bottom % kMaxJobCount] = job;
+  std::atomic_thread_fence(std::memory_order_release);
+  deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+  return true;
+}
+static bool TakeDequeJob(WorkDeque* deque, Job* out_job) {
+  i64 bottom = deque->bottom.load(std::memory_order_relaxed) - 1;
+  deque->bottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  i64 top = deque->top.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+    return false;
+  }
+  *out_job = deque->jobs[bottom % kMaxJobCount];
+  if (top == bottom) {
+    // Last job, race thieves for it
+    bool won = deque->top.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    deque->bottom.store(bottom + 1, std::memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+static PerformNextJobResponse StealDequeJob(WorkDeque* deque, Job* out_job) {
+  i64 top = deque->top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  i64 bottom = deque->bottom.load(std::memory_order_acquire);
+  if (top >= bottom) return PerformNextJobResponse::kShouldSleep;
+  *out_job = deque->jobs[top % kMaxJobCount];
+  if (!deque->top.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+    return PerformNextJobResponse::kFailedToSecureJob;
+  return PerformNextJobResponse::kCompletedJob;
+}
+
+static u32 NextRandom(u32* state) {
+  // xorshift32
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// High priority jobs first, then own deque and the normal ring, then steal
+// from a random victim, background jobs last
+static PerformNextJobResponse FindJob(JobQueue* queue, ThreadInfo* thread_info,
+                                      Job* out_job) {
+  if (!PopMpmcRing(GetJobRing(queue, JobPriority::kHigh), out_job))
+    return PerformNextJobResponse::kCompletedJob;
+  if (thread_info->deque != nullptr &&
+      TakeDequeJob(thread_info->deque, out_job))
+    return PerformNextJobResponse::kCompletedJob;
+  if (!PopMpmcRing(GetJobRing(queue, JobPriority::kNormal), out_job))
+    return PerformNextJobResponse::kCompletedJob;
+  ThreadPool* threadpool = queue->threadpool;
+  u32 thread_count = threadpool->thread_count;
+  PerformNextJobResponse response = PerformNextJobResponse::kShouldSleep;
+  u32 first_victim =
+      thread_count > 0 ? NextRandom(&thread_info->random_state) % thread_count
+                       : 0;
+  for (u32 victim_i = 0; victim_i < thread_count; victim_i++) {
+    ThreadInfo* victim =
+        &threadpool->thread_infos[(first_victim + victim_i) % thread_count];
+    if (victim == thread_info) continue;
+    PerformNextJobResponse steal = StealDequeJob(victim->deque, out_job);
+    if (steal == PerformNextJobResponse::kCompletedJob) return steal;
+    if (steal == PerformNextJobResponse::kFailedToSecureJob) response = steal;
+  }
+  if (DequeueBackgroundJob(queue, out_job))
+    return PerformNextJobResponse::kCompletedJob;
+  return response;
+}
+static void PerformJob(JobQueue* queue, Job job) {
+  job.callback(job.data);
+  if (job.priority == JobPriority::kBackground)
+    queue->background_count.fetch_sub(1);
+  // Continuations are pushed before this job counts as complete, so
+  // WaitThreadQueue also waits for them
+  if (job.counter != nullptr) SignalJobCounter(queue, job.counter);
+  queue->completion_count.fetch_add(1);
 }
 static PerformNextJobResponse PerformNextJob(JobQueue* queue,
                                              ThreadInfo* thread_info) {
-  u32 original_next_job = queue->front;
-  u32 original_job_increment = (original_next_job + 1) % kMaxJobCount;
-  if (original_next_job != queue->end) {
-    u32 job_id =
-        InterlockedCompareExchange((LONG volatile*)&queue->front,
-                                   original_job_increment, original_next_job);
-    if (job_id == original_next_job) {
-      Job job = queue->jobs[job_id];
-      job.callback(job.data);
-      InterlockedIncrement((LONG volatile*)&queue->completion_count);
-      return PerformNextJobResponse::kCompletedJob;
-    } else {
-      return PerformNextJobResponse::kFailedToSecureJob;
+  Job job;
+  PerformNextJobResponse response = FindJob(queue, thread_info, &job);
+  if (response != PerformNextJobResponse::kCompletedJob) return response;
+  PerformJob(queue, job);
+  return PerformNextJobResponse::kCompletedJob;
+}
+static u32 IOThreadProc(void* param) {
+  ThreadInfo* thread_info = (ThreadInfo*)param;
+  JobQueue* queue = thread_info->threadpool->queue;
+  current_thread_info = thread_info;
+  MpmcRing<Job>* ring = GetJobRing(queue, JobPriority::kIO);
+  while (queue->active.load()) {
+    Job job;
+    if (!PopMpmcRing(ring, &job)) {
+      PerformJob(queue, job);
+      continue;
     }
+    // IO jobs block anyway, park without spinning
+    queue->io_sleeping_count.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!PopMpmcRing(ring, &job)) {
+      queue->io_sleeping_count.fetch_sub(1);
+      PerformJob(queue, job);
+      continue;
+    }
+    queue->park_count.fetch_add(1, std::memory_order_relaxed);
+    WaitPlatformSemaphore(&queue->io_semaphore);
+    queue->io_sleeping_count.fetch_sub(1);
+  }
+  current_thread_info = nullptr;
+  return 0;
+}
+static JobFiber* AcquireFreeFiber(ThreadPool* threadpool) {
+  for (u32 fiber_i = 0; fiber_i < threadpool->fiber_count; fiber_i++) {
+    JobFiber* fiber = &threadpool->fibers[fiber_i];
+    JobFiberState state = JobFiberState::kFree;
+    if (fiber->state.load(std::memory_order_relaxed) == state &&
+        fiber->state.compare_exchange_strong(state, JobFiberState::kRunning,
+                                             std::memory_order_acquire))
+      return fiber;
   }
-  return PerformNextJobResponse::kShouldSleep;
+  return nullptr;
 }
-static DWORD WINAPI ThreadProc(LPVOID lpParameter) {
-  ThreadInfo* thread_info = (ThreadInfo*)lpParameter;
-  ThreadPool* threadpool = thread_info->threadpool;
-  JobQueue* queue = threadpool->queue;
-  while (queue->active) {
+// Parked fiber whose counter has reached zero
+static JobFiber* AcquireReadyFiber(ThreadPool* threadpool) {
+  for (u32 fiber_i = 0; fiber_i < threadpool->fiber_count; fiber_i++) {
+    JobFiber* fiber = &threadpool->fibers[fiber_i];
+    JobFiberState state = JobFiberState::kWaiting;
+    if (fiber->state.load(std::memory_order_acquire) != state ||
+        fiber->wait_counter->value.load() > 0)
+      continue;
+    if (!fiber->state.compare_exchange_strong(state, JobFiberState::kRunning,
+                                              std::memory_order_acquire))
+      continue;
+    // Owned now, recheck in case it was resumed and parked again meanwhile
+    if (fiber->wait_counter->value.load() == 0) return fiber;
+    fiber->state.store(JobFiberState::kWaiting, std::memory_order_release);
+  }
+  return nullptr;
+}
+static bool HasReadyFiber(ThreadPool* threadpool) {
+  for (u32 fiber_i = 0; fiber_i < threadpool->fiber_count; fiber_i++) {
+    JobFiber* fiber = &threadpool->fibers[fiber_i];
+    if (fiber->state.load(std::memory_order_acquire) ==
+            JobFiberState::kWaiting &&
+        fiber->wait_counter->value.load() == 0)
+      return true;
+  }
+  return false;
+}
+// Announce the worker as sleeping, then look once more before parking
+static void ParkWorker(JobQueue* queue, ThreadInfo* thread_info) {
+  queue->sleeping_count.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  Job job;
+  if (FindJob(queue, thread_info, &job) ==
+      PerformNextJobResponse::kCompletedJob) {
+    queue->sleeping_count.fetch_sub(1);
+    PerformJob(queue, job);
+    return;
+  }
+  if (HasReadyFiber(queue->threadpool)) {
+    queue->sleeping_count.fetch_sub(1);
+    return;
+  }
+  queue->park_count.fetch_add(1, std::memory_order_relaxed);
+  WaitPlatformSemaphore(&queue->semaphore);
+  queue->sleeping_count.fetch_sub(1);
+}
+// Spin looking for work before parking. The spin budget doubles when spinning
+// found work and halves when the worker had to park anyway.
+static void IdleWorker(JobQueue* queue, ThreadInfo* thread_info) {
+  u32 spin_limit = queue->low_power_idle ? 0 : thread_info->spin_limit;
+  for (u32 spin_i = 0; spin_i < spin_limit; spin_i++) {
+    CpuRelax();
+    Job job;
+    if (FindJob(queue, thread_info, &job) ==
+        PerformNextJobResponse::kCompletedJob) {
+      thread_info->spin_limit =
+          spin_limit * 2 < kMaxIdleSpins ? spin_limit * 2 : kMaxIdleSpins;
+      PerformJob(queue, job);
+      return;
+    }
+    if (HasReadyFiber(queue->threadpool)) return;
+  }
+  thread_info->spin_limit =
+      spin_limit / 2 > kMinIdleSpins ? spin_limit / 2 : kMinIdleSpins;
+  ParkWorker(queue, thread_info);
+}
+static void PublishPendingFiber(ThreadInfo* thread_info) {
+  JobFiber* fiber = thread_info->pending_fiber;
+  if (fiber == nullptr) return;
+  thread_info->pending_fiber = nullptr;
+  fiber->state.store(thread_info->pending_state, std::memory_order_release);
+}
+// Leave the current fiber in state and continue on next, or on the thread
+// fiber when next is null. Returns once another worker switches back.
+static void LeaveJobFiber(ThreadInfo* thread_info, JobFiberState state,
+                          JobFiber* next) {
+  JobFiber* fiber = thread_info->current_fiber;
+  // Published by whoever runs next, the stack is still in use until then
+  thread_info->pending_fiber = fiber;
+  thread_info->pending_state = state;
+  thread_info->current_fiber = next;
+  SwitchToPlatformFiber(&fiber->fiber, next != nullptr
+                                           ? &next->fiber
+                                           : &thread_info->thread_fiber);
+  PublishPendingFiber(GetCurrentThreadInfo());
+}
+static void FiberProc(void* param) {
+  JobFiber* fiber = (JobFiber*)param;
+  JobQueue* queue = fiber->threadpool->queue;
+  PublishPendingFiber(GetCurrentThreadInfo());
+  while (queue->active.load()) {
+    ThreadInfo* thread_info = GetCurrentThreadInfo();
+    // Finish parked jobs before starting new ones
+    JobFiber* ready = AcquireReadyFiber(fiber->threadpool);
+    if (ready != nullptr) {
+      LeaveJobFiber(thread_info, JobFiberState::kFree, ready);
+      continue;
+    }
     PerformNextJobResponse response = PerformNextJob(queue, thread_info);
     if (response == PerformNextJobResponse::kShouldSleep)
-      WaitForSingleObject(queue->semaphore, INFINITE);
+      IdleWorker(queue, thread_info);
   }
+  LeaveJobFiber(GetCurrentThreadInfo(), JobFiberState::kFree, nullptr);
+  // Resumed after shutdown by a worker still draining, return it the same way
+  while (true)
+    LeaveJobFiber(GetCurrentThreadInfo(), JobFiberState::kFree, nullptr);
+}
+static u32 ThreadProc(void* param) {
+  ThreadInfo* thread_info = (ThreadInfo*)param;
+  ThreadPool* threadpool = thread_info->threadpool;
+  JobQueue* queue = threadpool->queue;
+  current_thread_info = thread_info;
+  if (threadpool->fiber_count > 0) {
+    ConvertThreadToPlatformFiber(&thread_info->thread_fiber);
+    JobFiber* fiber = AcquireFreeFiber(threadpool);
+    ASSERT(fiber != nullptr, "Not enough job fibers!");
+    thread_info->current_fiber = fiber;
+    SwitchToPlatformFiber(&thread_info->thread_fiber, &fiber->fiber);
+    // Back once the queue is inactive
+    PublishPendingFiber(thread_info);
+    ConvertPlatformFiberToThread(&thread_info->thread_fiber);
+  } else {
+    while (queue->active.load()) {
+      PerformNextJobResponse response = PerformNextJob(queue, thread_info);
+      if (response == PerformNextJobResponse::kShouldSleep)
+        IdleWorker(queue, thread_info);
+    }
+  }
+  current_thread_info = nullptr;
   return 0;
 }
+static bool InitThreadInfo(ThreadInfo* thread_info, u32 thread_id,
+                           ThreadPool* threadpool, WorkDeque* deque,
+                           s64 scratch_size, StackAllocator* alloc) {
+  thread_info->thread_id = thread_id;
+  thread_info->threadpool = threadpool;
+  thread_info->deque = deque;
+  thread_info->random_state = thread_id * 7919 + 1;
+  thread_info->spin_limit = kMinIdleSpins;
+  thread_info->current_fiber = nullptr;
+  thread_info->pending_fiber = nullptr;
+  thread_info->scratch = nullptr;
+  thread_info->scratch_frame = 0;
+  if (scratch_size == 0) return false;
+  void* scratch_data = StackAllocate(alloc, scratch_size, kCacheLineSize);
+  if (scratch_data == nullptr) return true;
+  thread_info->scratch = CreateStackAllocator(scratch_data, scratch_size);
+  return false;
+}
 bool CreateThreadPool(ThreadPoolCreateInfo* threadpool_ci, Application* app) {
-  app->threadpool = (ThreadPool*)StackAllocate(app->alloc, sizeof(ThreadPool),
-                                               alignof(ThreadPool));
-  app->threadpool->queue =
-      (JobQueue*)StackAllocate(app->alloc, sizeof(JobQueue), alignof(JobQueue));
+  ASSERT(threadpool_ci->thread_count <= kMaxThreadCount,
+         "Too many threads requested!");
+  app->threadpool = SALLOCZ(app->alloc, ThreadPool, 1);
+  app->threadpool->queue = SALLOCZ(app->alloc, JobQueue, 1);
   ThreadPool* threadpool = app->threadpool;
-  threadpool->queue->active = true;
+  JobQueue* queue = threadpool->queue;
+  queue->completion_goal.store(0);
+  queue->completion_count.store(0);
+  queue->background_count.store(0);
+  queue->sleeping_count.store(0);
+  queue->io_sleeping_count.store(0);
+  queue->wake_count.store(0);
+  queue->park_count.store(0);
+  queue->low_power_idle = threadpool_ci->low_power_idle;
+  queue->active.store(true);
+  queue->threadpool = threadpool;
+  ASSERT(threadpool_ci->job_capacity <= (1u << 31), "Job capacity too large!");
+  // Two slots at least, a single slot cannot tell full from empty
+  u32 capacity = threadpool_ci->job_capacity > 0 ? 2 : kMaxJobCount;
+  while (capacity < threadpool_ci->job_capacity) capacity <<= 1;
+  bool failed = false;
+  for (u32 priority_i = 0; priority_i < kJobPriorityCount; priority_i++) {
+    u32 ring_capacity =
+        priority_i == (u32)JobPriority::kNormal ? capacity : kMaxJobCount;
+    failed |= CreateMpmcRing(app->alloc, ring_capacity,
+                             &queue->rings[priority_i]);
+  }
+  if (failed) return failed;
   threadpool->thread_count = threadpool_ci->thread_count;
-  threadpool->queue->semaphore = CreateSemaphoreExW(
-      NULL, 0, threadpool->thread_count, NULL, 0, SEMAPHORE_ALL_ACCESS);
+  WorkDeque* deques = SALLOC(app->alloc, WorkDeque, threadpool->thread_count);
+  CreatePlatformSemaphore(&queue->semaphore, threadpool->thread_count);
+  queue->background_limit = threadpool_ci->background_limit;
+  if (queue->background_limit == 0)
+    queue->background_limit = (threadpool->thread_count + 1) / 2;
+  if (queue->background_limit == 0) queue->background_limit = 1;
+  ASSERT(threadpool_ci->io_thread_count <= kMaxIOThreadCount,
+         "Too many IO threads requested!");
+  threadpool->io_thread_count = threadpool_ci->io_thread_count;
+  CreatePlatformSemaphore(&queue->io_semaphore,
+                          threadpool->io_thread_count > 0
+                              ? threadpool->io_thread_count
+                              : 1);
+
+  threadpool->fiber_count = threadpool_ci->fiber_count;
+  threadpool->fibers = nullptr;
+  if (threadpool->fiber_count > 0) {
+    ASSERT(threadpool->fiber_count >= threadpool->thread_count,
+           "Every worker needs a job fiber!");
+    s64 stack_size = threadpool_ci->fiber_stack_size > 0
+                         ? threadpool_ci->fiber_stack_size
+                         : kDefaultFiberStackSize;
+    threadpool->fibers = SALLOCZ(app->alloc, JobFiber, threadpool->fiber_count);
+    for (u32 fiber_i = 0; fiber_i < threadpool->fiber_count; fiber_i++) {
+      JobFiber* fiber = &threadpool->fibers[fiber_i];
+      fiber->threadpool = threadpool;
+      fiber->state.store(JobFiberState::kFree);
+      fiber->wait_counter = nullptr;
+      void* stack = nullptr;
+      if (!kPlatformFiberOwnsStack) {
+        stack = StackAllocate(app->alloc, stack_size, 16);
+        failed |= stack == nullptr;
+      }
+      failed |= CreatePlatformFiber(&fiber->fiber, FiberProc, fiber, stack,
+                                    stack_size);
+    }
+    if (failed) return failed;
+  }
+
+  // Worker state must be complete before any thread starts stealing
+  threadpool->frame.store(0);
+  s64 scratch_size = threadpool_ci->scratch_size;
   for (u32 thread_i = 0; thread_i < threadpool->thread_count; thread_i++) {
-    threadpool->thread_infos[thread_i].thread_id = thread_i;
-    threadpool->thread_infos[thread_i].threadpool = threadpool;
-    DWORD thread_id;
-    threadpool->thread_handles[thread_i] =
-        CreateThread(NULL, 0, ThreadProc, &(threadpool->thread_infos[thread_i]),
-                     0, &thread_id);
+    deques[thread_i].top.store(0);
+    deques[thread_i].bottom.store(0);
+    failed |= InitThreadInfo(&threadpool->thread_infos[thread_i], thread_i,
+                             threadpool, &deques[thread_i], scratch_size,
+                             app->alloc);
   }
-  return false;
+  for (u32 thread_i = 0; thread_i < threadpool->io_thread_count; thread_i++)
+    failed |= InitThreadInfo(&threadpool->io_thread_infos[thread_i],
+                             kMaxThreadCount + thread_i, threadpool, nullptr,
+                             scratch_size, app->alloc);
+  failed |= InitThreadInfo(&threadpool->main_thread_info,
+                           kMaxThreadCount + kMaxIOThreadCount, threadpool,
+                           nullptr, scratch_size, app->alloc);
+  if (failed) return failed;
+  u32 processor_count = GetProcessorCount();
+  for (u32 thread_i = 0; thread_i < threadpool->thread_count; thread_i++) {
+    failed |= CreatePlatformThread(&(threadpool->threads[thread_i]), ThreadProc,
+                                   &(threadpool->thread_infos[thread_i]));
+    if (threadpool_ci->pin_threads)
+      SetPlatformThreadAffinity(&(threadpool->threads[thread_i]),
+                                (thread_i + 1) % processor_count);
+  }
+  for (u32 thread_i = 0; thread_i < threadpool->io_thread_count; thread_i++)
+    failed |= CreatePlatformThread(&(threadpool->io_threads[thread_i]),
+                                   IOThreadProc,
+                                   &(threadpool->io_thread_infos[thread_i]));
+  return failed;
+}
+// Push without waking anyone, returns whether the job went to the IO lane
+static bool PublishJob(JobQueue* queue, Job job) {
+  // Count the job before publishing it so waiters never observe it completed
+  // but not yet pushed
+  queue->completion_goal.fetch_add(1);
+  ThreadPool* threadpool = queue->threadpool;
+  if (job.priority == JobPriority::kIO && threadpool->io_thread_count == 0)
+    job.priority = JobPriority::kBackground;
+  bool io = job.priority == JobPriority::kIO;
+  MpmcRing<Job>* ring = GetJobRing(queue, job.priority);
+  ThreadInfo* thread_info = current_thread_info;
+  bool pushed = false;
+  if (job.priority == JobPriority::kNormal && thread_info != nullptr &&
+      thread_info->threadpool == threadpool && thread_info->deque != nullptr)
+    pushed = PushDequeJob(thread_info->deque, job);
+  if (!pushed) pushed = !PushMpmcRing(ring, job);
+  if (!pushed) {
+    // Ring full, make room by performing queued jobs
+    ThreadInfo main_thread_info = ForeignThreadInfo();
+    if (io)
+      WakeIOThreads(queue, threadpool->io_thread_count);
+    else
+      WakeWorkers(queue, threadpool->thread_count);
+    do {
+      thread_info = GetCurrentThreadInfo();
+      if (thread_info == nullptr) thread_info = &main_thread_info;
+      if (PerformNextJob(queue, thread_info) !=
+          PerformNextJobResponse::kCompletedJob)
+        CpuRelax();
+    } while (PushMpmcRing(ring, job));
+  }
+  return io;
 }
 void PushJob(JobQueue* queue, Job job) {
-  u32 next_queue_end = (queue->end + 1) % kMaxJobCount;
-  ASSERT(next_queue_end != queue->front, "Job queue overflow!");
-  queue->jobs[queue->end] = job;
-  InterlockedExchange((LONG volatile*)&queue->end, next_queue_end);
-  queue->completion_goal++;
-  ReleaseSemaphore(queue->semaphore, 1, NULL);
+  if (PublishJob(queue, job))
+    WakeIOThreads(queue, 1);
+  else
+    WakeWorkers(queue, 1);
 }
 void PushJobs(JobQueue* queue, Job* jobs_head, u32 job_count) {
+  u32 io_count = 0;
   for (u32 job_i = 0; job_i < job_count; job_i++) {
-    PushJob(queue, jobs_head[job_i]);
+    io_count += PublishJob(queue, jobs_head[job_i]);
   }
+  WakeWorkers(queue, job_count - io_count);
+  WakeIOThreads(queue, io_count);
 }
 void WaitThreadQueue(JobQueue* queue) {
-  ThreadInfo main_thread_info{99, nullptr};
-  while (queue->completion_count < queue->completion_goal) {
-    PerformNextJob(queue, &main_thread_info);
+  ThreadInfo main_thread_info = ForeignThreadInfo();
+  while (queue->completion_count.load() < queue->completion_goal.load()) {
+    // Reloaded every job, a job may park this fiber and resume it elsewhere
+    ThreadInfo* thread_info = GetCurrentThreadInfo();
+    if (thread_info == nullptr) thread_info = &main_thread_info;
+    if (PerformNextJob(queue, thread_info) !=
+        PerformNextJobResponse::kCompletedJob)
+      CpuRelax();
   }
 }
+void SetJobCounter(JobCounter* counter, u32 value, Job continuation) {
+  counter->continuation = continuation;
+  counter->value.store(value);
+}
+void SignalJobCounter(JobQueue* queue, JobCounter* counter) {
+  // Read continuation first, the counter may be reused once it hits zero
+  Job continuation = counter->continuation;
+  if (counter->value.fetch_sub(1) != 1) return;
+  if (continuation.callback != nullptr)
+    PushJob(queue, continuation);
+  else if (queue->threadpool->fiber_count > 0)
+    // Wake a worker to resume fibers parked on this counter
+    WakeWorkers(queue, 1);
+}
+void WaitJobCounter(JobQueue* queue, JobCounter* counter) {
+  ThreadInfo* thread_info = GetCurrentThreadInfo();
+  if (thread_info != nullptr && thread_info->current_fiber != nullptr &&
+      thread_info->threadpool == queue->threadpool &&
+      counter->value.load() > 0) {
+    JobFiber* next = AcquireFreeFiber(queue->threadpool);
+    // Out of fibers, perform jobs on this stack instead
+    if (next != nullptr) {
+      thread_info->current_fiber->wait_counter = counter;
+      LeaveJobFiber(thread_info, JobFiberState::kWaiting, next);
+      return;
+    }
+  }
+  ThreadInfo main_thread_info = ForeignThreadInfo();
+  while (counter->value.load() > 0) {
+    thread_info = GetCurrentThreadInfo();
+    if (thread_info == nullptr) thread_info = &main_thread_info;
+    if (PerformNextJob(queue, thread_info) !=
+        PerformNextJobResponse::kCompletedJob)
+      CpuRelax();
+  }
+}
+StackAllocator* GetJobScratch(JobQueue* queue) {
+  ThreadPool* threadpool = queue->threadpool;
+  ThreadInfo* thread_info = GetCurrentThreadInfo();
+  if (thread_info == nullptr || thread_info->threadpool != threadpool)
+    thread_info = &threadpool->main_thread_info;
+  if (thread_info->scratch == nullptr) return nullptr;
+  // Only the owning thread resets its arena, so frames need no barrier
+  u64 frame = threadpool->frame.load(std::memory_order_relaxed);
+  if (thread_info->scratch_frame != frame) {
+    ResetStackAllocator(thread_info->scratch);
+    thread_info->scratch_frame = frame;
+  }
+  return thread_info->scratch;
+}
+void BeginThreadPoolFrame(ThreadPool* threadpool) {
+  threadpool->frame.fetch_add(1, std::memory_order_relaxed);
+}
 void DestroyThreadPool(ThreadPool* threadpool) {
   if (threadpool == nullptr) return;
-  DeactivateQueue(threadpool->queue, threadpool->thread_count);
-  WaitForMultipleObjects(threadpool->thread_count, threadpool->thread_handles,
-                         TRUE, INFINITE);
+  DeactivateQueue(threadpool);
   for (u32 thread_i = 0; thread_i < threadpool->thread_count; thread_i++) {
-    CloseHandle(threadpool->thread_handles[thread_i]);
+    JoinPlatformThread(&(threadpool->threads[thread_i]));
   }
+  for (u32 thread_i = 0; thread_i < threadpool->io_thread_count; thread_i++)
+    JoinPlatformThread(&(threadpool->io_threads[thread_i]));
+  DestroyPlatformSemaphore(&threadpool->queue->semaphore);
+  DestroyPlatformSemaphore(&threadpool->queue->io_semaphore);
+  for (u32 fiber_i = 0; fiber_i < threadpool->fiber_count; fiber_i++)
+    DestroyPlatformFiber(&threadpool->fibers[fiber_i].fiber);
 }
-}  // namespace rally
\ No newline at end of file
+}  // namespace rally
@@ -1,48 +1,180 @@
 #pragma once
 #include <rally/application/application.h>
+#include <rally/container/ringbuffer.h>
+#include <rally/memory/stackallocator.h>
+#include <rally/thread/thread.h>
 #include <rally/types.h>
-#include <windows.h>
+
+#include <atomic>
 
 namespace rally {
 struct Application;
-constexpr u32 kMaxThreadCount = 16;
+constexpr u32 kMaxThreadCount = 64;
+constexpr u32 kMaxIOThreadCount = 8;
+// Capacity of every worker deque and shared ring, must be a power of 2
 constexpr u32 kMaxJobCount = 128;
+constexpr s64 kDefaultFiberStackSize = Kilobytes(64);
+// Bounds of the number of times an idle worker looks for jobs before parking
+constexpr u32 kMinIdleSpins = 16;
+constexpr u32 kMaxIdleSpins = 1024;
 struct ThreadPool;
+struct JobCounter;
+// Idle workers look for high, then normal, then background jobs. Normal is
+// zero so jobs that leave priority out keep the default.
+enum class JobPriority : u32 {
+  kNormal = 0,
+  kHigh = 1,
+  // Long-running work, at most background_limit threads run these at once
+  kBackground = 2,
+  // Blocking work such as file reads, runs on IO threads only. Treated as
+  // background when the pool has no IO threads.
+  kIO = 3,
+};
+constexpr u32 kJobPriorityCount = 4;
 struct Job {
   job_func callback;
   void* data;
+  // Optional, signalled once the job has completed
+  JobCounter* counter;
+  JobPriority priority;
+};
+// Fork-join counter, continuation is pushed once value drops to zero
+struct JobCounter {
+  std::atomic<u32> value;
+  Job continuation;
 };
 enum class PerformNextJobResponse : u32 {
   kShouldSleep = 0,
   kCompletedJob = 1,
   kFailedToSecureJob = 2,
 };
+// Chase-Lev work-stealing deque: the owning worker pushes and takes at the
+// bottom, other threads steal from the top
+struct WorkDeque {
+  alignas(kCacheLineSize) std::atomic<i64> top;
+  alignas(kCacheLineSize) std::atomic<i64> bottom;
+  alignas(kCacheLineSize) Job jobs[kMaxJobCount];
+};
+// One shared ring per priority. Normal jobs pushed by workers go to their own
+// deque instead.
 struct JobQueue {
-  volatile u32 front;
-  volatile u32 end;
-  volatile u32 completion_goal;
-  volatile u32 completion_count;
-  volatile b32 active;
-  Job jobs[kMaxJobCount];
-  HANDLE semaphore;
+  MpmcRing<Job> rings[kJobPriorityCount];
+  alignas(kCacheLineSize) std::atomic<u64> completion_goal;
+  alignas(kCacheLineSize) std::atomic<u64> completion_count;
+  // Threads currently running background jobs
+  alignas(kCacheLineSize) std::atomic<u32> background_count;
+  u32 background_limit;
+  // Threads parked, or about to park, on semaphore and io_semaphore. Pushes
+  // only signal a semaphore when someone is asleep.
+  alignas(kCacheLineSize) std::atomic<u32> sleeping_count;
+  std::atomic<u32> io_sleeping_count;
+  // Semaphore signals and waits since creation
+  alignas(kCacheLineSize) std::atomic<u64> wake_count;
+  std::atomic<u64> park_count;
+  b32 low_power_idle;
+  std::atomic<b32> active;
+  Semaphore semaphore;
+  Semaphore io_semaphore;
+  ThreadPool* threadpool;
+};
+enum class JobFiberState : u32 {
+  kFree = 0,
+  kRunning = 1,
+  kWaiting = 2,
+};
+// Fiber running a worker loop. A job waiting for a counter keeps its fiber
+// parked in kWaiting while the worker continues on a free fiber.
+struct JobFiber {
+  Fiber fiber;
+  ThreadPool* threadpool;
+  std::atomic<JobFiberState> state;
+  JobCounter* wait_counter;
 };
 struct ThreadInfo {
   u32 thread_id;
   ThreadPool* threadpool;
+  WorkDeque* deque;
+  u32 random_state;
+  // Spins before parking, adapts to how often spinning finds work
+  u32 spin_limit;
+  // Linear arena for job temporaries, reset on first use in a new frame
+  StackAllocator* scratch;
+  u64 scratch_frame;
+  // Fiber mode only
+  Fiber thread_fiber;
+  JobFiber* current_fiber;
+  // Fiber switched away from, its state is published once the switch is done
+  JobFiber* pending_fiber;
+  JobFiberState pending_state;
 };
 struct ThreadPool {
   u32 thread_count;
+  u32 io_thread_count;
   JobQueue* queue;
-  HANDLE thread_handles[kMaxThreadCount];
+  JobFiber* fibers;
+  u32 fiber_count;
+  std::atomic<u64> frame;
+  Thread threads[kMaxThreadCount];
+  Thread io_threads[kMaxIOThreadCount];
   ThreadInfo thread_infos[kMaxThreadCount];
+  ThreadInfo io_thread_infos[kMaxIOThreadCount];
+  // Thread that created the pool, only its scratch arena is used
+  ThreadInfo main_thread_info;
 };
 struct ThreadPoolCreateInfo {
   u32 thread_count;
+  // Pin worker i to logical processor i+1, leaving processor 0 to the main
+  // thread. Wraps around when there are more workers than processors.
+  b32 pin_threads;
+  // Run jobs on fibers when non-zero, WaitJobCounter inside a job then parks
+  // the job instead of nesting other jobs on its stack. Needs at least one
+  // fiber per worker, stacks come from the application allocator.
+  u32 fiber_count;
+  s64 fiber_stack_size;  // kDefaultFiberStackSize when zero
+  // Normal priority ring capacity, rounded up to a power of 2 of at least 2
+  // and kMaxJobCount when zero. The ring does not grow: while it is full,
+  // PushJob runs queued jobs on the pushing thread (see PushJob). Size it
+  // for the most normal jobs pushed by non-worker threads and not yet
+  // started at any one time, e.g. the largest PushJobs batch plus the
+  // continuations it can release. Background and IO rings hold kMaxJobCount.
+  u32 job_capacity;
+  // Threads serving kIO jobs, separate from thread_count
+  u32 io_thread_count;
+  // Threads allowed to run background jobs at once, so the rest stay free for
+  // frame work. Half the workers and at least one when zero.
+  u32 background_limit;
+  // Park idle workers without spinning first, trading wake latency for power
+  b32 low_power_idle;
+  // Size of the scratch arena of every pool thread and of the creating thread,
+  // no scratch arenas when zero
+  s64 scratch_size;
 };
 bool CreateThreadPool(ThreadPoolCreateInfo* thread_pool_ci,
                       Application* thread_pool);
+// Safe to call from any thread, including from inside jobs. Never fails: when
+// the job's ring is full the calling thread performs queued jobs of any
+// priority until there is room, which can take as long as those jobs run.
+// Threads with latency budgets, like the main or render thread, should not
+// push into a ring that can fill, size job_capacity instead.
 void PushJob(JobQueue* queue, Job job);
+// Wakes at most job_count parked workers once all jobs are pushed. Performs
+// queued jobs while a ring is full, like PushJob.
 void PushJobs(JobQueue* queue, Job* jobs_head, u32 job_count);
 void WaitThreadQueue(JobQueue* queue);
+// Counters must be set before any job referencing them is pushed, a null
+// continuation callback means nothing is pushed when the counter hits zero
+void SetJobCounter(JobCounter* counter, u32 value, Job continuation);
+// Decrement counter, pushing its continuation if it reached zero
+void SignalJobCounter(JobQueue* queue, JobCounter* counter);
+// Perform jobs until counter reaches zero. Jobs running on fibers are parked
+// instead and resumed by any worker once the counter reaches zero.
+void WaitJobCounter(JobQueue* queue, JobCounter* counter);
+// Scratch arena of the calling pool thread, or of the thread that created the
+// pool when called from elsewhere. Allocations stay valid until the end of the
+// frame and are never freed individually. Fetch it again after waiting on a
+// counter, parked jobs may resume on another worker. Null without scratch.
+StackAllocator* GetJobScratch(JobQueue* queue);
+// Start a new frame, scratch allocations of earlier frames are released
+void BeginThreadPoolFrame(ThreadPool* thread_pool);
 void DestroyThreadPool(ThreadPool* thread_pool);
-}  // namespace rally
\ No newline at end of file
+}  // namespace rally
@@ -2,15 +2,19 @@
 #include <stdint.h>
 
 namespace rally {
+typedef uint16_t u16;
 typedef uint32_t u32;
 typedef uint64_t s64;
 typedef uint64_t u64;
+typedef int16_t i16;
 typedef int32_t i32;
+typedef int64_t i64;
 typedef int32_t b32;
 typedef float r32;
 typedef double r64;
 typedef bool (*job_func)(void*);
 constexpr r32 kPi = 3.14159265359f;
+constexpr u32 kCacheLineSize = 64;
 inline constexpr s64 Kilobytes(s64 x) { return x * 1024; }
 inline constexpr s64 Megabytes(s64 x) { return x * 1024 * 1024; }
 inline constexpr s64 Gigabytes(s64 x) { return x * 1024 * 1024 * 1024; }
@@ -61,8 +61,7 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
   return DefWindowProcW(hwnd, uMsg, wParam, lParam);
 }
 bool CreateWin32Window(WindowCreateInfo* window_ci, Application* app) {
-  Window* window =
-      (Window*)StackAllocate(app->alloc, sizeof(Window), alignof(Window));
+  Window* window = SALLOCZ(app->alloc, Window, 1);
   app->window = window;
   HINSTANCE instance = GetModuleHandleW(NULL);
 
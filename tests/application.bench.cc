@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+#include <rally/application/application.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+constexpr s64 kAppMemorySize = Gigabytes(1);
+constexpr s64 kHeapSize = Megabytes(256);
+
+// Resident set size of the process, 0 where /proc is unavailable
+static s64 GetResidentSize() {
+  s64 resident_pages = 0;
+#ifdef __linux__
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return 0;
+  long long size_pages = 0;
+  long long rss_pages = 0;
+  if (fscanf(statm, "%lld %lld", &size_pages, &rss_pages) == 2)
+    resident_pages = rss_pages;
+  fclose(statm);
+#endif
+  return resident_pages * Kilobytes(4);
+}
+
+// Headless application with the heap and thread pool of the examples, arg is
+// 0 for a caller-provided block and 1 for a reserved virtual arena
+static void BM_CreateApplication(benchmark::State& state) {
+  b32 virtual_arena = state.range(0) != 0;
+  ThreadPoolCreateInfo thread_ci{2};
+  ApplicationCreateInfo app_ci{&thread_ci, nullptr, nullptr,
+                               nullptr,    nullptr, kHeapSize};
+  s64 resident_growth = 0;
+  for (auto _ : state) {
+    void* data = virtual_arena ? nullptr : malloc(kAppMemorySize);
+    s64 resident0 = GetResidentSize();
+    Application* app = CreateApplication(&app_ci, data, kAppMemorySize);
+    resident_growth = GetResidentSize() - resident0;
+    benchmark::DoNotOptimize(app);
+    state.PauseTiming();
+    DestroyApplication(app);
+    free(data);
+    state.ResumeTiming();
+  }
+  state.counters["rss_mb"] = (double)resident_growth / Megabytes(1);
+}
+BENCHMARK(BM_CreateApplication)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
\ No newline at end of file
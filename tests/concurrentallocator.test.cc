@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <rally/memory/concurrentallocator.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+struct ConcurrentRecord {
+  char* data;
+  rally::s64 size;
+  rally::s64 align;
+};
+// Each thread fills its allocations with its own byte, overlapping
+// allocations would be overwritten by another thread
+void AllocateRecords(rally::ConcurrentAllocator* alloc, char fill,
+                     rally::u32 alloc_count,
+                     std::vector<ConcurrentRecord>* records) {
+  rally::u32 random_state = fill * 2654435761u + 1;
+  for (rally::u32 alloc_i = 0; alloc_i < alloc_count; alloc_i++) {
+    random_state = random_state * 1664525u + 1013904223u;
+    rally::s64 size = 1 + (random_state >> 8) % 200;
+    rally::s64 align = (rally::s64)1 << ((random_state >> 24) % 7);
+    char* data = (char*)rally::ConcurrentAllocate(alloc, size, align);
+    if (data == nullptr) return;
+    memset(data, fill, size);
+    records->push_back({data, size, align});
+  }
+}
+}  // namespace
+
+TEST(ConcurrentAllocator, ConcurrentAllocate) {
+  rally::s64 mem_size = rally::Megabytes(16);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::ConcurrentAllocator* alloc =
+      rally::CreateConcurrentAllocator(stack_allocator, rally::Megabytes(8));
+  ASSERT_NE(alloc, nullptr);
+  constexpr rally::u32 kThreadCount = 8;
+  constexpr rally::u32 kAllocCount = 4096;
+  std::vector<ConcurrentRecord> records[kThreadCount];
+  std::vector<std::thread> threads;
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++)
+    threads.emplace_back(AllocateRecords, alloc, (char)(thread_i + 1),
+                         kAllocCount, &records[thread_i]);
+  for (std::thread& thread : threads) thread.join();
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++) {
+    ASSERT_EQ(records[thread_i].size(), kAllocCount);
+    for (const ConcurrentRecord& record : records[thread_i]) {
+      EXPECT_EQ((uintptr_t)record.data % record.align, 0u);
+      for (rally::s64 byte_i = 0; byte_i < record.size; byte_i++)
+        ASSERT_EQ(record.data[byte_i], (char)(thread_i + 1));
+    }
+  }
+  // Everything fit in the first block
+  EXPECT_EQ(alloc->first->next, nullptr);
+  free(mem);
+}
+
+TEST(ConcurrentAllocator, OverflowBlocks) {
+  rally::s64 mem_size = rally::Megabytes(4);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::ConcurrentAllocator* alloc =
+      rally::CreateConcurrentAllocator(stack_allocator, rally::Kilobytes(16));
+  ASSERT_NE(alloc, nullptr);
+  constexpr rally::u32 kThreadCount = 8;
+  constexpr rally::u32 kAllocCount = 1024;
+  std::vector<ConcurrentRecord> records[kThreadCount];
+  std::vector<std::thread> threads;
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++)
+    threads.emplace_back(AllocateRecords, alloc, (char)(thread_i + 1),
+                         kAllocCount, &records[thread_i]);
+  for (std::thread& thread : threads) thread.join();
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++) {
+    ASSERT_EQ(records[thread_i].size(), kAllocCount);
+    for (const ConcurrentRecord& record : records[thread_i]) {
+      EXPECT_EQ((uintptr_t)record.data % record.align, 0u);
+      for (rally::s64 byte_i = 0; byte_i < record.size; byte_i++)
+        ASSERT_EQ(record.data[byte_i], (char)(thread_i + 1));
+    }
+  }
+  rally::u32 block_count = 0;
+  for (rally::ConcurrentBlock* block = alloc->first; block != nullptr;
+       block = block->next)
+    block_count++;
+  EXPECT_GT(block_count, 1u);
+  // Allocations larger than a block get a block of their own
+  char* large = (char*)rally::ConcurrentAllocate(alloc, rally::Kilobytes(64),
+                                                 alignof(char));
+  ASSERT_NE(large, nullptr);
+  // Parent exhausted
+  EXPECT_EQ(rally::ConcurrentAllocate(alloc, rally::Megabytes(8), 1), nullptr);
+  free(mem);
+}
+
+TEST(ConcurrentAllocator, ResetConcurrentAllocator) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::ConcurrentAllocator* alloc =
+      rally::CreateConcurrentAllocator(stack_allocator, rally::Kilobytes(4));
+  ASSERT_NE(alloc, nullptr);
+  int* a = CALLOC(alloc, int, 100);
+  a[10] = 7;
+  for (rally::u32 alloc_i = 0; alloc_i < 64; alloc_i++)
+    CALLOC(alloc, int, 100);
+  rally::s64 occupied0 = stack_allocator->occupied;
+  rally::ResetConcurrentAllocator(alloc);
+  EXPECT_EQ(alloc->current.load(), alloc->first);
+  int* b = CALLOC(alloc, int, 100);
+  EXPECT_EQ(b, a);
+  // Overflow blocks from before the reset are reused
+  for (rally::u32 alloc_i = 0; alloc_i < 64; alloc_i++)
+    CALLOC(alloc, int, 100);
+  EXPECT_EQ(stack_allocator->occupied, occupied0);
+  free(mem);
+}
\ No newline at end of file
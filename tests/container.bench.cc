@@ -0,0 +1,197 @@
+#include <benchmark/benchmark.h>
+#include <rally/container/fixedvector.h>
+#include <rally/container/hashmap.h>
+#include <rally/container/ringbuffer.h>
+#include <stdlib.h>
+
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace rally;
+
+constexpr u32 kItemCount = 4096;
+
+// Container storage comes from one stack, reset every benchmark
+struct ContainerBench {
+  void* mem;
+  StackAllocator* alloc;
+};
+static void CreateContainerBench(ContainerBench* bench) {
+  s64 mem_size = Megabytes(4);
+  bench->mem = malloc(mem_size);
+  bench->alloc = CreateStackAllocator(bench->mem, mem_size);
+}
+
+static void BM_FixedVectorPush(benchmark::State& state) {
+  ContainerBench bench;
+  CreateContainerBench(&bench);
+  FixedVector<u32> vec;
+  CreateFixedVector(bench.alloc, kItemCount, &vec);
+  for (auto _ : state) {
+    ClearFixedVector(&vec);
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      PushFixedVector(&vec, item_i);
+    benchmark::DoNotOptimize(vec.data);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+  free(bench.mem);
+}
+BENCHMARK(BM_FixedVectorPush);
+
+static void BM_StdVectorPush(benchmark::State& state) {
+  std::vector<u32> vec;
+  vec.reserve(kItemCount);
+  for (auto _ : state) {
+    vec.clear();
+    for (u32 item_i = 0; item_i < kItemCount; item_i++) vec.push_back(item_i);
+    benchmark::DoNotOptimize(vec.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+}
+BENCHMARK(BM_StdVectorPush);
+
+static void BM_SpscRingPushPop(benchmark::State& state) {
+  ContainerBench bench;
+  CreateContainerBench(&bench);
+  SpscRing<u64> ring;
+  CreateSpscRing(bench.alloc, kItemCount, &ring);
+  u64 value = 0;
+  for (auto _ : state) {
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      PushSpscRing(&ring, (u64)item_i);
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      PopSpscRing(&ring, &value);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+  free(bench.mem);
+}
+BENCHMARK(BM_SpscRingPushPop);
+
+static void BM_MpmcRingPushPop(benchmark::State& state) {
+  ContainerBench bench;
+  CreateContainerBench(&bench);
+  MpmcRing<u64> ring;
+  CreateMpmcRing(bench.alloc, kItemCount, &ring);
+  u64 value = 0;
+  for (auto _ : state) {
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      PushMpmcRing(&ring, (u64)item_i);
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      PopMpmcRing(&ring, &value);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+  free(bench.mem);
+}
+BENCHMARK(BM_MpmcRingPushPop);
+
+static void BM_StdQueuePushPop(benchmark::State& state) {
+  std::queue<u64> queue;
+  std::mutex mutex;
+  u64 value = 0;
+  for (auto _ : state) {
+    for (u32 item_i = 0; item_i < kItemCount; item_i++) {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push(item_i);
+    }
+    for (u32 item_i = 0; item_i < kItemCount; item_i++) {
+      std::lock_guard<std::mutex> lock(mutex);
+      value = queue.front();
+      queue.pop();
+    }
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+}
+BENCHMARK(BM_StdQueuePushPop);
+
+// Producer thread hands kItemCount values to the benchmark thread
+static void BM_SpscRingHandoff(benchmark::State& state) {
+  ContainerBench bench;
+  CreateContainerBench(&bench);
+  SpscRing<u64> ring;
+  CreateSpscRing(bench.alloc, 1024, &ring);
+  u64 value = 0;
+  for (auto _ : state) {
+    std::thread producer([&] {
+      for (u32 item_i = 0; item_i < kItemCount; item_i++)
+        while (PushSpscRing(&ring, (u64)item_i)) std::this_thread::yield();
+    });
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      while (PopSpscRing(&ring, &value)) std::this_thread::yield();
+    producer.join();
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+  free(bench.mem);
+}
+BENCHMARK(BM_SpscRingHandoff)->UseRealTime();
+
+static void BM_StdQueueHandoff(benchmark::State& state) {
+  std::queue<u64> queue;
+  std::mutex mutex;
+  u64 value = 0;
+  for (auto _ : state) {
+    std::thread producer([&] {
+      for (u32 item_i = 0; item_i < kItemCount; item_i++) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push(item_i);
+      }
+    });
+    for (u32 item_i = 0; item_i < kItemCount;) {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (queue.empty()) {
+        lock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+      value = queue.front();
+      queue.pop();
+      item_i++;
+    }
+    producer.join();
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+}
+BENCHMARK(BM_StdQueueHandoff)->UseRealTime();
+
+// Insert kItemCount scattered keys, then look each up
+static void BM_HashMapInsertFind(benchmark::State& state) {
+  ContainerBench bench;
+  CreateContainerBench(&bench);
+  HashMap<u32, u32> map;
+  CreateHashMap(bench.alloc, kItemCount, &map);
+  for (auto _ : state) {
+    ClearHashMap(&map);
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      InsertHashMap(&map, item_i * 2654435761u, item_i);
+    u32 sum = 0;
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      sum += *FindHashMap(&map, item_i * 2654435761u);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+  free(bench.mem);
+}
+BENCHMARK(BM_HashMapInsertFind);
+
+static void BM_StdUnorderedMapInsertFind(benchmark::State& state) {
+  std::unordered_map<u32, u32> map;
+  map.reserve(kItemCount);
+  for (auto _ : state) {
+    map.clear();
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      map[item_i * 2654435761u] = item_i;
+    u32 sum = 0;
+    for (u32 item_i = 0; item_i < kItemCount; item_i++)
+      sum += map.find(item_i * 2654435761u)->second;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kItemCount);
+}
+BENCHMARK(BM_StdUnorderedMapInsertFind);
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <rally/container/fixedvector.h>
+#include <rally/container/hashmap.h>
+#include <rally/container/ringbuffer.h>
+
+#include <thread>
+#include <vector>
+
+TEST(Container, FixedVector) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::FixedVector<rally::u32> vec;
+  ASSERT_FALSE(rally::CreateFixedVector(stack_allocator, 8, &vec));
+  EXPECT_EQ(((char*)vec.data - (char*)mem) % rally::kCacheLineSize, 0);
+  for (rally::u32 value = 0; value < 8; value++)
+    EXPECT_NE(rally::PushFixedVector(&vec, value * 10), nullptr);
+  EXPECT_EQ(rally::PushFixedVector(&vec, 80u), nullptr);
+  EXPECT_EQ(vec.count, 8u);
+  EXPECT_EQ(*rally::GetFixedVector(&vec, 3), 30u);
+  rally::SwapRemoveFixedVector(&vec, 3);
+  EXPECT_EQ(*rally::GetFixedVector(&vec, 3), 70u);
+  rally::u32 value = 0;
+  EXPECT_FALSE(rally::PopFixedVector(&vec, &value));
+  EXPECT_EQ(value, 60u);
+  EXPECT_EQ(vec.count, 6u);
+  rally::ClearFixedVector(&vec);
+  EXPECT_TRUE(rally::PopFixedVector(&vec, &value));
+  // Out of memory
+  rally::FixedVector<rally::u32> large;
+  EXPECT_TRUE(rally::CreateFixedVector(stack_allocator, 1 << 20, &large));
+  EXPECT_EQ(large.capacity, 0u);
+  free(mem);
+}
+
+TEST(Container, SpscRing) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::SpscRing<rally::u64> ring;
+  ASSERT_FALSE(rally::CreateSpscRing(stack_allocator, 64, &ring));
+  for (rally::u64 value = 0; value < 64; value++)
+    EXPECT_FALSE(rally::PushSpscRing(&ring, value));
+  EXPECT_TRUE(rally::PushSpscRing(&ring, (rally::u64)64));
+  rally::u64 value = 0;
+  EXPECT_FALSE(rally::PopSpscRing(&ring, &value));
+  EXPECT_EQ(value, 0u);
+  // Producer and consumer threads, values arrive in order
+  constexpr rally::u64 kValueCount = 200000;
+  std::thread producer([&] {
+    for (rally::u64 value = 64; value < kValueCount; value++)
+      while (rally::PushSpscRing(&ring, value)) std::this_thread::yield();
+  });
+  rally::u64 expected = 1;
+  while (expected < kValueCount) {
+    if (rally::PopSpscRing(&ring, &value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(value, expected);
+    expected++;
+  }
+  producer.join();
+  EXPECT_TRUE(rally::PopSpscRing(&ring, &value));
+  free(mem);
+}
+
+TEST(Container, MpmcRing) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::MpmcRing<rally::u64> ring;
+  ASSERT_FALSE(rally::CreateMpmcRing(stack_allocator, 256, &ring));
+  constexpr rally::u32 kThreadCount = 4;
+  constexpr rally::u64 kValueCount = 50000;
+  std::atomic<rally::u64> sums[kThreadCount] = {};
+  std::atomic<rally::u64> popped_count = 0;
+  std::vector<std::thread> threads;
+  // Producers push 1..kValueCount each, consumers sum what they pop
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++) {
+    threads.emplace_back([&] {
+      for (rally::u64 value = 1; value <= kValueCount; value++)
+        while (rally::PushMpmcRing(&ring, value)) std::this_thread::yield();
+    });
+    threads.emplace_back([&, thread_i] {
+      rally::u64 value;
+      while (popped_count.load() < kThreadCount * kValueCount) {
+        if (rally::PopMpmcRing(&ring, &value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        sums[thread_i] += value;
+        popped_count++;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  rally::u64 sum = 0;
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++)
+    sum += sums[thread_i].load();
+  EXPECT_EQ(sum, kThreadCount * kValueCount * (kValueCount + 1) / 2);
+  rally::u64 value;
+  EXPECT_TRUE(rally::PopMpmcRing(&ring, &value));
+  free(mem);
+}
+
+TEST(Container, HashMap) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  constexpr rally::u32 kCapacity = 1000;
+  rally::HashMap<rally::u32, rally::u32> map;
+  ASSERT_FALSE(rally::CreateHashMap(stack_allocator, kCapacity, &map));
+  EXPECT_EQ(rally::FindHashMap(&map, 5u), nullptr);
+  // Keys with colliding low bits probe past each other
+  for (rally::u32 key_i = 0; key_i < kCapacity; key_i++)
+    ASSERT_NE(rally::InsertHashMap(&map, key_i * 1024, key_i), nullptr);
+  EXPECT_EQ(rally::InsertHashMap(&map, 7u, 7u), nullptr);
+  EXPECT_EQ(map.count, kCapacity);
+  for (rally::u32 key_i = 0; key_i < kCapacity; key_i++) {
+    rally::u32* value = rally::FindHashMap(&map, key_i * 1024);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, key_i);
+  }
+  // Overwriting works when full
+  EXPECT_NE(rally::InsertHashMap(&map, 1024u, 99u), nullptr);
+  EXPECT_EQ(*rally::FindHashMap(&map, 1024u), 99u);
+  EXPECT_EQ(map.count, kCapacity);
+  // Remove every other key, the rest stay reachable
+  for (rally::u32 key_i = 0; key_i < kCapacity; key_i += 2)
+    EXPECT_FALSE(rally::RemoveHashMap(&map, key_i * 1024));
+  EXPECT_TRUE(rally::RemoveHashMap(&map, 0u));
+  EXPECT_EQ(map.count, kCapacity / 2);
+  for (rally::u32 key_i = 0; key_i < kCapacity; key_i++) {
+    rally::u32* value = rally::FindHashMap(&map, key_i * 1024);
+    if (key_i % 2 == 0) {
+      EXPECT_EQ(value, nullptr);
+    } else {
+      ASSERT_NE(value, nullptr);
+      EXPECT_EQ(*value, key_i == 1 ? 99u : key_i);
+    }
+  }
+  rally::ClearHashMap(&map);
+  EXPECT_EQ(rally::FindHashMap(&map, 1024u), nullptr);
+  // Pointer keys
+  rally::HashMap<int*, float> pointer_map;
+  ASSERT_FALSE(rally::CreateHashMap(stack_allocator, 16, &pointer_map));
+  int ints[4];
+  rally::InsertHashMap(&pointer_map, &ints[2], 2.0f);
+  EXPECT_EQ(*rally::FindHashMap(&pointer_map, &ints[2]), 2.0f);
+  EXPECT_EQ(rally::FindHashMap(&pointer_map, &ints[1]), nullptr);
+  free(mem);
+}
\ No newline at end of file
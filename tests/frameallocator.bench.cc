@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <rally/memory/frameallocator.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace rally;
+
+constexpr u32 kMaxEntities = 65536;
+constexpr u32 kFrameCount = 3;
+
+// Stand-in for the renderer's per-frame instance descriptors
+struct BenchInstance {
+  r32 transform[3][4];
+  u32 instance_id;
+  u32 mask;
+  u64 acceleration_structure;
+};
+static void FillInstances(BenchInstance* instances, u32 entity_count) {
+  for (u32 entity_i = 0; entity_i < entity_count; entity_i++) {
+    instances[entity_i].transform[0][0] = (r32)entity_i;
+    instances[entity_i].instance_id = entity_i;
+    instances[entity_i].mask = 1;
+  }
+}
+
+// Arrays preallocated at kMaxEntities per frame, arg is entity count
+static void BM_StaticFrameArrays(benchmark::State& state) {
+  u32 entity_count = (u32)state.range(0);
+  s64 mem_size = kFrameCount * kMaxEntities * sizeof(BenchInstance) +
+                 Megabytes(1);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  BenchInstance* instances[kFrameCount];
+  for (u32 frame_i = 0; frame_i < kFrameCount; frame_i++)
+    instances[frame_i] = SALLOC(stack_allocator, BenchInstance, kMaxEntities);
+  void* upload = malloc(kMaxEntities * sizeof(BenchInstance));
+  u32 frame_i = 0;
+  for (auto _ : state) {
+    FillInstances(instances[frame_i], entity_count);
+    memcpy(upload, instances[frame_i], entity_count * sizeof(BenchInstance));
+    benchmark::ClobberMemory();
+    frame_i = (frame_i + 1) % kFrameCount;
+  }
+  state.counters["reserved_bytes"] =
+      (r64)(kFrameCount * kMaxEntities * sizeof(BenchInstance));
+  free(upload);
+  free(mem);
+}
+BENCHMARK(BM_StaticFrameArrays)->Arg(256)->Arg(4096)->Arg(65536);
+
+static void BM_FrameAllocatorArrays(benchmark::State& state) {
+  u32 entity_count = (u32)state.range(0);
+  s64 frame_size = kMaxEntities * sizeof(BenchInstance) + Kilobytes(4);
+  s64 mem_size = kFrameCount * frame_size + Megabytes(1);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  FrameAllocator* frame_alloc =
+      CreateFrameAllocator(stack_allocator, kFrameCount, frame_size);
+  void* upload = malloc(kMaxEntities * sizeof(BenchInstance));
+  u32 frame_i = 0;
+  for (auto _ : state) {
+    BeginAllocatorFrame(frame_alloc, frame_i);
+    BenchInstance* instances = FALLOC(frame_alloc, BenchInstance, entity_count);
+    FillInstances(instances, entity_count);
+    memcpy(upload, instances, entity_count * sizeof(BenchInstance));
+    benchmark::ClobberMemory();
+    frame_i = (frame_i + 1) % kFrameCount;
+  }
+  // Frame size needed for this entity count
+  state.counters["reserved_bytes"] =
+      (r64)(kFrameCount * frame_alloc->peak_size);
+  free(upload);
+  free(mem);
+}
+BENCHMARK(BM_FrameAllocatorArrays)->Arg(256)->Arg(4096)->Arg(65536);
\ No newline at end of file
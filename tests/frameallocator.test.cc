@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <rally/memory/frameallocator.h>
+
+TEST(FrameAllocator, FrameAllocate) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  constexpr rally::u32 kFrameCount = 3;
+  rally::FrameAllocator* frame_alloc = rally::CreateFrameAllocator(
+      stack_allocator, kFrameCount, rally::Kilobytes(16));
+  ASSERT_NE(frame_alloc, nullptr);
+  int* frame_data[kFrameCount];
+  for (rally::u32 frame_i = 0; frame_i < kFrameCount; frame_i++) {
+    rally::BeginAllocatorFrame(frame_alloc, frame_i);
+    frame_data[frame_i] = FALLOC(frame_alloc, int, 100);
+    ASSERT_NE(frame_data[frame_i], nullptr);
+    frame_data[frame_i][10] = frame_i + 1;
+  }
+  // Frames in flight keep their data
+  for (rally::u32 frame_i = 0; frame_i < kFrameCount; frame_i++)
+    EXPECT_EQ(frame_data[frame_i][10], (int)frame_i + 1);
+  // Coming around again frees only that frame
+  rally::BeginAllocatorFrame(frame_alloc, 1);
+  EXPECT_EQ(frame_data[0][10], 1);
+  EXPECT_EQ(frame_data[2][10], 3);
+  int* reused = FALLOC(frame_alloc, int, 100);
+  EXPECT_EQ(reused, frame_data[1]);
+  // Exhausting a frame leaves the others untouched
+  EXPECT_EQ(FALLOC(frame_alloc, char, rally::Kilobytes(16)), nullptr);
+  EXPECT_EQ(frame_data[2][10], 3);
+  EXPECT_GE(frame_alloc->peak_size, sizeof(int) * 100);
+  EXPECT_LT(frame_alloc->peak_size, rally::Kilobytes(16));
+  free(mem);
+}
+
+TEST(FrameAllocator, SizedByUse) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::FrameAllocator* frame_alloc =
+      rally::CreateFrameAllocator(stack_allocator, 2, rally::Kilobytes(64));
+  ASSERT_NE(frame_alloc, nullptr);
+  // Entity count changes from frame to frame, e.g. spawning
+  for (rally::u32 update_i = 0; update_i < 100; update_i++) {
+    rally::u32 entity_count = 1 + update_i * 10;
+    rally::BeginAllocatorFrame(frame_alloc, update_i % 2);
+    float* transforms = FALLOC(frame_alloc, float, entity_count * 16);
+    ASSERT_NE(transforms, nullptr);
+    transforms[entity_count * 16 - 1] = 1.0f;
+  }
+  EXPECT_LT(frame_alloc->peak_size, sizeof(float) * 1000 * 16 + 64);
+  free(mem);
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <rally/memory/heapallocator.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+constexpr u32 kLiveCount = 4096;
+constexpr s64 kMaxAllocSize = 4096;
+
+// Random sizes freed out of order, e.g. resizable scene arrays and streamed
+// assets
+static void BM_HeapChurn(benchmark::State& state) {
+  s64 mem_size = Megabytes(64);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  HeapAllocator* heap = CreateHeapAllocator(stack_allocator, Megabytes(32));
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      HeapFree(heap, live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      s64 size = 1 + (random_state >> 16) % kMaxAllocSize;
+      live[live_i] = HeapAllocate(heap, size, alignof(s64));
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  HeapStats stats;
+  GetHeapStats(heap, &stats);
+  state.counters["fragmentation"] = stats.fragmentation;
+  state.counters["free_blocks"] = stats.free_block_count;
+  state.SetItemsProcessed(state.iterations());
+  free(live);
+  free(mem);
+}
+BENCHMARK(BM_HeapChurn);
+
+static void BM_HeapMallocChurn(benchmark::State& state) {
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      free(live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      // Zeroed like HeapAllocate
+      s64 size = 1 + (random_state >> 16) % kMaxAllocSize;
+      live[live_i] = calloc(1, size);
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  for (u32 live_i = 0; live_i < kLiveCount; live_i++) free(live[live_i]);
+  free(live);
+}
+BENCHMARK(BM_HeapMallocChurn);
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <rally/application/application.h>
+#include <rally/memory/heapallocator.h>
+
+TEST(HeapAllocator, HeapAllocate) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::HeapAllocator* heap =
+      rally::CreateHeapAllocator(stack_allocator, rally::Kilobytes(512));
+  ASSERT_NE(heap, nullptr);
+  rally::HeapStats stats;
+  rally::GetHeapStats(heap, &stats);
+  EXPECT_EQ(stats.free_block_count, 1u);
+  EXPECT_EQ(stats.fragmentation, 0.0f);
+  rally::s64 free_size0 = stats.free_size;
+  int* a = HALLOC(heap, int, 100);
+  int* b = HALLOC(heap, int, 1000);
+  int* c = HALLOC(heap, int, 10);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  ASSERT_NE(c, nullptr);
+  EXPECT_EQ((uintptr_t)b % rally::kHeapAlign, 0u);
+  EXPECT_EQ(b[999], 0);
+  b[999] = 5;
+  EXPECT_EQ(heap->allocation_count, 3u);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  // Freeing out of order leaves a hole between a and c
+  rally::HeapFree(heap, b);
+  rally::GetHeapStats(heap, &stats);
+  EXPECT_EQ(stats.free_block_count, 2u);
+  EXPECT_GT(stats.fragmentation, 0.0f);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  // Freed memory is reused and zeroed. Requests are rounded up to the next
+  // size class, so only a smaller request is guaranteed to fit the hole.
+  int* d = HALLOC(heap, int, 900);
+  EXPECT_EQ(d, b);
+  EXPECT_EQ(d[899], 0);
+  // Everything merges back into one block
+  rally::HeapFree(heap, a);
+  rally::HeapFree(heap, c);
+  rally::HeapFree(heap, d);
+  rally::GetHeapStats(heap, &stats);
+  EXPECT_EQ(stats.free_block_count, 1u);
+  EXPECT_EQ(stats.free_size, free_size0);
+  EXPECT_EQ(stats.used_size, 0u);
+  EXPECT_EQ(stats.allocation_count, 0u);
+  EXPECT_GE(stats.peak_used_size, sizeof(int) * 1110);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  // Exhaustion
+  EXPECT_EQ(rally::HeapAllocate(heap, rally::Megabytes(1), 16), nullptr);
+  free(mem);
+}
+
+TEST(HeapAllocator, HeapAlignment) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::HeapAllocator* heap =
+      rally::CreateHeapAllocator(stack_allocator, rally::Kilobytes(512));
+  ASSERT_NE(heap, nullptr);
+  void* allocs[32];
+  for (rally::u32 alloc_i = 0; alloc_i < 32; alloc_i++) {
+    rally::s64 align = (rally::s64)1 << (alloc_i % 10);
+    allocs[alloc_i] = rally::HeapAllocate(heap, 24 + alloc_i * 8, align);
+    ASSERT_NE(allocs[alloc_i], nullptr);
+    EXPECT_EQ((uintptr_t)allocs[alloc_i] % align, 0u);
+    ASSERT_FALSE(rally::CheckHeapAllocator(heap));
+  }
+  for (rally::u32 alloc_i = 0; alloc_i < 32; alloc_i += 2)
+    rally::HeapFree(heap, allocs[alloc_i]);
+  for (rally::u32 alloc_i = 1; alloc_i < 32; alloc_i += 2)
+    rally::HeapFree(heap, allocs[alloc_i]);
+  rally::HeapStats stats;
+  rally::GetHeapStats(heap, &stats);
+  EXPECT_EQ(stats.free_block_count, 1u);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  free(mem);
+}
+
+TEST(HeapAllocator, HeapReallocate) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::HeapAllocator* heap =
+      rally::CreateHeapAllocator(stack_allocator, rally::Kilobytes(512));
+  ASSERT_NE(heap, nullptr);
+  // Resizable array growing in place into the free space after it
+  int* array = HALLOC(heap, int, 16);
+  array[15] = 15;
+  int* grown = (int*)rally::HeapReallocate(heap, array, sizeof(int) * 256,
+                                           alignof(int));
+  EXPECT_EQ(grown, array);
+  EXPECT_EQ(grown[15], 15);
+  EXPECT_EQ(grown[255], 0);
+  grown[255] = 255;
+  // Shrinking zeroes the released tail
+  int* shrunk = (int*)rally::HeapReallocate(heap, grown, sizeof(int) * 16,
+                                            alignof(int));
+  EXPECT_EQ(shrunk, array);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  // Blocked by a following allocation, the array moves
+  int* blocker = HALLOC(heap, int, 16);
+  int* moved = (int*)rally::HeapReallocate(heap, shrunk, sizeof(int) * 1024,
+                                           alignof(int));
+  ASSERT_NE(moved, nullptr);
+  EXPECT_NE(moved, shrunk);
+  EXPECT_EQ(moved[15], 15);
+  EXPECT_EQ(moved[255], 0);
+  EXPECT_EQ(heap->allocation_count, 2u);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  rally::HeapFree(heap, blocker);
+  rally::HeapFree(heap, moved);
+  EXPECT_EQ(heap->used_size, 0u);
+  free(mem);
+}
+
+TEST(HeapAllocator, HeapChurn) {
+  rally::s64 mem_size = rally::Megabytes(4);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::HeapAllocator* heap =
+      rally::CreateHeapAllocator(stack_allocator, rally::Megabytes(2));
+  ASSERT_NE(heap, nullptr);
+  constexpr rally::u32 kLiveCount = 256;
+  char* live[kLiveCount] = {};
+  rally::s64 live_sizes[kLiveCount] = {};
+  rally::u32 random_state = 1;
+  for (rally::u32 iteration_i = 0; iteration_i < 20000; iteration_i++) {
+    random_state = random_state * 1664525u + 1013904223u;
+    rally::u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      for (rally::s64 byte_i = 0; byte_i < live_sizes[live_i]; byte_i++)
+        ASSERT_EQ(live[live_i][byte_i], (char)live_i);
+      rally::HeapFree(heap, live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      live_sizes[live_i] = 1 + (random_state >> 16) % 4096;
+      live[live_i] = (char*)rally::HeapAllocate(heap, live_sizes[live_i], 8);
+      ASSERT_NE(live[live_i], nullptr);
+      memset(live[live_i], (char)live_i, live_sizes[live_i]);
+    }
+    if (iteration_i % 1000 == 0) {
+      ASSERT_FALSE(rally::CheckHeapAllocator(heap));
+    }
+  }
+  for (rally::u32 live_i = 0; live_i < kLiveCount; live_i++)
+    rally::HeapFree(heap, live[live_i]);
+  rally::HeapStats stats;
+  rally::GetHeapStats(heap, &stats);
+  EXPECT_EQ(stats.free_block_count, 1u);
+  EXPECT_EQ(stats.used_size, 0u);
+  EXPECT_FALSE(rally::CheckHeapAllocator(heap));
+  free(mem);
+}
+
+TEST(HeapAllocator, ApplicationHeap) {
+  rally::s64 data_size = rally::Megabytes(4);
+  void* data = malloc(data_size);
+  rally::ApplicationCreateInfo app_ci{nullptr, nullptr, nullptr, nullptr,
+                                      nullptr, rally::Megabytes(1)};
+  rally::Application* app = rally::CreateApplication(&app_ci, data, data_size);
+  ASSERT_NE(app, nullptr);
+  ASSERT_NE(app->heap, nullptr);
+  EXPECT_NE(HALLOC(app->heap, int, 1000), nullptr);
+  rally::DestroyApplication(app);
+  free(data);
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+#include <rally/thread/jobgraph.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+using namespace rally;
+
+// Busy job standing in for driver work, data is the duration in microseconds
+static bool SpinFor(void* data) {
+  auto start = std::chrono::steady_clock::now();
+  auto duration = std::chrono::microseconds((s64)data);
+  while (std::chrono::steady_clock::now() - start < duration) CpuRelax();
+  return false;
+}
+
+// Synthetic CreateRenderer startup, durations roughly follow the real jobs
+enum RendererStage : u32 {
+  kCommandQueue,
+  kCommandAllocators,
+  kFences,
+  kRootSignatures,
+  kDescriptorHeaps,
+  kSwapchain,
+  kCommandLists,
+  kOutputBuffers,
+  kPipeline,
+  kGeometry,
+  kHitgroup,
+  kBeginFrame,
+  kAccelerationStructures,
+  kShaderTables,
+  kStageCount,
+};
+static const s64 kStageMicroseconds[kStageCount] = {
+    50, 20, 10, 200, 10, 300, 20, 50, 1000, 400, 100, 10, 500, 100};
+
+static Job StageJob(RendererStage stage) {
+  return {SpinFor, (void*)kStageMicroseconds[stage]};
+}
+
+static Application* CreateBenchApplication(benchmark::State& state,
+                                           void* data, s64 data_size) {
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  return CreateApplication(&app_ci, data, data_size);
+}
+
+// Stages separated by full barriers, as CreateRenderer used to run
+static void BM_RendererStartupBarriers(benchmark::State& state) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  Application* app = CreateBenchApplication(state, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  const RendererStage stages[] = {
+      kCommandQueue, kCommandAllocators, kFences,   kRootSignatures,
+      kDescriptorHeaps, kSwapchain,      kCommandLists, kOutputBuffers,
+      kPipeline,     kGeometry,          kHitgroup};
+  const u32 stage_sizes[] = {5, 4, 1, 1};
+  for (auto _ : state) {
+    u32 job_i = 0;
+    for (u32 size : stage_sizes) {
+      for (u32 stage_i = 0; stage_i < size; stage_i++)
+        PushJob(queue, StageJob(stages[job_i++]));
+      WaitThreadQueue(queue);
+    }
+    SpinFor((void*)kStageMicroseconds[kBeginFrame]);
+    PushJob(queue, StageJob(kAccelerationStructures));
+    PushJob(queue, StageJob(kShaderTables));
+    WaitThreadQueue(queue);
+  }
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_RendererStartupBarriers)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Same jobs as a dependency graph, bounded by the critical path instead
+static void BM_RendererStartupGraph(benchmark::State& state) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  Application* app = CreateBenchApplication(state, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  JobGraph* graph = CreateJobGraph(app->alloc, kStageCount);
+  JobNode* nodes[kStageCount];
+  for (u32 stage_i = 0; stage_i < kStageCount; stage_i++)
+    nodes[stage_i] = AddJobNode(graph, StageJob((RendererStage)stage_i));
+  AddJobDependency(nodes[kSwapchain], nodes[kCommandQueue]);
+  AddJobDependency(nodes[kCommandLists], nodes[kCommandAllocators]);
+  AddJobDependency(nodes[kOutputBuffers], nodes[kDescriptorHeaps]);
+  AddJobDependency(nodes[kPipeline], nodes[kRootSignatures]);
+  AddJobDependency(nodes[kGeometry], nodes[kDescriptorHeaps]);
+  AddJobDependency(nodes[kHitgroup], nodes[kDescriptorHeaps]);
+  AddJobDependency(nodes[kBeginFrame], nodes[kSwapchain]);
+  AddJobDependency(nodes[kBeginFrame], nodes[kFences]);
+  AddJobDependency(nodes[kBeginFrame], nodes[kCommandLists]);
+  AddJobDependency(nodes[kAccelerationStructures], nodes[kBeginFrame]);
+  AddJobDependency(nodes[kAccelerationStructures], nodes[kGeometry]);
+  AddJobDependency(nodes[kShaderTables], nodes[kBeginFrame]);
+  AddJobDependency(nodes[kShaderTables], nodes[kPipeline]);
+  AddJobDependency(nodes[kShaderTables], nodes[kHitgroup]);
+  for (auto _ : state) RunJobGraph(queue, graph);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_RendererStartupGraph)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <rally/thread/jobgraph.h>
+
+using namespace rally;
+
+struct OrderParams {
+  std::atomic<u32>* sequence;
+  u32 order;
+  b32 fail;
+};
+
+bool RecordOrder(OrderParams* params) {
+  params->order = params->sequence->fetch_add(1);
+  return params->fail;
+}
+
+TEST(JobGraph, DependencyOrder) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+
+  // Layered graph: every node depends on up to three nodes of the layer above
+  constexpr u32 kLayerCount = 4;
+  constexpr u32 kLayerWidth = 6;
+  constexpr u32 kNodeCount = kLayerCount * kLayerWidth;
+  std::atomic<u32> sequence;
+  OrderParams params[kNodeCount];
+  JobGraph* graph = CreateJobGraph(app->alloc, kNodeCount);
+  for (u32 node_i = 0; node_i < kNodeCount; node_i++) {
+    params[node_i] = {&sequence, 0, false};
+    JobNode* node =
+        AddJobNode(graph, {(job_func)RecordOrder, &params[node_i]});
+    if (node_i < kLayerWidth) continue;
+    u32 layer_start = node_i - node_i % kLayerWidth - kLayerWidth;
+    for (u32 dep_i = 0; dep_i < 3; dep_i++) {
+      u32 dependency_i = layer_start + (node_i + dep_i) % kLayerWidth;
+      AddJobDependency(node, &graph->nodes[dependency_i]);
+    }
+  }
+
+  u32 iters = 50;
+  while (iters--) {
+    sequence.store(0);
+    EXPECT_EQ(RunJobGraph(tp->queue, graph), false);
+    EXPECT_EQ(sequence.load(), kNodeCount);
+    for (u32 node_i = 0; node_i < kNodeCount; node_i++) {
+      JobNode* node = &graph->nodes[node_i];
+      for (u32 dep_i = 0; dep_i < node->dependent_count; dep_i++) {
+        OrderParams* dependent =
+            (OrderParams*)node->dependents[dep_i]->job.data;
+        EXPECT_LT(params[node_i].order, dependent->order);
+      }
+    }
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(JobGraph, Failure) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{2};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<u32> sequence;
+  sequence.store(0);
+  OrderParams params[2] = {{&sequence, 0, true}, {&sequence, 0, false}};
+  JobGraph* graph = CreateJobGraph(app->alloc, 2);
+  JobNode* first = AddJobNode(graph, {(job_func)RecordOrder, &params[0]});
+  JobNode* second = AddJobNode(graph, {(job_func)RecordOrder, &params[1]});
+  AddJobDependency(second, first);
+  // Failures are reported, dependents still run
+  EXPECT_EQ(RunJobGraph(tp->queue, graph), true);
+  EXPECT_EQ(sequence.load(), 2);
+  params[0].fail = false;
+  EXPECT_EQ(RunJobGraph(tp->queue, graph), false);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(JobGraph, Priority) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{2};
+  tp_ci.io_thread_count = 1;
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<u32> sequence;
+  sequence.store(0);
+  OrderParams params[kJobPriorityCount];
+  JobGraph* graph = CreateJobGraph(app->alloc, kJobPriorityCount);
+  for (u32 node_i = 0; node_i < kJobPriorityCount; node_i++) {
+    params[node_i] = {&sequence, 0, false};
+    JobNode* node = AddJobNode(graph, {(job_func)RecordOrder, &params[node_i],
+                                       nullptr, (JobPriority)node_i});
+    if (node_i > 0) AddJobDependency(node, &graph->nodes[node_i - 1]);
+  }
+  EXPECT_EQ(RunJobGraph(tp->queue, graph), false);
+  EXPECT_EQ(sequence.load(), kJobPriorityCount);
+  // Nodes are pushed with their own priority
+  for (u32 node_i = 0; node_i < kJobPriorityCount; node_i++) {
+    EXPECT_EQ(graph->nodes[node_i].dependencies.continuation.priority,
+              (JobPriority)node_i);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(JobGraph, OutOfMemory) {
+  alignas(16) char memory[1024];
+  StackAllocator* alloc = CreateStackAllocator(memory, sizeof(memory));
+  EXPECT_EQ(CreateJobGraph(alloc, 16), nullptr);
+  ResetStackAllocator(alloc);
+  s64 occupied = alloc->occupied;
+  JobGraph* graph = CreateJobGraph(alloc, 1);
+  ASSERT_NE(graph, nullptr);
+  DestroyJobGraph(graph);
+  EXPECT_EQ(alloc->occupied, occupied);
+}
+
+struct JoinParams {
+  std::atomic<u32>* finished;
+  u32 finished_at_join;
+};
+
+bool CountFinished(std::atomic<u32>* finished) {
+  finished->fetch_add(1);
+  return false;
+}
+
+bool Join(JoinParams* params) {
+  params->finished_at_join = params->finished->load();
+  return false;
+}
+
+TEST(JobGraph, CounterContinuation) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  constexpr u32 kForkCount = 64;
+  std::atomic<u32> finished;
+  JoinParams join_params;
+  JobCounter fork_counter, join_counter;
+  u32 iters = 50;
+  while (iters--) {
+    finished.store(0);
+    join_params = {&finished, 0};
+    SetJobCounter(&join_counter, 1, {});
+    SetJobCounter(&fork_counter, kForkCount,
+                  {(job_func)Join, &join_params, &join_counter});
+    for (u32 job_i = 0; job_i < kForkCount; job_i++)
+      PushJob(tp->queue, {(job_func)CountFinished, &finished, &fork_counter});
+    WaitJobCounter(tp->queue, &join_counter);
+    EXPECT_EQ(join_params.finished_at_join, kForkCount);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <rally/scene/meshoptimizer.h>
+#include <rally/scene/scene.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+using namespace rally;
+
+// Grid of side x side vertices with shuffled triangles, optionally run
+// through the exporter's optimization passes
+struct BenchGrid {
+  void* mem;
+  Application app;
+  u32* indices;
+  u32 index_count;
+  u32 vertex_count;
+};
+static void CreateBenchGrid(BenchGrid* grid, u32 side, bool optimize) {
+  grid->vertex_count = side * side;
+  grid->index_count = (side - 1) * (side - 1) * 6;
+  s64 mem_size = grid->vertex_count * (s64)(sizeof(Float3) * 2 +
+                                            sizeof(OctNormal) +
+                                            sizeof(TangentFrame) +
+                                            sizeof(HalfUv) + sizeof(u32)) +
+                 grid->index_count * (s64)sizeof(u32) * 4 + Megabytes(1);
+  grid->mem = malloc(mem_size);
+  grid->app = {};
+  grid->app.alloc = CreateStackAllocator(grid->mem, mem_size);
+  SceneCreateInfo scene_ci{};
+  scene_ci.max_vertices = grid->vertex_count;
+  CreateScene(&scene_ci, &grid->app);
+  VertexStreams& vertices = grid->app.scene->resources->vertices;
+  for (u32 vert_i = 0; vert_i < grid->vertex_count; vert_i++)
+    vertices.positions[vert_i] = {(r32)(vert_i % side), (r32)(vert_i / side),
+                                  (r32)(vert_i % 7)};
+  grid->indices = SALLOC(grid->app.alloc, u32, grid->index_count);
+  u32 index_i = 0;
+  for (u32 y = 0; y + 1 < side; y++) {
+    for (u32 x = 0; x + 1 < side; x++) {
+      u32 v = y * side + x;
+      const u32 quad[6] = {v, v + 1, v + side, v + 1, v + side + 1, v + side};
+      for (u32 corner : quad) grid->indices[index_i++] = corner;
+    }
+  }
+  srand(1);
+  for (u32 triangle_i = grid->index_count / 3 - 1; triangle_i > 0;
+       triangle_i--) {
+    u32 swap_i = (u32)rand() % (triangle_i + 1);
+    for (u32 corner_i = 0; corner_i < 3; corner_i++)
+      std::swap(grid->indices[triangle_i * 3 + corner_i],
+                grid->indices[swap_i * 3 + corner_i]);
+  }
+  if (!optimize) return;
+  OptimizeVertexCache(grid->app.alloc, grid->indices, grid->index_count,
+                      grid->vertex_count, kVertexCacheSize);
+  u32 vertex_count;
+  OptimizeVertexFetch(grid->app.alloc, &vertices, 0, grid->vertex_count,
+                      grid->indices, grid->index_count, &vertex_count);
+}
+
+// Sum of twice the triangle areas squared, arg is grid side
+static void TriangleLoop(benchmark::State& state, bool optimize) {
+  BenchGrid grid;
+  CreateBenchGrid(&grid, (u32)state.range(0), optimize);
+  const Float3* positions = grid.app.scene->resources->vertices.positions;
+  for (auto _ : state) {
+    r32 sum = 0.0f;
+    for (u32 index_i = 0; index_i < grid.index_count; index_i += 3) {
+      const Float3& p0 = positions[grid.indices[index_i]];
+      const Float3& p1 = positions[grid.indices[index_i + 1]];
+      const Float3& p2 = positions[grid.indices[index_i + 2]];
+      r32 ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+      r32 fx = p2.x - p0.x, fy = p2.y - p0.y, fz = p2.z - p0.z;
+      r32 cx = ey * fz - ez * fy, cy = ez * fx - ex * fz,
+          cz = ex * fy - ey * fx;
+      sum += cx * cx + cy * cy + cz * cz;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  VertexCacheStats stats;
+  AnalyzeVertexCache(grid.app.alloc, grid.indices, grid.index_count,
+                     grid.vertex_count, kVertexCacheSize, &stats);
+  state.counters["acmr"] = stats.acmr;
+  free(grid.mem);
+}
+static void BM_TrianglesShuffled(benchmark::State& state) {
+  TriangleLoop(state, false);
+}
+BENCHMARK(BM_TrianglesShuffled)->Arg(257)->Arg(1025);
+static void BM_TrianglesOptimized(benchmark::State& state) {
+  TriangleLoop(state, true);
+}
+BENCHMARK(BM_TrianglesOptimized)->Arg(257)->Arg(1025);
+
+// Cost of the exporter pass itself
+static void BM_OptimizeVertexCache(benchmark::State& state) {
+  BenchGrid grid;
+  CreateBenchGrid(&grid, (u32)state.range(0), false);
+  u32* shuffled = (u32*)malloc(grid.index_count * sizeof(u32));
+  memcpy(shuffled, grid.indices, grid.index_count * sizeof(u32));
+  for (auto _ : state) {
+    memcpy(grid.indices, shuffled, grid.index_count * sizeof(u32));
+    OptimizeVertexCache(grid.app.alloc, grid.indices, grid.index_count,
+                        grid.vertex_count, kVertexCacheSize);
+  }
+  state.SetItemsProcessed(state.iterations() * grid.index_count / 3);
+  free(shuffled);
+  free(grid.mem);
+}
+BENCHMARK(BM_OptimizeVertexCache)->Arg(257)->Arg(1025);
\ No newline at end of file
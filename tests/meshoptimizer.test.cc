@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <rally/scene/meshoptimizer.h>
+#include <rally/scene/scene.h>
+
+#include <algorithm>
+
+#include "testrandom.h"
+
+using namespace rally;
+
+// Triangulated grid of side x side vertices with its triangles shuffled,
+// returns the index count
+static u32 CreateShuffledGrid(u32 side, u32* indices) {
+  u32 index_count = 0;
+  for (u32 y = 0; y + 1 < side; y++) {
+    for (u32 x = 0; x + 1 < side; x++) {
+      u32 v = y * side + x;
+      const u32 quad[6] = {v, v + 1, v + side, v + 1, v + side + 1, v + side};
+      for (u32 corner : quad) indices[index_count++] = corner;
+    }
+  }
+  u32 triangle_count = index_count / 3;
+  for (u32 triangle_i = triangle_count - 1; triangle_i > 0; triangle_i--) {
+    u32 swap_i = (Rand() << 15 | Rand()) % (triangle_i + 1);
+    for (u32 corner_i = 0; corner_i < 3; corner_i++)
+      std::swap(indices[triangle_i * 3 + corner_i],
+                indices[swap_i * 3 + corner_i]);
+  }
+  return index_count;
+}
+// Triangles rotated to start at their smallest index, keeps winding
+static void SortTriangles(const u32* indices, u32 index_count, u64* out) {
+  for (u32 index_i = 0; index_i < index_count; index_i += 3) {
+    const u32* t = indices + index_i;
+    u32 first = t[0] < t[1] ? (t[0] < t[2] ? 0 : 2) : (t[1] < t[2] ? 1 : 2);
+    out[index_i / 3] = (u64)t[first] << 42 |
+                       (u64)t[(first + 1) % 3] << 21 | t[(first + 2) % 3];
+  }
+  std::sort(out, out + index_count / 3);
+}
+
+TEST(MeshOptimizer, AnalyzeVertexCache) {
+  s64 mem_size = Kilobytes(64);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  const u32 indices[6] = {0, 1, 2, 0, 2, 3};
+  VertexCacheStats stats;
+  ASSERT_FALSE(AnalyzeVertexCache(stack_allocator, indices, 6, 5, 16, &stats));
+  EXPECT_EQ(stats.acmr, 2.0f);
+  EXPECT_EQ(stats.atvr, 1.0f);
+  // Vertex 0 is evicted before the second triangle with a 2-entry FIFO
+  ASSERT_FALSE(AnalyzeVertexCache(stack_allocator, indices, 6, 5, 2, &stats));
+  EXPECT_EQ(stats.acmr, 2.5f);
+  EXPECT_EQ(stats.atvr, 1.25f);
+  EXPECT_EQ(stack_allocator->occupied, sizeof(StackAllocator));
+  free(mem);
+}
+
+TEST(MeshOptimizer, OptimizeVertexCache) {
+  SeedRand(20);
+  s64 mem_size = Megabytes(4);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  constexpr u32 kSide = 65;
+  constexpr u32 kVertexCount = kSide * kSide;
+  constexpr u32 kIndexCount = (kSide - 1) * (kSide - 1) * 6;
+  u32* indices = SALLOC(stack_allocator, u32, kIndexCount);
+  ASSERT_EQ(CreateShuffledGrid(kSide, indices), kIndexCount);
+  u64* before = SALLOC(stack_allocator, u64, kIndexCount / 3);
+  u64* after = SALLOC(stack_allocator, u64, kIndexCount / 3);
+  SortTriangles(indices, kIndexCount, before);
+
+  VertexCacheStats shuffled, optimized;
+  ASSERT_FALSE(AnalyzeVertexCache(stack_allocator, indices, kIndexCount,
+                                  kVertexCount, kVertexCacheSize, &shuffled));
+  ASSERT_FALSE(OptimizeVertexCache(stack_allocator, indices, kIndexCount,
+                                   kVertexCount, kVertexCacheSize));
+  ASSERT_FALSE(AnalyzeVertexCache(stack_allocator, indices, kIndexCount,
+                                  kVertexCount, kVertexCacheSize,
+                                  &optimized));
+  // Shuffled triangles miss almost every vertex, a grid has 0.5 vertices
+  // per triangle
+  EXPECT_GT(shuffled.acmr, 2.5f);
+  EXPECT_LT(optimized.acmr, 0.7f);
+  EXPECT_LT(optimized.atvr, 1.3f);
+  // Same triangles with the same winding
+  SortTriangles(indices, kIndexCount, after);
+  for (u32 triangle_i = 0; triangle_i < kIndexCount / 3; triangle_i++)
+    ASSERT_EQ(before[triangle_i], after[triangle_i]);
+  free(mem);
+}
+
+TEST(MeshOptimizer, OptimizeVertexFetch) {
+  s64 mem_size = Megabytes(1);
+  void* mem = malloc(mem_size);
+  Application app{};
+  app.alloc = CreateStackAllocator(mem, mem_size);
+  SceneCreateInfo scene_ci{};
+  scene_ci.max_vertices = 6;
+  ASSERT_FALSE(CreateScene(&scene_ci, &app));
+  VertexStreams& vertices = app.scene->resources->vertices;
+  // Vertex 0 is another mesh's, vertex 3 is unreferenced
+  for (u32 vert_i = 0; vert_i < 6; vert_i++) {
+    vertices.positions[vert_i] = {(r32)vert_i, 0, 0};
+    vertices.uvs[vert_i] = {(u16)vert_i, 0};
+  }
+  u32 indices[6] = {4, 1, 0, 4, 0, 2};
+  const u32 original[6] = {4, 1, 0, 4, 0, 2};
+  s64 occupied = app.alloc->occupied;
+  u32 vertex_count = 0;
+  ASSERT_FALSE(OptimizeVertexFetch(app.alloc, &vertices, 1, 5, indices, 6,
+                                   &vertex_count));
+  EXPECT_EQ(vertex_count, 4);
+  EXPECT_EQ(app.alloc->occupied, occupied);
+  const u32 expected[6] = {0, 1, 2, 0, 2, 3};
+  for (u32 index_i = 0; index_i < 6; index_i++) {
+    EXPECT_EQ(indices[index_i], expected[index_i]);
+    // Every stream follows the new numbering
+    EXPECT_EQ(vertices.positions[indices[index_i] + 1].x,
+              (r32)(original[index_i] + 1));
+    EXPECT_EQ(vertices.uvs[indices[index_i] + 1].u, original[index_i] + 1);
+  }
+  // Vertices outside the range are untouched
+  EXPECT_EQ(vertices.positions[0].x, 0.0f);
+  // Failure is reported apart from the vertex count
+  alignas(16) char small_mem[256];
+  StackAllocator* small_alloc =
+      CreateStackAllocator(small_mem, sizeof(small_mem));
+  EXPECT_TRUE(OptimizeVertexFetch(small_alloc, &vertices, 0, 1024, indices, 6,
+                                  &vertex_count));
+  EXPECT_EQ(vertex_count, 0);
+  EXPECT_EQ(small_alloc->occupied, sizeof(StackAllocator));
+  free(mem);
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include <rally/math/packing.h>
+
+#include "testrandom.h"
+
+using namespace rally;
+
+static r32 Dot(const Float3& a, const Float3& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+static Float3 Cross(const Float3& a, const Float3& b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+static Float3 RandUnit() {
+  Float3 v;
+  do {
+    v = {RandR32(-1, 1), RandR32(-1, 1), RandR32(-1, 1)};
+  } while (Dot(v, v) < 1e-2f || Dot(v, v) > 1.0f);
+  r32 inv_length = 1.0f / sqrtf(Dot(v, v));
+  return {v.x * inv_length, v.y * inv_length, v.z * inv_length};
+}
+// Angle between unit vectors, acos loses precision near 1
+static r32 Angle(const Float3& a, const Float3& b) {
+  Float3 c = Cross(a, b);
+  return atan2f(sqrtf(Dot(c, c)), Dot(a, b));
+}
+
+// Error bounds, in radians
+constexpr r32 kOctNormalMaxError = Radians(0.01f);
+constexpr r32 kTangentFrameMaxError = Radians(0.01f);
+
+TEST(Packing, Size) {
+  EXPECT_EQ(sizeof(OctNormal), 4);
+  EXPECT_EQ(sizeof(TangentFrame), 8);
+  EXPECT_EQ(sizeof(HalfUv), 4);
+}
+
+TEST(Packing, Half) {
+  EXPECT_EQ(FloatToHalf(0.0f), 0x0000);
+  EXPECT_EQ(FloatToHalf(-0.0f), 0x8000);
+  EXPECT_EQ(FloatToHalf(1.0f), 0x3c00);
+  EXPECT_EQ(FloatToHalf(-2.0f), 0xc000);
+  EXPECT_EQ(FloatToHalf(65504.0f), 0x7bff);
+  EXPECT_EQ(FloatToHalf(1e6f), 0x7c00);
+  EXPECT_EQ(FloatToHalf(-INFINITY), 0xfc00);
+  EXPECT_TRUE(isnan(HalfToFloat(FloatToHalf(NAN))));
+  // Smallest subnormal
+  EXPECT_EQ(FloatToHalf(5.9604645e-8f), 0x0001);
+  EXPECT_EQ(HalfToFloat(0x0001), 5.9604645e-8f);
+  // Ties round to even
+  EXPECT_EQ(FloatToHalf(1.0f + 1.0f / 2048.0f), 0x3c00);
+  EXPECT_EQ(FloatToHalf(1.0f + 3.0f / 2048.0f), 0x3c02);
+  // Every finite half round trips exactly
+  for (u32 h = 0; h < 0x10000; h++) {
+    if ((h & 0x7c00) == 0x7c00) continue;
+    EXPECT_EQ(FloatToHalf(HalfToFloat((u16)h)), h);
+  }
+}
+
+TEST(Packing, OctNormal) {
+  SeedRand(17);
+  r32 max_error = 0.0f;
+  const Float3 axes[6] = {{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                          {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+  for (const Float3& axis : axes) {
+    Float3 decoded = DecodeOctNormal(EncodeOctNormal(axis));
+    max_error = fmaxf(max_error, Angle(axis, decoded));
+  }
+  for (u32 i = 0; i < 100000; i++) {
+    Float3 normal = RandUnit();
+    Float3 decoded = DecodeOctNormal(EncodeOctNormal(normal));
+    EXPECT_NEAR(Dot(decoded, decoded), 1.0f, 1e-5f);
+    max_error = fmaxf(max_error, Angle(normal, decoded));
+  }
+  EXPECT_LT(max_error, kOctNormalMaxError);
+}
+
+TEST(Packing, TangentFrame) {
+  SeedRand(18);
+  r32 max_error = 0.0f;
+  for (u32 i = 0; i < 100000; i++) {
+    Float3 normal = RandUnit();
+    Float3 tangent = RandUnit();
+    r32 n_dot_t = Dot(normal, tangent);
+    if (fabsf(n_dot_t) > 0.99f) continue;
+    // Tangents from an importer are not exactly orthogonal to the normal
+    tangent = {tangent.x - normal.x * n_dot_t, tangent.y - normal.y * n_dot_t,
+               tangent.z - normal.z * n_dot_t};
+    r32 inv_length = 1.0f / sqrtf(Dot(tangent, tangent));
+    tangent = {tangent.x * inv_length, tangent.y * inv_length,
+               tangent.z * inv_length};
+    Float3 bitangent = Cross(normal, tangent);
+    if (i & 1) bitangent = {-bitangent.x, -bitangent.y, -bitangent.z};
+
+    Float3 out_n, out_t, out_b;
+    DecodeTangentFrame(EncodeTangentFrame(normal, tangent, bitangent), out_n,
+                       out_t, out_b);
+    max_error = fmaxf(max_error, Angle(normal, out_n));
+    max_error = fmaxf(max_error, Angle(tangent, out_t));
+    max_error = fmaxf(max_error, Angle(bitangent, out_b));
+  }
+  EXPECT_LT(max_error, kTangentFrameMaxError);
+
+  // Half turns have w = 0, handedness must survive quantization
+  const Float3 n{0, 0, -1}, t{1, 0, 0};
+  for (r32 handedness : {1.0f, -1.0f}) {
+    Float3 b = Cross(n, t);
+    b = {b.x * handedness, b.y * handedness, b.z * handedness};
+    Float3 out_n, out_t, out_b;
+    DecodeTangentFrame(EncodeTangentFrame(n, t, b), out_n, out_t, out_b);
+    EXPECT_LT(Angle(n, out_n), kTangentFrameMaxError);
+    EXPECT_LT(Angle(t, out_t), kTangentFrameMaxError);
+    EXPECT_LT(Angle(b, out_b), kTangentFrameMaxError);
+  }
+}
+
+TEST(Packing, HalfUv) {
+  SeedRand(19);
+  for (u32 i = 0; i < 10000; i++) {
+    // Tiled coordinates leave [0,1]
+    r32 u = RandR32(-4.0f, 4.0f), v = RandR32(0.0f, 1.0f);
+    Vec2 decoded = DecodeHalfUv(EncodeHalfUv(u, v));
+    // Half keeps 11 significant bits
+    EXPECT_LE(fabsf(decoded.x - u), fabsf(u) * (1.0f / 2048.0f) + 1e-7f);
+    EXPECT_LE(fabsf(decoded.y - v), fabsf(v) * (1.0f / 2048.0f) + 1e-7f);
+  }
+}
\ No newline at end of file
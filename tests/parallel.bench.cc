@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+#include <rally/math/vec.h>
+#include <rally/scene/scene.h>
+#include <rally/thread/parallel.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+constexpr u32 kEntityCount = 16384;
+
+// Scene with kEntityCount entities, arg is worker count
+struct TransformBench {
+  void* data;
+  Application* app;
+  Scene* scene;
+  Mat4* world;
+  Mat4 parent;
+};
+static void CreateTransformBench(benchmark::State& state,
+                                 TransformBench* bench) {
+  s64 data_size = Megabytes(8);
+  bench->data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  bench->app = CreateApplication(&app_ci, bench->data, data_size);
+  SceneCreateInfo scene_ci{kEntityCount, 1, 1, 1, 1, 1};
+  CreateScene(&scene_ci, bench->app);
+  bench->scene = bench->app->scene;
+  bench->scene->entity_count = kEntityCount;
+  for (u32 entity_i = 0; entity_i < kEntityCount; entity_i++) {
+    r32 t = (r32)entity_i;
+    bench->scene->transforms[entity_i] =
+        MMul(MTranslation(t, -t, 0.5f * t), MRotation(t, 0.5f * t, 0.0f));
+  }
+  bench->world = SALLOC(bench->app->alloc, Mat4, kEntityCount);
+  bench->parent = MMul(MTranslation(1, 2, 3), MScale(2.0f));
+}
+static void DestroyTransformBench(TransformBench* bench) {
+  DestroyApplication(bench->app);
+  free(bench->data);
+}
+
+static void UpdateTransforms(u32 begin, u32 end, TransformBench* bench) {
+  for (u32 entity_i = begin; entity_i < end; entity_i++)
+    MMul(bench->parent, bench->scene->transforms[entity_i],
+         bench->world[entity_i]);
+}
+static void BM_TransformsSerial(benchmark::State& state) {
+  TransformBench bench;
+  CreateTransformBench(state, &bench);
+  for (auto _ : state) {
+    UpdateTransforms(0, bench.scene->entity_count, &bench);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kEntityCount);
+  DestroyTransformBench(&bench);
+}
+BENCHMARK(BM_TransformsSerial)->Arg(0)->UseRealTime();
+
+static void BM_TransformsParallelFor(benchmark::State& state) {
+  TransformBench bench;
+  CreateTransformBench(state, &bench);
+  for (auto _ : state) {
+    ParallelFor(bench.app->threadpool->queue, 0, bench.scene->entity_count, 0,
+                (parallel_for_func)UpdateTransforms, &bench);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kEntityCount);
+  DestroyTransformBench(&bench);
+}
+BENCHMARK(BM_TransformsParallelFor)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+// Sum of entity translations, e.g. for a scene centroid
+static void SumTranslations(u32 begin, u32 end, TransformBench* bench,
+                            Vec4* partial) {
+  for (u32 entity_i = begin; entity_i < end; entity_i++)
+    VAdd(*partial, bench->scene->transforms[entity_i].cols[3], *partial);
+}
+static void JoinTranslations(Vec4* result, const Vec4* partial, void*) {
+  VAdd(*result, *partial, *result);
+}
+static void BM_TranslationSumSerial(benchmark::State& state) {
+  TransformBench bench;
+  CreateTransformBench(state, &bench);
+  for (auto _ : state) {
+    Vec4 sum = {};
+    SumTranslations(0, bench.scene->entity_count, &bench, &sum);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kEntityCount);
+  DestroyTransformBench(&bench);
+}
+BENCHMARK(BM_TranslationSumSerial)->Arg(0)->UseRealTime();
+
+static void BM_TranslationSumParallelReduce(benchmark::State& state) {
+  TransformBench bench;
+  CreateTransformBench(state, &bench);
+  const Vec4 identity = {};
+  for (auto _ : state) {
+    Vec4 sum = {};
+    ParallelReduce(bench.app->threadpool->queue, 0, bench.scene->entity_count,
+                   0, (parallel_reduce_func)SumTranslations,
+                   (parallel_join_func)JoinTranslations, &bench, &identity,
+                   sizeof(Vec4), &sum);
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * kEntityCount);
+  DestroyTransformBench(&bench);
+}
+BENCHMARK(BM_TranslationSumParallelReduce)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
\ No newline at end of file
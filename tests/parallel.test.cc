@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <rally/thread/parallel.h>
+
+using namespace rally;
+
+constexpr u32 kArrayLen = 10000;
+
+void CountIndices(u32 begin, u32 end, std::atomic<u32>* counts) {
+  for (u32 i = begin; i < end; i++) counts[i].fetch_add(1);
+}
+
+TEST(ParallelFor, CoversRange) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<u32>* counts = SALLOC(app->alloc, std::atomic<u32>, kArrayLen);
+  const u32 grains[] = {0, 1, 7, 64, kArrayLen * 2};
+  for (u32 grain : grains) {
+    for (u32 i = 0; i < kArrayLen; i++) counts[i].store(0);
+    ParallelFor(tp->queue, 13, kArrayLen - 5, grain,
+                (parallel_for_func)CountIndices, counts);
+    for (u32 i = 0; i < kArrayLen; i++)
+      EXPECT_EQ(counts[i].load(), i >= 13 && i < kArrayLen - 5 ? 1 : 0);
+  }
+  // Empty range performs nothing
+  ParallelFor(tp->queue, 20, 20, 0, (parallel_for_func)CountIndices, counts);
+  EXPECT_EQ(counts[20].load(), 1);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct NestedForParams {
+  JobQueue* queue;
+  std::atomic<u32>* counts;
+};
+
+bool NestedFor(NestedForParams* params) {
+  ParallelFor(params->queue, 0, kArrayLen, 16,
+              (parallel_for_func)CountIndices, params->counts);
+  return false;
+}
+
+TEST(ParallelFor, InsideJobs) {
+  s64 data_size = Megabytes(4);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4, false, 16};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<u32>* counts = SALLOC(app->alloc, std::atomic<u32>, kArrayLen);
+  for (u32 i = 0; i < kArrayLen; i++) counts[i].store(0);
+  constexpr u32 kJobCount = 8;
+  NestedForParams params{tp->queue, counts};
+  for (u32 job_i = 0; job_i < kJobCount; job_i++)
+    PushJob(tp->queue, {(job_func)NestedFor, &params});
+  WaitThreadQueue(tp->queue);
+  for (u32 i = 0; i < kArrayLen; i++) EXPECT_EQ(counts[i].load(), kJobCount);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct SumRange {
+  u64 sum;
+  u32 min;
+  u32 max;
+};
+
+void AccumulateRange(u32 begin, u32 end, void*, SumRange* partial) {
+  for (u32 i = begin; i < end; i++) {
+    partial->sum += i;
+    if (i < partial->min) partial->min = i;
+    if (i > partial->max) partial->max = i;
+  }
+}
+
+void JoinRange(SumRange* result, const SumRange* partial, void*) {
+  result->sum += partial->sum;
+  if (partial->min < result->min) result->min = partial->min;
+  if (partial->max > result->max) result->max = partial->max;
+}
+
+TEST(ParallelReduce, SumMinMax) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{7};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  const SumRange identity{0, 0xffffffff, 0};
+  const u32 grains[] = {0, 1, 1000, 1000000};
+  for (u32 grain : grains) {
+    SumRange result = identity;
+    ParallelReduce(tp->queue, 5, 100000, grain,
+                   (parallel_reduce_func)AccumulateRange,
+                   (parallel_join_func)JoinRange, nullptr, &identity,
+                   sizeof(SumRange), &result);
+    EXPECT_EQ(result.sum, (u64)100000 * 99999 / 2 - 10);
+    EXPECT_EQ(result.min, 5);
+    EXPECT_EQ(result.max, 99999);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+#include <rally/memory/poolallocator.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+constexpr u32 kLiveCount = 4096;
+constexpr s64 kSlotSize = 64;
+
+// Random out of order frees over kLiveCount live slots, e.g. spawned
+// entities or streaming chunks. Arg is non-zero for the concurrent pool.
+static void BM_PoolChurn(benchmark::State& state) {
+  s64 mem_size = Megabytes(1);
+  void* mem = malloc(mem_size);
+  StackAllocator* stack_allocator = CreateStackAllocator(mem, mem_size);
+  PoolAllocatorCreateInfo pool_ci = {kSlotSize, alignof(s64), kLiveCount,
+                                     (b32)state.range(0)};
+  PoolAllocator* pool = CreatePoolAllocator(stack_allocator, &pool_ci);
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      PoolFree(pool, live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      live[live_i] = PoolAllocate(pool);
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  free(live);
+  free(mem);
+}
+BENCHMARK(BM_PoolChurn)->Arg(0)->Arg(1);
+
+static void BM_MallocChurn(benchmark::State& state) {
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      free(live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      // Zeroed like PoolAllocate
+      live[live_i] = calloc(1, kSlotSize);
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  for (u32 live_i = 0; live_i < kLiveCount; live_i++) free(live[live_i]);
+  free(live);
+}
+BENCHMARK(BM_MallocChurn);
+
+// Every benchmark thread churns its own share of a shared concurrent pool
+static PoolAllocator* shared_pool = nullptr;
+static void* shared_pool_mem = nullptr;
+static void BM_ConcurrentPoolChurn(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    s64 mem_size = Megabytes(4);
+    shared_pool_mem = malloc(mem_size);
+    StackAllocator* stack_allocator =
+        CreateStackAllocator(shared_pool_mem, mem_size);
+    PoolAllocatorCreateInfo pool_ci = {kSlotSize, alignof(s64),
+                                       kLiveCount * (u32)state.threads(), true};
+    shared_pool = CreatePoolAllocator(stack_allocator, &pool_ci);
+  }
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = state.thread_index() + 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      PoolFree(shared_pool, live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      live[live_i] = PoolAllocate(shared_pool);
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  free(live);
+  if (state.thread_index() == 0) free(shared_pool_mem);
+}
+BENCHMARK(BM_ConcurrentPoolChurn)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ConcurrentMallocChurn(benchmark::State& state) {
+  void** live = (void**)calloc(kLiveCount, sizeof(void*));
+  u32 random_state = state.thread_index() + 1;
+  for (auto _ : state) {
+    random_state = random_state * 1664525u + 1013904223u;
+    u32 live_i = (random_state >> 8) % kLiveCount;
+    if (live[live_i] != nullptr) {
+      free(live[live_i]);
+      live[live_i] = nullptr;
+    } else {
+      live[live_i] = calloc(1, kSlotSize);
+      benchmark::DoNotOptimize(live[live_i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  for (u32 live_i = 0; live_i < kLiveCount; live_i++) free(live[live_i]);
+  free(live);
+}
+BENCHMARK(BM_ConcurrentMallocChurn)->ThreadRange(1, 8)->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <rally/memory/poolallocator.h>
+
+#include <thread>
+#include <vector>
+
+TEST(PoolAllocator, PoolAllocate) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  struct Light {
+    float color[3];
+    float intensity;
+  };
+  rally::PoolAllocatorCreateInfo pool_ci = {sizeof(Light), 64, 16};
+  rally::PoolAllocator* pool =
+      rally::CreatePoolAllocator(stack_allocator, &pool_ci);
+  ASSERT_NE(pool, nullptr);
+  Light* lights[16];
+  for (rally::u32 light_i = 0; light_i < 16; light_i++) {
+    lights[light_i] = (Light*)rally::PoolAllocate(pool);
+    ASSERT_NE(lights[light_i], nullptr);
+    EXPECT_EQ((uintptr_t)lights[light_i] % 64, 0u);
+    EXPECT_EQ(lights[light_i]->intensity, 0.0f);
+    lights[light_i]->intensity = (float)light_i;
+  }
+  EXPECT_EQ(rally::PoolAllocate(pool), nullptr);
+  EXPECT_EQ(pool->used_count.load(), 16u);
+  // Free out of order, the most recently freed slot is reused first
+  rally::PoolFree(pool, lights[3]);
+  rally::PoolFree(pool, lights[11]);
+  EXPECT_EQ(lights[7]->intensity, 7.0f);
+  Light* light = (Light*)rally::PoolAllocate(pool);
+  EXPECT_EQ(light, lights[11]);
+  EXPECT_EQ(light->intensity, 0.0f);
+  EXPECT_EQ(rally::PoolAllocate(pool), lights[3]);
+  EXPECT_EQ(rally::PoolAllocate(pool), nullptr);
+  free(mem);
+}
+
+TEST(PoolAllocator, ConcurrentPool) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  constexpr rally::u32 kThreadCount = 8;
+  constexpr rally::u32 kLiveCount = 64;
+  rally::PoolAllocatorCreateInfo pool_ci = {
+      sizeof(rally::u64), alignof(rally::u64), kThreadCount * kLiveCount, true,
+      rally::kPoolDebugGuard};
+  rally::PoolAllocator* pool =
+      rally::CreatePoolAllocator(stack_allocator, &pool_ci);
+  ASSERT_NE(pool, nullptr);
+  std::atomic<rally::u32> errors = 0;
+  // Each thread churns kLiveCount slots, a slot handed to two threads at once
+  // would have its tag overwritten
+  auto churn = [&](rally::u64 thread_tag) {
+    rally::u64* live[kLiveCount] = {};
+    rally::u32 random_state = (rally::u32)thread_tag;
+    for (rally::u32 iteration_i = 0; iteration_i < 20000; iteration_i++) {
+      random_state = random_state * 1664525u + 1013904223u;
+      rally::u32 live_i = (random_state >> 8) % kLiveCount;
+      if (live[live_i] != nullptr) {
+        if (*live[live_i] != thread_tag + live_i) errors++;
+        rally::PoolFree(pool, live[live_i]);
+        live[live_i] = nullptr;
+      } else {
+        live[live_i] = (rally::u64*)rally::PoolAllocate(pool);
+        if (live[live_i] == nullptr) {
+          errors++;
+          continue;
+        }
+        if (*live[live_i] != 0) errors++;
+        *live[live_i] = thread_tag + live_i;
+      }
+    }
+    for (rally::u32 live_i = 0; live_i < kLiveCount; live_i++)
+      rally::PoolFree(pool, live[live_i]);
+  };
+  std::vector<std::thread> threads;
+  for (rally::u32 thread_i = 0; thread_i < kThreadCount; thread_i++)
+    threads.emplace_back(churn, (rally::u64)(thread_i + 1) << 32);
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(errors.load(), 0u);
+  EXPECT_EQ(pool->used_count.load(), 0u);
+  EXPECT_FALSE(rally::CheckPoolAllocator(pool));
+  // Every slot is back on the free list
+  for (rally::u32 slot_i = 0; slot_i < pool->slot_count; slot_i++)
+    EXPECT_NE(rally::PoolAllocate(pool), nullptr);
+  EXPECT_EQ(rally::PoolAllocate(pool), nullptr);
+  free(mem);
+}
+
+TEST(PoolAllocator, DebugModes) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::PoolAllocatorCreateInfo pool_ci = {
+      32, 16, 8, false, rally::kPoolDebugPoison | rally::kPoolDebugGuard};
+  rally::PoolAllocator* pool =
+      rally::CreatePoolAllocator(stack_allocator, &pool_ci);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool->slot_stride, 32 + rally::kPoolGuardSize);
+  char* a = (char*)rally::PoolAllocate(pool);
+  char* b = (char*)rally::PoolAllocate(pool);
+  EXPECT_FALSE(rally::CheckPoolAllocator(pool));
+  // Freed slots are poisoned
+  rally::PoolFree(pool, b);
+  EXPECT_EQ(b[31], rally::kPoolPoison);
+  EXPECT_FALSE(rally::CheckPoolAllocator(pool));
+  // Use after free
+  b[20] = 1;
+  EXPECT_TRUE(rally::CheckPoolAllocator(pool));
+  b[20] = rally::kPoolPoison;
+  EXPECT_FALSE(rally::CheckPoolAllocator(pool));
+  // Overrun into the guard
+  a[32] = 0;
+  EXPECT_TRUE(rally::CheckPoolAllocator(pool));
+  a[32] = rally::kPoolGuard;
+  rally::PoolFree(pool, a);
+  EXPECT_FALSE(rally::CheckPoolAllocator(pool));
+  free(mem);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+#include <float.h>
+#include <rally/scene/scene.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+// Interleaved layout the scene used before vertex streams, 80 bytes per vertex
+struct AosVertex {
+  Vec3 position;
+  Vec3 normal;
+  Vec3 tangent;
+  Vec3 bitangent;
+  Vec2 uv;
+};
+
+static r32 Coordinate(u32 vert_i, u32 axis) {
+  return (r32)((vert_i * 2654435761u + axis * 40503u) % 4096) - 2048.0f;
+}
+
+struct BenchMesh {
+  AosVertex* aos;
+  // 32-bit so both layouts gather through the same index list
+  u32* indices;
+  void* mem;
+  Application app;
+  Mesh mesh;
+};
+// Indices form a triangle list over scattered vertices
+static void CreateBenchMesh(BenchMesh* bench, u32 vertex_count) {
+  s64 mem_size = vertex_count * (s64)(sizeof(Float3) + sizeof(OctNormal) +
+                                      sizeof(TangentFrame) + sizeof(HalfUv)) +
+                 Megabytes(1);
+  bench->mem = malloc(mem_size);
+  bench->app = {};
+  bench->app.alloc = CreateStackAllocator(bench->mem, mem_size);
+  SceneCreateInfo scene_ci{};
+  scene_ci.max_meshes = 1;
+  scene_ci.max_vertices = vertex_count;
+  CreateScene(&scene_ci, &bench->app);
+  SceneResources* res = bench->app.scene->resources;
+  bench->aos = (AosVertex*)malloc(vertex_count * sizeof(AosVertex));
+  bench->indices = (u32*)malloc(vertex_count * sizeof(u32));
+  for (u32 vert_i = 0; vert_i < vertex_count; vert_i++) {
+    Float3 p{Coordinate(vert_i, 0), Coordinate(vert_i, 1),
+             Coordinate(vert_i, 2)};
+    res->vertices.positions[vert_i] = p;
+    bench->aos[vert_i].position.data = _mm_setr_ps(p.x, p.y, p.z, 0.0f);
+    bench->indices[vert_i] = (vert_i * 7919u) % vertex_count;
+  }
+  res->vertex_count = vertex_count;
+  bench->mesh = {0, vertex_count, 0, vertex_count / 3 * 3, sizeof(u32)};
+}
+static void DestroyBenchMesh(BenchMesh* bench) {
+  free(bench->aos);
+  free(bench->indices);
+  free(bench->mem);
+}
+
+// Arg is vertex count
+static void BM_BoundsAos(benchmark::State& state) {
+  BenchMesh bench;
+  CreateBenchMesh(&bench, (u32)state.range(0));
+  for (auto _ : state) {
+    __m128 lo = _mm_set1_ps(FLT_MAX);
+    __m128 hi = _mm_set1_ps(-FLT_MAX);
+    for (u32 vert_i = 0; vert_i < bench.mesh.vertex_count; vert_i++) {
+      lo = _mm_min_ps(lo, bench.aos[vert_i].position.data);
+      hi = _mm_max_ps(hi, bench.aos[vert_i].position.data);
+    }
+    benchmark::DoNotOptimize(lo);
+    benchmark::DoNotOptimize(hi);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(AosVertex));
+  DestroyBenchMesh(&bench);
+}
+BENCHMARK(BM_BoundsAos)->Arg(4096)->Arg(1 << 20);
+
+static void BM_BoundsStreams(benchmark::State& state) {
+  BenchMesh bench;
+  CreateBenchMesh(&bench, (u32)state.range(0));
+  for (auto _ : state) {
+    Bounds bounds = ComputeMeshBounds(bench.app.scene->resources, bench.mesh);
+    benchmark::DoNotOptimize(bounds);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(Float3));
+  DestroyBenchMesh(&bench);
+}
+BENCHMARK(BM_BoundsStreams)->Arg(4096)->Arg(1 << 20);
+
+// Sum of twice the triangle areas squared, gathers positions through indices
+static void BM_TrianglesAos(benchmark::State& state) {
+  BenchMesh bench;
+  CreateBenchMesh(&bench, (u32)state.range(0));
+  const u32* indices = bench.indices;
+  for (auto _ : state) {
+    r32 sum = 0.0f;
+    for (u32 index_i = 0; index_i < bench.mesh.index_count; index_i += 3) {
+      alignas(16) r32 p0[4], p1[4], p2[4];
+      _mm_store_ps(p0, bench.aos[indices[index_i]].position.data);
+      _mm_store_ps(p1, bench.aos[indices[index_i + 1]].position.data);
+      _mm_store_ps(p2, bench.aos[indices[index_i + 2]].position.data);
+      r32 ex = p1[0] - p0[0], ey = p1[1] - p0[1], ez = p1[2] - p0[2];
+      r32 fx = p2[0] - p0[0], fy = p2[1] - p0[1], fz = p2[2] - p0[2];
+      r32 cx = ey * fz - ez * fy, cy = ez * fx - ex * fz,
+          cz = ex * fy - ey * fx;
+      sum += cx * cx + cy * cy + cz * cz;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  DestroyBenchMesh(&bench);
+}
+BENCHMARK(BM_TrianglesAos)->Arg(4096)->Arg(1 << 20);
+
+static void BM_TrianglesStreams(benchmark::State& state) {
+  BenchMesh bench;
+  CreateBenchMesh(&bench, (u32)state.range(0));
+  const Float3* positions = bench.app.scene->resources->vertices.positions;
+  const u32* indices = bench.indices;
+  for (auto _ : state) {
+    r32 sum = 0.0f;
+    for (u32 index_i = 0; index_i < bench.mesh.index_count; index_i += 3) {
+      const Float3& p0 = positions[indices[index_i]];
+      const Float3& p1 = positions[indices[index_i + 1]];
+      const Float3& p2 = positions[indices[index_i + 2]];
+      r32 ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+      r32 fx = p2.x - p0.x, fy = p2.y - p0.y, fz = p2.z - p0.z;
+      r32 cx = ey * fz - ez * fy, cy = ez * fx - ex * fz,
+          cz = ex * fy - ey * fx;
+      sum += cx * cx + cy * cy + cz * cz;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  DestroyBenchMesh(&bench);
+}
+BENCHMARK(BM_TrianglesStreams)->Arg(4096)->Arg(1 << 20);
\ No newline at end of file
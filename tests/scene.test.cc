@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <rally/scene/scene.h>
+
+TEST(Scene, VertexStreams) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::Application app{};
+  app.alloc = rally::CreateStackAllocator(mem, mem_size);
+  rally::SceneCreateInfo scene_ci{};
+  scene_ci.max_meshes = 2;
+  scene_ci.max_vertices = 6;
+  ASSERT_FALSE(rally::CreateScene(&scene_ci, &app));
+  rally::SceneResources* res = app.scene->resources;
+  // Position stream is tightly packed
+  rally::VertexStreams& vertices = res->vertices;
+  EXPECT_EQ(sizeof(vertices.positions[0]), 12);
+  EXPECT_EQ((char*)&vertices.positions[1] - (char*)&vertices.positions[0], 12);
+
+  const rally::Float3 positions[6] = {{0, 0, 0},  {1, 2, 3}, {-1, 5, 2},
+                                      {9, 9, 9},  {4, -3, 1}, {2, 0, -7}};
+  for (rally::u32 vert_i = 0; vert_i < 6; vert_i++)
+    vertices.positions[vert_i] = positions[vert_i];
+  rally::Mesh first{0, 3, 0, 3};
+  rally::Bounds bounds = rally::ComputeMeshBounds(res, first);
+  EXPECT_EQ(bounds.min.x, -1);
+  EXPECT_EQ(bounds.min.y, 0);
+  EXPECT_EQ(bounds.min.z, 0);
+  EXPECT_EQ(bounds.max.x, 1);
+  EXPECT_EQ(bounds.max.y, 5);
+  EXPECT_EQ(bounds.max.z, 3);
+  // Bounds only cover the mesh's own vertex range
+  rally::Mesh second{3, 3, 3, 3};
+  bounds = rally::ComputeMeshBounds(res, second);
+  EXPECT_EQ(bounds.min.x, 2);
+  EXPECT_EQ(bounds.min.y, -3);
+  EXPECT_EQ(bounds.min.z, -7);
+  EXPECT_EQ(bounds.max.x, 9);
+  EXPECT_EQ(bounds.max.y, 9);
+  EXPECT_EQ(bounds.max.z, 9);
+  free(mem);
+}
+
+TEST(Scene, WeldVertices) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::Application app{};
+  app.alloc = rally::CreateStackAllocator(mem, mem_size);
+  rally::SceneCreateInfo scene_ci{};
+  scene_ci.max_meshes = 1;
+  scene_ci.max_vertices = 8;
+  ASSERT_FALSE(rally::CreateScene(&scene_ci, &app));
+  rally::VertexStreams& vertices = app.scene->resources->vertices;
+  // Two triangles of a quad as an unindexed soup, vertex 0 is padding
+  const rally::Float3 corners[6] = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0},
+                                    {0, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  for (rally::u32 vert_i = 0; vert_i < 6; vert_i++) {
+    vertices.positions[vert_i + 1] = corners[vert_i];
+    vertices.normals[vert_i + 1] = {0, 32767};
+    vertices.tangent_frames[vert_i + 1] = {32767, 0, 0, 32767};
+    vertices.uvs[vert_i + 1] = {(rally::u16)corners[vert_i].x, 0};
+  }
+  // Same position with a different uv is a seam and must not weld
+  vertices.uvs[4].v = 1;  // Corner 3
+  rally::s64 occupied = app.alloc->occupied;
+  rally::u32 remap[6];
+  rally::u32 welded_count = 0;
+  EXPECT_FALSE(
+      rally::WeldVertices(app.alloc, &vertices, 1, 6, remap, &welded_count));
+  EXPECT_EQ(welded_count, 5);
+  EXPECT_EQ(app.alloc->occupied, occupied);
+  const rally::u32 expected_remap[6] = {0, 1, 2, 3, 2, 4};
+  for (rally::u32 vert_i = 0; vert_i < 6; vert_i++) {
+    EXPECT_EQ(remap[vert_i], expected_remap[vert_i]);
+    // Welded streams reproduce every input vertex
+    rally::u32 welded_i = remap[vert_i] + 1;
+    EXPECT_EQ(vertices.positions[welded_i].x, corners[vert_i].x);
+    EXPECT_EQ(vertices.positions[welded_i].y, corners[vert_i].y);
+  }
+  EXPECT_EQ(vertices.uvs[4].v, 1);
+  // Out of memory is reported, not a zero count
+  alignas(16) char small_mem[256];
+  rally::StackAllocator* small_alloc =
+      rally::CreateStackAllocator(small_mem, sizeof(small_mem));
+  welded_count = 7;
+  EXPECT_TRUE(rally::WeldVertices(small_alloc, &vertices, 1, 6, remap,
+                                  &welded_count));
+  EXPECT_EQ(welded_count, 7);
+  free(mem);
+}
+
+TEST(Scene, MeshIndices) {
+  rally::s64 mem_size = rally::Megabytes(1);
+  void* mem = malloc(mem_size);
+  rally::Application app{};
+  app.alloc = rally::CreateStackAllocator(mem, mem_size);
+  rally::SceneCreateInfo scene_ci{};
+  scene_ci.max_index_bytes = 64;
+  ASSERT_FALSE(rally::CreateScene(&scene_ci, &app));
+  rally::SceneResources* res = app.scene->resources;
+
+  // Small meshes get 16-bit indices
+  const rally::u32 small_indices[3] = {0, 2, 1};
+  rally::Mesh small{0, 3};
+  ASSERT_FALSE(rally::AppendMeshIndices(res, &small, small_indices, 3));
+  EXPECT_EQ(small.index_size, 2);
+  EXPECT_EQ(small.index_offset, 0);
+  EXPECT_EQ(res->index_bytes, 6);
+  // Large meshes get 32-bit indices aligned to 4 bytes
+  const rally::u32 large_indices[3] = {0, 70000, 65536};
+  rally::Mesh large{3, 70001};
+  ASSERT_FALSE(rally::AppendMeshIndices(res, &large, large_indices, 3));
+  EXPECT_EQ(large.index_size, 4);
+  EXPECT_EQ(large.index_offset, 8);
+  EXPECT_EQ(res->index_bytes, 20);
+  for (rally::u32 index_i = 0; index_i < 3; index_i++) {
+    EXPECT_EQ(rally::GetMeshIndex(res, small, index_i), small_indices[index_i]);
+    EXPECT_EQ(rally::GetMeshIndex(res, large, index_i), large_indices[index_i]);
+  }
+  // Full index buffer leaves the mesh untouched
+  const rally::u32 many_indices[24] = {};
+  rally::Mesh overflow{0, 3};
+  EXPECT_TRUE(rally::AppendMeshIndices(res, &overflow, many_indices, 24));
+  EXPECT_EQ(overflow.index_count, 0);
+  EXPECT_EQ(res->index_bytes, 20);
+  free(mem);
+}
\ No newline at end of file
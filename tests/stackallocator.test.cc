@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <rally/application/application.h>
 #include <rally/memory/stackallocator.h>
 
 TEST(StackAllocator, StackAllocate) {
@@ -19,7 +20,6 @@ TEST(StackAllocator, StackAllocate) {
   EXPECT_NE(c, nullptr);
   EXPECT_EQ(*c, 'A');
   EXPECT_NE(at, nullptr);
-  EXPECT_EQ(at->a[0], 0);
   EXPECT_EQ(at->a[2], 15);
   struct AllocateFailureTest {
     int b[1000000];
@@ -29,4 +29,185 @@ TEST(StackAllocator, StackAllocate) {
       alignof(AllocateFailureTest));
   EXPECT_EQ(aft, nullptr);
   rally::DestroyStackAllocator(stack_allocator);
+}
+
+TEST(StackAllocator, ResetStackAllocator) {
+  rally::s64 mem_size = rally::Kilobytes(4);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::s64 occupied0 = stack_allocator->occupied;
+  int* a = (int*)rally::StackAllocate(stack_allocator, sizeof(int) * 100,
+                                      alignof(int));
+  a[10] = 7;
+  rally::StackAllocate(stack_allocator, sizeof(int) * 100, alignof(int));
+  rally::ResetStackAllocator(stack_allocator);
+  EXPECT_EQ(stack_allocator->occupied, occupied0);
+  int* b = (int*)rally::StackAllocate(stack_allocator, sizeof(int) * 100,
+                                      alignof(int));
+  EXPECT_EQ(b, a);
+  rally::DestroyStackAllocator(stack_allocator);
+  free(mem);
+}
+
+TEST(StackAllocator, StackAllocateZeroed) {
+  rally::s64 mem_size = rally::Kilobytes(4);
+  void* mem = malloc(mem_size);
+  memset(mem, 0xCD, mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  // Fixed blocks start with unknown contents
+  int* a = SALLOCZ(stack_allocator, int, 100);
+  ASSERT_NE(a, nullptr);
+  for (rally::u32 i = 0; i < 100; i++) EXPECT_EQ(a[i], 0);
+  a[10] = 7;
+  // Freed memory keeps its contents until a zeroed allocation reuses it
+  rally::StackFree(stack_allocator);
+  int* b = SALLOC(stack_allocator, int, 100);
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(b[10], 7);
+  rally::ResetStackAllocator(stack_allocator);
+  int* c = (int*)rally::StackAllocateZeroed(stack_allocator, sizeof(int) * 100,
+                                            alignof(int));
+  EXPECT_EQ(c, a);
+  EXPECT_EQ(c[10], 0);
+  EXPECT_EQ(rally::StackAllocateZeroed(stack_allocator, mem_size, 1), nullptr);
+  // Padding before and after a zeroed allocation is cleared, up to its marker
+  rally::StackAllocate(stack_allocator, 1024, 1);
+  char* begin = (char*)stack_allocator->data + stack_allocator->occupied;
+  // Allocations are 8-byte granular, one more misaligns an aligned start
+  if (stack_allocator->occupied % 64 == 0) {
+    rally::StackAllocate(stack_allocator, 1, 1);
+    begin = (char*)stack_allocator->data + stack_allocator->occupied;
+  }
+  char* d = (char*)rally::StackAllocateZeroed(stack_allocator, 1, 64);
+  char* mark = (char*)stack_allocator->data + stack_allocator->occupied -
+               sizeof(rally::s64);
+  EXPECT_GT(d, begin);
+  for (char* byte = begin; byte < mark; byte++) EXPECT_EQ(*byte, 0);
+  rally::DestroyStackAllocator(stack_allocator);
+  free(mem);
+}
+
+#ifdef RALLY_MEMORY_TAGS
+TEST(StackAllocator, MemoryTags) {
+  rally::s64 mem_size = rally::Kilobytes(64);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::SetMemoryTag(stack_allocator, rally::MemoryTag::kScene);
+  rally::s64 occupied0 = stack_allocator->occupied;
+  rally::StackAllocate(stack_allocator, 100, 1);
+  rally::MemoryTag old_tag =
+      rally::SetMemoryTag(stack_allocator, rally::MemoryTag::kRenderer);
+  EXPECT_EQ(old_tag, rally::MemoryTag::kScene);
+  rally::s64 occupied1 = stack_allocator->occupied;
+  // Aligning after 100 bytes and a marker wastes padding
+  rally::StackAllocate(stack_allocator, 64, 256);
+  rally::StackAllocate(stack_allocator, 1000, 8);
+  rally::MemoryTagStats scene_stats, renderer_stats;
+  EXPECT_FALSE(rally::GetMemoryTagStats(
+      stack_allocator, rally::MemoryTag::kScene, &scene_stats));
+  EXPECT_FALSE(rally::GetMemoryTagStats(
+      stack_allocator, rally::MemoryTag::kRenderer, &renderer_stats));
+  EXPECT_EQ(scene_stats.size, occupied1 - occupied0);
+  EXPECT_EQ(scene_stats.allocation_count, 1u);
+  EXPECT_EQ(renderer_stats.size, stack_allocator->occupied - occupied1);
+  EXPECT_EQ(renderer_stats.allocation_count, 2u);
+  EXPECT_EQ(renderer_stats.padding,
+            renderer_stats.size - 64 - 1000 - 2 * sizeof(rally::s64));
+  EXPECT_GT(renderer_stats.padding, 0u);
+  // Frees are attributed back to the tag that allocated
+  rally::s64 peak_occupied = stack_allocator->occupied;
+  rally::SetMemoryTag(stack_allocator, rally::MemoryTag::kScript);
+  rally::StackFree(stack_allocator);
+  rally::StackFree(stack_allocator);
+  rally::GetMemoryTagStats(stack_allocator, rally::MemoryTag::kRenderer,
+                           &renderer_stats);
+  EXPECT_EQ(renderer_stats.size, 0u);
+  EXPECT_EQ(renderer_stats.padding, 0u);
+  EXPECT_EQ(renderer_stats.allocation_count, 0u);
+  EXPECT_EQ(renderer_stats.peak_size, peak_occupied - occupied1);
+  EXPECT_EQ(stack_allocator->occupied, occupied1);
+  EXPECT_EQ(stack_allocator->peak_occupied, peak_occupied);
+  rally::StackFree(stack_allocator);
+  EXPECT_EQ(stack_allocator->occupied, occupied0);
+  // Freeing an empty stack is a no-op
+  EXPECT_EQ(rally::StackFree(stack_allocator), 0u);
+  rally::GetMemoryTagStats(stack_allocator, rally::MemoryTag::kScene,
+                           &scene_stats);
+  EXPECT_EQ(scene_stats.size, 0u);
+  EXPECT_EQ(scene_stats.peak_size, occupied1 - occupied0);
+  free(mem);
+}
+
+TEST(StackAllocator, DumpMemoryTags) {
+  rally::s64 mem_size = rally::Kilobytes(4);
+  void* mem = malloc(mem_size);
+  rally::StackAllocator* stack_allocator =
+      rally::CreateStackAllocator(mem, mem_size);
+  rally::SetMemoryTag(stack_allocator, rally::MemoryTag::kThreadPool);
+  rally::StackAllocate(stack_allocator, 1000, 8);
+  rally::SetMemoryTag(stack_allocator, rally::MemoryTag::kRenderer);
+  testing::internal::CaptureStderr();
+  // Exhaustion reports who used the memory
+  EXPECT_EQ(rally::StackAllocate(stack_allocator, mem_size, 8), nullptr);
+  std::string report = testing::internal::GetCapturedStderr();
+  EXPECT_NE(report.find("exhausted"), std::string::npos);
+  EXPECT_NE(report.find("threadpool"), std::string::npos);
+  EXPECT_EQ(report.find("renderer"), std::string::npos);
+  free(mem);
+}
+#endif
+
+TEST(StackAllocator, VirtualStackAllocator) {
+  rally::StackAllocator* stack_allocator =
+      rally::CreateVirtualStackAllocator(rally::Gigabytes(64), false);
+  ASSERT_NE(stack_allocator, nullptr);
+  EXPECT_GE(stack_allocator->size, rally::Gigabytes(64));
+  rally::s64 committed0 = stack_allocator->committed;
+  EXPECT_LE(committed0, rally::Megabytes(2));
+  // Pages are committed as the stack grows and read as zero
+  char* a = (char*)rally::StackAllocate(stack_allocator, rally::Megabytes(16),
+                                        alignof(char));
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a[rally::Megabytes(16) - 1], 0);
+  memset(a, 1, rally::Megabytes(16));
+  EXPECT_GE(stack_allocator->committed, stack_allocator->occupied);
+  EXPECT_LE(stack_allocator->committed, rally::Megabytes(17));
+  // Small frees stay committed, large ones decommit
+  rally::s64 committed1 = stack_allocator->committed;
+  rally::StackAllocate(stack_allocator, sizeof(int), alignof(int));
+  rally::StackFree(stack_allocator);
+  EXPECT_EQ(stack_allocator->committed, committed1);
+  rally::StackFree(stack_allocator);
+  EXPECT_LT(stack_allocator->committed, rally::Megabytes(2));
+  EXPECT_LE(stack_allocator->dirty, stack_allocator->committed);
+  // Recommitted memory is zero
+  char* c = (char*)rally::StackAllocate(stack_allocator, rally::Megabytes(16),
+                                        alignof(char));
+  EXPECT_EQ(c, a);
+  EXPECT_EQ(c[rally::Megabytes(8)], 0);
+  // Only memory written since it was committed is cleared
+  c[10] = 1;
+  rally::StackFree(stack_allocator);
+  c = (char*)rally::StackAllocateZeroed(stack_allocator, rally::Megabytes(16),
+                                        alignof(char));
+  EXPECT_EQ(c[10], 0);
+  rally::ResetStackAllocator(stack_allocator);
+  EXPECT_LT(stack_allocator->committed, rally::Megabytes(2));
+  // Fails past the reservation without committing
+  EXPECT_EQ(rally::StackAllocate(stack_allocator, rally::Gigabytes(65), 1),
+            nullptr);
+  rally::DestroyStackAllocator(stack_allocator);
+}
+
+TEST(StackAllocator, VirtualApplication) {
+  rally::ApplicationCreateInfo app_ci{nullptr};
+  rally::Application* app =
+      rally::CreateApplication(&app_ci, nullptr, rally::Gigabytes(1));
+  ASSERT_NE(app, nullptr);
+  EXPECT_NE(app->alloc->commit_size, 0u);
+  EXPECT_LT(app->alloc->committed, rally::Megabytes(1));
+  rally::DestroyApplication(app);
 }
\ No newline at end of file
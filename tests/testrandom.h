@@ -0,0 +1,18 @@
+#pragma once
+#include <rally/types.h>
+
+// Same generator as the MSVC CRT rand(), so test data is identical on every
+// platform
+inline rally::u32 rand_state = 0;
+inline void SeedRand(rally::u32 seed) { rand_state = seed; }
+inline rally::u32 Rand() {
+  rand_state = rand_state * 214013u + 2531011u;
+  return (rand_state >> 16) & 0x7fff;
+}
+constexpr rally::u32 kRandMax = 0x7fff;
+
+inline rally::r32 RandR32(const rally::r32 minf, const rally::r32 maxf) {
+  rally::r32 r = ((rally::r32)Rand()) / kRandMax;
+  r = (r * (maxf - minf)) + minf;
+  return r;
+}
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include <benchmark/benchmark.h>
+#include <rally/thread/threadpool.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+using namespace rally;
+
+static bool EmptyJob(void*) { return false; }
+
+static bool SpinJob(void*) {
+  // Roughly a microsecond of work
+  volatile u32 sum = 0;
+  for (u32 i = 0; i < 1000; i++) sum += i;
+  return false;
+}
+
+// Single shared ring the thread pool used before work-stealing deques, kept
+// here as the baseline. Workers spin on one CAS over front, push is
+// single-producer.
+struct LegacyJobQueue {
+  std::atomic<u32> front;
+  std::atomic<u32> end;
+  std::atomic<u32> completion_goal;
+  std::atomic<u32> completion_count;
+  std::atomic<b32> active;
+  Job jobs[kMaxJobCount];
+  Semaphore semaphore;
+  u32 thread_count;
+  Thread threads[kMaxThreadCount];
+  std::atomic<u64> wake_count;
+  std::atomic<u64> park_count;
+};
+static bool LegacyPerformNextJob(LegacyJobQueue* queue) {
+  u32 next_job = queue->front.load();
+  if (next_job == queue->end.load()) return false;
+  Job job = queue->jobs[next_job];
+  if (queue->front.compare_exchange_strong(next_job,
+                                           (next_job + 1) % kMaxJobCount)) {
+    job.callback(job.data);
+    queue->completion_count.fetch_add(1);
+  }
+  return true;
+}
+static u32 LegacyThreadProc(void* param) {
+  LegacyJobQueue* queue = (LegacyJobQueue*)param;
+  while (queue->active.load()) {
+    if (!LegacyPerformNextJob(queue)) {
+      queue->park_count++;
+      WaitPlatformSemaphore(&queue->semaphore);
+    }
+  }
+  return 0;
+}
+static void CreateLegacyJobQueue(LegacyJobQueue* queue, u32 thread_count) {
+  queue->front = 0;
+  queue->end = 0;
+  queue->completion_goal = 0;
+  queue->completion_count = 0;
+  queue->active = true;
+  queue->thread_count = thread_count;
+  queue->wake_count = 0;
+  queue->park_count = 0;
+  CreatePlatformSemaphore(&queue->semaphore, thread_count);
+  for (u32 thread_i = 0; thread_i < thread_count; thread_i++)
+    CreatePlatformThread(&queue->threads[thread_i], LegacyThreadProc, queue);
+}
+static void LegacyPushJob(LegacyJobQueue* queue, Job job) {
+  u32 end = queue->end.load();
+  queue->jobs[end] = job;
+  queue->completion_goal++;
+  queue->end.store((end + 1) % kMaxJobCount);
+  queue->wake_count++;
+  SignalPlatformSemaphore(&queue->semaphore, 1);
+}
+static void LegacyWaitJobQueue(LegacyJobQueue* queue) {
+  while (queue->completion_count.load() < queue->completion_goal.load())
+    LegacyPerformNextJob(queue);
+}
+static void DestroyLegacyJobQueue(LegacyJobQueue* queue) {
+  queue->active = false;
+  SignalPlatformSemaphore(&queue->semaphore, queue->thread_count);
+  for (u32 thread_i = 0; thread_i < queue->thread_count; thread_i++)
+    JoinPlatformThread(&queue->threads[thread_i]);
+  DestroyPlatformSemaphore(&queue->semaphore);
+}
+
+constexpr u32 kBatchSize = kMaxJobCount - 1;
+
+// Jobs per second for batches pushed from the main thread, arg is worker count
+static void RunThroughput(benchmark::State& state, job_func callback) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  for (auto _ : state) {
+    for (u32 job_i = 0; job_i < kBatchSize; job_i++)
+      PushJob(queue, {callback, nullptr});
+    WaitThreadQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  DestroyApplication(app);
+  free(data);
+}
+static void RunLegacyThroughput(benchmark::State& state, job_func callback) {
+  LegacyJobQueue* queue = new LegacyJobQueue();
+  CreateLegacyJobQueue(queue, (u32)state.range(0));
+  for (auto _ : state) {
+    for (u32 job_i = 0; job_i < kBatchSize; job_i++)
+      LegacyPushJob(queue, {callback, nullptr});
+    LegacyWaitJobQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  DestroyLegacyJobQueue(queue);
+  delete queue;
+}
+
+static void BM_ThreadPoolEmptyJobs(benchmark::State& state) {
+  RunThroughput(state, EmptyJob);
+}
+BENCHMARK(BM_ThreadPoolEmptyJobs)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->UseRealTime();
+
+static void BM_LegacyQueueEmptyJobs(benchmark::State& state) {
+  RunLegacyThroughput(state, EmptyJob);
+}
+BENCHMARK(BM_LegacyQueueEmptyJobs)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->UseRealTime();
+
+static void BM_ThreadPoolSpinJobs(benchmark::State& state) {
+  RunThroughput(state, SpinJob);
+}
+BENCHMARK(BM_ThreadPoolSpinJobs)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->UseRealTime();
+
+static void BM_LegacyQueueSpinJobs(benchmark::State& state) {
+  RunLegacyThroughput(state, SpinJob);
+}
+BENCHMARK(BM_LegacyQueueSpinJobs)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->UseRealTime();
+
+// A frame's worth of per-entity jobs, far beyond the default capacity
+constexpr u32 kLargeBatchSize = 100000;
+static void BM_ThreadPoolLargeBatch(benchmark::State& state) {
+  s64 data_size = Megabytes(8);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  tp_ci.job_capacity = kLargeBatchSize;
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  for (auto _ : state) {
+    for (u32 job_i = 0; job_i < kLargeBatchSize; job_i++)
+      PushJob(queue, {EmptyJob, nullptr});
+    WaitThreadQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kLargeBatchSize);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolLargeBatch)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Jobs that push jobs, lands in worker deques. The legacy queue is
+// single-producer so it has no equivalent. Sized so roots run by the main
+// thread cannot overflow the shared queue.
+constexpr u32 kFanOut = 24;
+static bool FanOutJob(void* data) {
+  JobQueue* queue = (JobQueue*)data;
+  for (u32 job_i = 0; job_i < kFanOut; job_i++)
+    PushJob(queue, {SpinJob, nullptr});
+  return false;
+}
+static void BM_ThreadPoolNestedJobs(benchmark::State& state) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  constexpr u32 kRootCount = 4;
+  for (auto _ : state) {
+    for (u32 job_i = 0; job_i < kRootCount; job_i++)
+      PushJob(queue, {FanOutJob, queue});
+    WaitThreadQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kRootCount * (kFanOut + 1));
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolNestedJobs)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxThreadCount)
+    ->UseRealTime();
+
+// Recursive fork-join, every inner job waits for its children. With fibers the
+// wait parks the job, without them the waiting worker performs other jobs on
+// top of it. Tree is sized to fit the shared queue.
+constexpr u32 kForkJoinFanOut = 10;
+constexpr u32 kForkJoinDepth = 2;
+struct ForkJoinParams {
+  JobQueue* queue;
+  u32 depth;
+};
+static bool ForkJoinJob(void* data) {
+  ForkJoinParams* params = (ForkJoinParams*)data;
+  if (params->depth == 0) return SpinJob(nullptr);
+  ForkJoinParams children[kForkJoinFanOut];
+  JobCounter counter;
+  SetJobCounter(&counter, kForkJoinFanOut, {});
+  for (u32 child_i = 0; child_i < kForkJoinFanOut; child_i++) {
+    children[child_i] = {params->queue, params->depth - 1};
+    PushJob(params->queue, {ForkJoinJob, &children[child_i], &counter});
+  }
+  WaitJobCounter(params->queue, &counter);
+  return false;
+}
+// Args are worker count and fiber count
+static void BM_ThreadPoolForkJoin(benchmark::State& state) {
+  s64 data_size = Megabytes(16);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true, (u32)state.range(1)};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  for (auto _ : state) {
+    ForkJoinParams root{queue, kForkJoinDepth};
+    JobCounter counter;
+    SetJobCounter(&counter, 1, {});
+    PushJob(queue, {ForkJoinJob, &root, &counter});
+    WaitJobCounter(queue, &counter);
+  }
+  state.SetItemsProcessed(state.iterations() * kForkJoinFanOut *
+                          kForkJoinFanOut);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolForkJoin)
+    ->ArgNames({"threads", "fibers"})
+    ->ArgsProduct({{1, 2, 4, 8}, {0, 64}})
+    ->UseRealTime();
+
+// Latency from push to start of frame jobs while background streaming keeps
+// the pool busy, reported as p50/p99 counters. Second arg 0 pushes every job
+// at normal priority, 1 pushes frame jobs high and streaming jobs background.
+constexpr u32 kFrameJobCount = 32;
+constexpr s64 kStreamJobMicroseconds = 500;
+struct FrameJobParams {
+  std::chrono::steady_clock::time_point pushed;
+  r64* latency_us;
+};
+static bool FrameJob(void* data) {
+  FrameJobParams* params = (FrameJobParams*)data;
+  *params->latency_us = std::chrono::duration<r64, std::micro>(
+                            std::chrono::steady_clock::now() - params->pushed)
+                            .count();
+  return SpinJob(nullptr);
+}
+static bool StreamJob(void* data) {
+  auto start = std::chrono::steady_clock::now();
+  auto duration = std::chrono::microseconds(kStreamJobMicroseconds);
+  while (std::chrono::steady_clock::now() - start < duration) CpuRelax();
+  ((std::atomic<u32>*)data)->fetch_sub(1);
+  return false;
+}
+static void BM_ThreadPoolFrameLatency(benchmark::State& state) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  u32 thread_count = (u32)state.range(0);
+  b32 prioritized = state.range(1) != 0;
+  ThreadPoolCreateInfo tp_ci{thread_count, true};
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  JobPriority frame_priority =
+      prioritized ? JobPriority::kHigh : JobPriority::kNormal;
+  JobPriority stream_priority =
+      prioritized ? JobPriority::kBackground : JobPriority::kNormal;
+  std::atomic<u32> stream_pending;
+  stream_pending.store(0);
+  std::vector<r64> latencies;
+  FrameJobParams params[kFrameJobCount];
+  r64 frame_latencies[kFrameJobCount];
+  for (auto _ : state) {
+    // Keep twice as many streaming jobs queued as there are workers
+    while (stream_pending.load() < 2 * thread_count) {
+      stream_pending.fetch_add(1);
+      PushJob(queue, {StreamJob, &stream_pending, nullptr, stream_priority});
+    }
+    JobCounter counter;
+    SetJobCounter(&counter, kFrameJobCount, {});
+    for (u32 job_i = 0; job_i < kFrameJobCount; job_i++) {
+      params[job_i] = {std::chrono::steady_clock::now(),
+                       &frame_latencies[job_i]};
+      PushJob(queue, {FrameJob, &params[job_i], &counter, frame_priority});
+    }
+    WaitJobCounter(queue, &counter);
+    latencies.insert(latencies.end(), frame_latencies,
+                     frame_latencies + kFrameJobCount);
+  }
+  WaitThreadQueue(queue);
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["p50_us"] = latencies[latencies.size() / 2];
+  state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolFrameLatency)
+    ->ArgNames({"threads", "prioritized"})
+    ->ArgsProduct({{2, 4, 8}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Bursts of small jobs separated by short idle gaps. Reports push-to-start
+// latency and semaphore signals and waits per burst, each of which is a
+// syscall when it has to wake or park a thread. Args are worker count and
+// low_power_idle.
+constexpr u32 kBurstSize = 16;
+constexpr s64 kBurstGapMicroseconds = 50;
+static void WaitBurstGap() {
+  auto start = std::chrono::steady_clock::now();
+  auto gap = std::chrono::microseconds(kBurstGapMicroseconds);
+  while (std::chrono::steady_clock::now() - start < gap) CpuRelax();
+}
+static void ReportBursts(benchmark::State& state, std::vector<r64>& latencies,
+                         u64 wake_count, u64 park_count) {
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["p50_us"] = latencies[latencies.size() / 2];
+  state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+  state.counters["wakes"] =
+      benchmark::Counter((r64)wake_count, benchmark::Counter::kAvgIterations);
+  state.counters["parks"] =
+      benchmark::Counter((r64)park_count, benchmark::Counter::kAvgIterations);
+}
+static void BM_ThreadPoolBurst(benchmark::State& state) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  tp_ci.low_power_idle = state.range(1) != 0;
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  std::vector<r64> latencies;
+  FrameJobParams params[kBurstSize];
+  r64 burst_latencies[kBurstSize];
+  Job jobs[kBurstSize];
+  u64 wake_count = queue->wake_count.load();
+  u64 park_count = queue->park_count.load();
+  for (auto _ : state) {
+    auto pushed = std::chrono::steady_clock::now();
+    for (u32 job_i = 0; job_i < kBurstSize; job_i++) {
+      params[job_i] = {pushed, &burst_latencies[job_i]};
+      jobs[job_i] = {FrameJob, &params[job_i]};
+    }
+    PushJobs(queue, jobs, kBurstSize);
+    WaitThreadQueue(queue);
+    latencies.insert(latencies.end(), burst_latencies,
+                     burst_latencies + kBurstSize);
+    WaitBurstGap();
+  }
+  ReportBursts(state, latencies, queue->wake_count.load() - wake_count,
+               queue->park_count.load() - park_count);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolBurst)
+    ->ArgNames({"threads", "low_power"})
+    ->ArgsProduct({{1, 2, 4, 8}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Semaphore signal on every push and park as soon as the queue is empty
+static void BM_LegacyQueueBurst(benchmark::State& state) {
+  LegacyJobQueue* queue = new LegacyJobQueue();
+  CreateLegacyJobQueue(queue, (u32)state.range(0));
+  std::vector<r64> latencies;
+  FrameJobParams params[kBurstSize];
+  r64 burst_latencies[kBurstSize];
+  u64 wake_count = queue->wake_count.load();
+  u64 park_count = queue->park_count.load();
+  for (auto _ : state) {
+    auto pushed = std::chrono::steady_clock::now();
+    for (u32 job_i = 0; job_i < kBurstSize; job_i++) {
+      params[job_i] = {pushed, &burst_latencies[job_i]};
+      LegacyPushJob(queue, {FrameJob, &params[job_i]});
+    }
+    LegacyWaitJobQueue(queue);
+    latencies.insert(latencies.end(), burst_latencies,
+                     burst_latencies + kBurstSize);
+    WaitBurstGap();
+  }
+  ReportBursts(state, latencies, queue->wake_count.load() - wake_count,
+               queue->park_count.load() - park_count);
+  DestroyLegacyJobQueue(queue);
+  delete queue;
+}
+BENCHMARK(BM_LegacyQueueBurst)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Jobs making small temporary allocations, from per-thread scratch arenas or
+// from one shared StackAllocator behind a mutex. Arg is worker count.
+constexpr u32 kAllocJobCount = 1024;
+constexpr u32 kAllocsPerJob = 16;
+constexpr s64 kAllocSize = 64;
+struct MutexStack {
+  std::mutex mutex;
+  StackAllocator* alloc;
+};
+static bool ScratchAllocJob(void* data) {
+  StackAllocator* scratch = GetJobScratch((JobQueue*)data);
+  for (u32 alloc_i = 0; alloc_i < kAllocsPerJob; alloc_i++)
+    benchmark::DoNotOptimize(StackAllocate(scratch, kAllocSize, 16));
+  return false;
+}
+static bool MutexAllocJob(void* data) {
+  MutexStack* stack = (MutexStack*)data;
+  for (u32 alloc_i = 0; alloc_i < kAllocsPerJob; alloc_i++) {
+    std::lock_guard<std::mutex> lock(stack->mutex);
+    benchmark::DoNotOptimize(StackAllocate(stack->alloc, kAllocSize, 16));
+  }
+  return false;
+}
+static void BM_ThreadPoolScratchAllocations(benchmark::State& state) {
+  s64 data_size = Megabytes(64);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  tp_ci.job_capacity = kAllocJobCount;
+  tp_ci.scratch_size = Megabytes(2);
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  for (auto _ : state) {
+    BeginThreadPoolFrame(app->threadpool);
+    for (u32 job_i = 0; job_i < kAllocJobCount; job_i++)
+      PushJob(queue, {ScratchAllocJob, queue});
+    WaitThreadQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kAllocJobCount * kAllocsPerJob);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolScratchAllocations)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+static void BM_ThreadPoolMutexAllocations(benchmark::State& state) {
+  s64 data_size = Megabytes(64);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{(u32)state.range(0), true};
+  tp_ci.job_capacity = kAllocJobCount;
+  ApplicationCreateInfo app_ci{&tp_ci};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  JobQueue* queue = app->threadpool->queue;
+  s64 stack_size = Megabytes(4);
+  MutexStack stack;
+  stack.alloc = CreateStackAllocator(
+      StackAllocate(app->alloc, stack_size, kCacheLineSize), stack_size);
+  for (auto _ : state) {
+    ResetStackAllocator(stack.alloc);
+    for (u32 job_i = 0; job_i < kAllocJobCount; job_i++)
+      PushJob(queue, {MutexAllocJob, &stack});
+    WaitThreadQueue(queue);
+  }
+  state.SetItemsProcessed(state.iterations() * kAllocJobCount * kAllocsPerJob);
+  DestroyApplication(app);
+  free(data);
+}
+BENCHMARK(BM_ThreadPoolMutexAllocations)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
\ No newline at end of file
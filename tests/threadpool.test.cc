@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <rally/thread/threadpool.h>
 
+#include <chrono>
+
 using namespace rally;
 
 struct SetArrayParams {
@@ -17,13 +19,15 @@ TEST(ThreadPool, CreateThreadPool) {
   s64 data_size = Megabytes(1);
   void* data = malloc(data_size);
   ThreadPoolCreateInfo tp_ci{8};
-  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  // Create the pool by hand, a second pool would leak sleeping workers
+  ApplicationCreateInfo app_ci{nullptr, nullptr, nullptr};
   Application* app = CreateApplication(&app_ci, data, data_size);
   CreateThreadPool(&tp_ci, app);
   ThreadPool* tp = app->threadpool;
   EXPECT_EQ(tp->thread_count, tp_ci.thread_count);
-  EXPECT_EQ(tp->queue->front, 0);
-  EXPECT_EQ(tp->queue->end, 0);
+  MpmcRing<Job>* ring = &tp->queue->rings[(u32)JobPriority::kNormal];
+  EXPECT_EQ(ring->front, 0);
+  EXPECT_EQ(ring->end, 0);
   EXPECT_EQ(tp->queue->completion_count, 0);
   EXPECT_EQ(tp->queue->completion_goal,0);
   EXPECT_EQ(tp->queue->active, true);
@@ -60,4 +64,382 @@ TEST(ThreadPool, SetArrayJob) {
   }
   DestroyThreadPool(tp);
   free(data);
+}
+
+TEST(ThreadPool, PinnedThreads) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{kMaxThreadCount, true};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  EXPECT_EQ(tp->thread_count, kMaxThreadCount);
+  u32 arr[kMaxJobCount - 1] = {};
+  SetArrayParams params[kMaxJobCount - 1];
+  for (u32 job_i = 0; job_i < kMaxJobCount - 1; job_i++) {
+    params[job_i] = {arr, job_i};
+    PushJob(tp->queue, {(job_func)SetArray, &params[job_i]});
+  }
+  WaitThreadQueue(tp->queue);
+  for (u32 arr_i = 0; arr_i < kMaxJobCount - 1; arr_i++) {
+    EXPECT_EQ(arr[arr_i], arr_i);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct NestedParams {
+  JobQueue* queue;
+  u32* arr;
+  SetArrayParams* children;
+  u32 child_count;
+};
+
+bool PushChildren(NestedParams* params) {
+  for (u32 child_i = 0; child_i < params->child_count; child_i++) {
+    params->children[child_i] = {params->arr, child_i};
+    PushJob(params->queue, {(job_func)SetArray, &params->children[child_i]});
+  }
+  return false;
+}
+
+TEST(ThreadPool, JobsPushJobs) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  constexpr u32 kParentCount = 4;
+  constexpr u32 kChildCount = 24;
+  u32 arr[kParentCount][kChildCount];
+  SetArrayParams children[kParentCount][kChildCount];
+  NestedParams params[kParentCount];
+  u32 iters = 100;
+  while (iters--) {
+    memset(arr, 0xff, sizeof(arr));
+    for (u32 parent_i = 0; parent_i < kParentCount; parent_i++) {
+      params[parent_i] = {tp->queue, arr[parent_i], children[parent_i],
+                          kChildCount};
+      PushJob(tp->queue, {(job_func)PushChildren, &params[parent_i]});
+    }
+    WaitThreadQueue(tp->queue);
+    EXPECT_EQ(tp->queue->completion_count.load(),
+              tp->queue->completion_goal.load());
+    for (u32 parent_i = 0; parent_i < kParentCount; parent_i++) {
+      for (u32 child_i = 0; child_i < kChildCount; child_i++) {
+        EXPECT_EQ(arr[parent_i][child_i], child_i);
+      }
+    }
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct ParkParams {
+  JobQueue* queue;
+  JobCounter* counter;
+  std::atomic<b32>* done;
+};
+
+bool WaitAndFinish(ParkParams* params) {
+  WaitJobCounter(params->queue, params->counter);
+  params->done->store(true);
+  return false;
+}
+
+static bool SpinUntil(std::atomic<b32>* flag) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!flag->load()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+  }
+  return true;
+}
+
+TEST(ThreadPool, FiberParksWaitingJob) {
+  s64 data_size = Megabytes(4);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{1, false, 4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  ASSERT_EQ(tp->fiber_count, 4);
+  JobCounter counters[2];
+  std::atomic<b32> done[2] = {false, false};
+  ParkParams params[2];
+  for (u32 job_i = 0; job_i < 2; job_i++) {
+    SetJobCounter(&counters[job_i], 1, {});
+    params[job_i] = {tp->queue, &counters[job_i], &done[job_i]};
+    PushJob(tp->queue, {(job_func)WaitAndFinish, &params[job_i]});
+  }
+  // The single worker parks both jobs. Performing the second one on top of the
+  // first would keep the first from finishing until the second one has.
+  SignalJobCounter(tp->queue, &counters[0]);
+  EXPECT_TRUE(SpinUntil(&done[0]));
+  EXPECT_FALSE(done[1].load());
+  SignalJobCounter(tp->queue, &counters[1]);
+  WaitThreadQueue(tp->queue);
+  EXPECT_TRUE(done[1].load());
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+constexpr u32 kForkJoinFanOut = 8;
+struct ForkJoinParams {
+  JobQueue* queue;
+  u32 depth;
+  std::atomic<u32>* leaf_count;
+};
+
+bool ForkJoin(ForkJoinParams* params) {
+  if (params->depth == 0) {
+    params->leaf_count->fetch_add(1);
+    return false;
+  }
+  ForkJoinParams children[kForkJoinFanOut];
+  JobCounter counter;
+  SetJobCounter(&counter, kForkJoinFanOut, {});
+  for (u32 child_i = 0; child_i < kForkJoinFanOut; child_i++) {
+    children[child_i] = {params->queue, params->depth - 1, params->leaf_count};
+    PushJob(params->queue,
+            {(job_func)ForkJoin, &children[child_i], &counter});
+  }
+  WaitJobCounter(params->queue, &counter);
+  return false;
+}
+
+TEST(ThreadPool, FiberForkJoin) {
+  s64 data_size = Megabytes(8);
+  void* data = malloc(data_size);
+  // Fewer fibers than concurrent waits, some waits fall back to performing
+  // jobs.
+  // Whole tree fits in one queue, parked jobs let all of it be pending at once.
+  ThreadPoolCreateInfo tp_ci{4, false, 8};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<u32> leaf_count;
+  u32 iters = 20;
+  while (iters--) {
+    leaf_count.store(0);
+    ForkJoinParams root{tp->queue, 2, &leaf_count};
+    JobCounter counter;
+    SetJobCounter(&counter, 1, {});
+    PushJob(tp->queue, {(job_func)ForkJoin, &root, &counter});
+    WaitJobCounter(tp->queue, &counter);
+    WaitThreadQueue(tp->queue);
+    EXPECT_EQ(leaf_count.load(), kForkJoinFanOut * kForkJoinFanOut);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+bool CountJob(std::atomic<u32>* count) {
+  count->fetch_add(1);
+  return false;
+}
+
+TEST(ThreadPool, JobCapacity) {
+  s64 data_size = Megabytes(8);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  tp_ci.job_capacity = 100000;
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  EXPECT_EQ(tp->queue->rings[(u32)JobPriority::kNormal].mask + 1, 1u << 17);
+  std::atomic<u32> count;
+  u32 iters = 3;
+  while (iters--) {
+    count.store(0);
+    for (u32 job_i = 0; job_i < 100000; job_i++)
+      PushJob(tp->queue, {(job_func)CountJob, &count});
+    WaitThreadQueue(tp->queue);
+    EXPECT_EQ(count.load(), 100000);
+  }
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(ThreadPool, FullQueuePerformsJobs) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{2};
+  tp_ci.job_capacity = 3;
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  EXPECT_EQ(tp->queue->rings[(u32)JobPriority::kNormal].mask + 1, 4);
+  std::atomic<u32> count;
+  count.store(0);
+  for (u32 job_i = 0; job_i < 10000; job_i++)
+    PushJob(tp->queue, {(job_func)CountJob, &count});
+  WaitThreadQueue(tp->queue);
+  EXPECT_EQ(count.load(), 10000);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct BlockParams {
+  std::atomic<b32>* release;
+  std::atomic<u32>* started;
+};
+
+bool BlockUntilReleased(BlockParams* params) {
+  params->started->fetch_add(1);
+  while (!params->release->load()) CpuRelax();
+  return false;
+}
+
+bool SetFlag(std::atomic<b32>* flag) {
+  flag->store(true);
+  return false;
+}
+
+TEST(ThreadPool, BackgroundLimit) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  EXPECT_EQ(tp->queue->background_limit, 2);
+  std::atomic<b32> release;
+  release.store(false);
+  std::atomic<u32> started;
+  started.store(0);
+  BlockParams params{&release, &started};
+  for (u32 job_i = 0; job_i < 8; job_i++)
+    PushJob(tp->queue, {(job_func)BlockUntilReleased, &params, nullptr,
+                        JobPriority::kBackground});
+  // Frame work still gets through while background jobs hog their threads
+  std::atomic<b32> high_done, normal_done;
+  high_done.store(false);
+  normal_done.store(false);
+  PushJob(tp->queue,
+          {(job_func)SetFlag, &high_done, nullptr, JobPriority::kHigh});
+  PushJob(tp->queue, {(job_func)SetFlag, &normal_done});
+  EXPECT_TRUE(SpinUntil(&high_done));
+  EXPECT_TRUE(SpinUntil(&normal_done));
+  EXPECT_LE(started.load(), 2);
+  EXPECT_LE(tp->queue->background_count.load(), 2);
+  release.store(true);
+  WaitThreadQueue(tp->queue);
+  EXPECT_EQ(started.load(), 8);
+  EXPECT_EQ(tp->queue->background_count.load(), 0);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(ThreadPool, IOThreads) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{1};
+  tp_ci.io_thread_count = 2;
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  std::atomic<b32> release;
+  release.store(false);
+  std::atomic<u32> started;
+  started.store(0);
+  BlockParams params{&release, &started};
+  for (u32 job_i = 0; job_i < 4; job_i++)
+    PushJob(tp->queue, {(job_func)BlockUntilReleased, &params, nullptr,
+                        JobPriority::kIO});
+  // Blocked IO jobs occupy the IO threads only
+  std::atomic<b32> normal_done;
+  normal_done.store(false);
+  PushJob(tp->queue, {(job_func)SetFlag, &normal_done});
+  EXPECT_TRUE(SpinUntil(&normal_done));
+  EXPECT_LE(started.load(), 2);
+  release.store(true);
+  WaitThreadQueue(tp->queue);
+  EXPECT_EQ(started.load(), 4);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+TEST(ThreadPool, PushJobsWakesOnce) {
+  s64 data_size = Megabytes(1);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  u32 arr[16] = {};
+  SetArrayParams params[16];
+  Job jobs[16];
+  for (u32 job_i = 0; job_i < 16; job_i++) {
+    params[job_i] = {arr, job_i};
+    jobs[job_i] = {(job_func)SetArray, &params[job_i]};
+  }
+  u32 iters = 10;
+  while (iters--) {
+    // Idle workers spin, then park
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (tp->queue->sleeping_count.load() < tp->thread_count &&
+           std::chrono::steady_clock::now() < deadline) {
+    }
+    ASSERT_EQ(tp->queue->sleeping_count.load(), tp->thread_count);
+    u64 wake_count = tp->queue->wake_count.load();
+    PushJobs(tp->queue, jobs, 16);
+    WaitThreadQueue(tp->queue);
+    EXPECT_EQ(tp->queue->wake_count.load(), wake_count + 1);
+    for (u32 job_i = 0; job_i < 16; job_i++) EXPECT_EQ(arr[job_i], job_i);
+  }
+  EXPECT_GT(tp->queue->park_count.load(), 0);
+  DestroyThreadPool(tp);
+  free(data);
+}
+
+struct ScratchParams {
+  JobQueue* queue;
+  u32 id;
+  std::atomic<u32>* corrupted;
+};
+
+bool FillScratch(ScratchParams* params) {
+  constexpr u32 kValueCount = 64;
+  u32* values = SALLOC(GetJobScratch(params->queue), u32, kValueCount);
+  if (values == nullptr) {
+    params->corrupted->fetch_add(1);
+    return true;
+  }
+  for (u32 value_i = 0; value_i < kValueCount; value_i++)
+    values[value_i] = params->id;
+  // Give other jobs a chance to scribble over the values
+  for (volatile u32 spin_i = 0; spin_i < 1000; spin_i++) {
+  }
+  for (u32 value_i = 0; value_i < kValueCount; value_i++)
+    if (values[value_i] != params->id) params->corrupted->fetch_add(1);
+  return false;
+}
+
+TEST(ThreadPool, JobScratch) {
+  s64 data_size = Megabytes(8);
+  void* data = malloc(data_size);
+  ThreadPoolCreateInfo tp_ci{4};
+  tp_ci.scratch_size = Megabytes(1);
+  ApplicationCreateInfo app_ci{&tp_ci, nullptr, nullptr};
+  Application* app = CreateApplication(&app_ci, data, data_size);
+  ThreadPool* tp = app->threadpool;
+  constexpr u32 kJobCount = 1000;
+  std::atomic<u32> corrupted;
+  corrupted.store(0);
+  ScratchParams params[kJobCount];
+  for (u32 frame_i = 0; frame_i < 20; frame_i++) {
+    BeginThreadPoolFrame(tp);
+    for (u32 job_i = 0; job_i < kJobCount; job_i++) {
+      params[job_i] = {tp->queue, job_i, &corrupted};
+      PushJob(tp->queue, {(job_func)FillScratch, &params[job_i]});
+    }
+    WaitThreadQueue(tp->queue);
+  }
+  EXPECT_EQ(corrupted.load(), 0);
+  // Twenty frames would not fit, arenas must have been reset every frame
+  StackAllocator* scratch = GetJobScratch(tp->queue);
+  EXPECT_LT(scratch->occupied, kJobCount * 64 * sizeof(u32) * 2);
+  DestroyThreadPool(tp);
+  free(data);
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <rally/math/transcendental.h>
+#include <stdlib.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+using namespace rally;
+
+// Each approximation against libm over the same 4k inputs, which stay in L1.
+// values_per_cycle counts time stamp counter cycles, which tick at the
+// nominal frequency rather than the boosted core clock.
+constexpr u32 kValueCount = 4096;
+static r32* AllocateValues(r32 minf, r32 maxf) {
+  r32* values = (r32*)malloc(kValueCount * sizeof(r32));
+  for (u32 value_i = 0; value_i < kValueCount; value_i++)
+    values[value_i] = minf + (maxf - minf) * value_i / kValueCount;
+  return values;
+}
+template <typename Kernel>
+static void RunValues(benchmark::State& state, r32 minf, r32 maxf,
+                      Kernel kernel) {
+  r32* x = AllocateValues(minf, maxf);
+  r32* out = (r32*)malloc(2 * kValueCount * sizeof(r32));
+  u64 cycles = 0;
+  for (auto _ : state) {
+    u64 start = __rdtsc();
+    kernel(x, out);
+    cycles += __rdtsc() - start;
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kValueCount);
+  state.counters["values_per_cycle"] =
+      (double)(state.iterations() * kValueCount) / cycles;
+  free(x);
+  free(out);
+}
+
+static void BM_SinCosLibm(benchmark::State& state) {
+  RunValues(state, -kPi, kPi, [](const r32* x, r32* out) {
+    for (u32 i = 0; i < kValueCount; i++) {
+      out[i] = sinf(x[i]);
+      out[kValueCount + i] = cosf(x[i]);
+    }
+  });
+}
+BENCHMARK(BM_SinCosLibm);
+static void BM_VSinCosBatch(benchmark::State& state) {
+  RunValues(state, -kPi, kPi, [](const r32* x, r32* out) {
+    VSinCosBatch(x, kValueCount, out, out + kValueCount);
+  });
+}
+BENCHMARK(BM_VSinCosBatch);
+
+static void BM_TanLibm(benchmark::State& state) {
+  RunValues(state, -1.5f, 1.5f, [](const r32* x, r32* out) {
+    for (u32 i = 0; i < kValueCount; i++) out[i] = tanf(x[i]);
+  });
+}
+BENCHMARK(BM_TanLibm);
+static void BM_VTanBatch(benchmark::State& state) {
+  RunValues(state, -1.5f, 1.5f, [](const r32* x, r32* out) {
+    VTanBatch(x, kValueCount, out);
+  });
+}
+BENCHMARK(BM_VTanBatch);
+
+static void BM_ExpLibm(benchmark::State& state) {
+  RunValues(state, -80.0f, 80.0f, [](const r32* x, r32* out) {
+    for (u32 i = 0; i < kValueCount; i++) out[i] = expf(x[i]);
+  });
+}
+BENCHMARK(BM_ExpLibm);
+static void BM_VExpBatch(benchmark::State& state) {
+  RunValues(state, -80.0f, 80.0f, [](const r32* x, r32* out) {
+    VExpBatch(x, kValueCount, out);
+  });
+}
+BENCHMARK(BM_VExpBatch);
+
+static void BM_LogLibm(benchmark::State& state) {
+  RunValues(state, 1e-3f, 1e3f, [](const r32* x, r32* out) {
+    for (u32 i = 0; i < kValueCount; i++) out[i] = logf(x[i]);
+  });
+}
+BENCHMARK(BM_LogLibm);
+static void BM_VLogBatch(benchmark::State& state) {
+  RunValues(state, 1e-3f, 1e3f, [](const r32* x, r32* out) {
+    VLogBatch(x, kValueCount, out);
+  });
+}
+BENCHMARK(BM_VLogBatch);
+
+// MRotation now evaluates its three angles in one VSinCos4
+static void BM_MRotation(benchmark::State& state) {
+  Mat4 R;
+  r32 angle = 0.0f;
+  for (auto _ : state) {
+    MRotation(angle, 0.2f, 0.3f, R);
+    benchmark::DoNotOptimize(R);
+    angle += 0.01f;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MRotation);
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <float.h>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <rally/math/transcendental.h>
+
+using namespace rally;
+
+// Error of approx in ulp of the correctly rounded reference
+static double UlpError(r32 approx, double reference) {
+  r32 rounded = fabsf((r32)reference);
+  r32 ulp = rounded < FLT_MIN ? FLT_TRUE_MIN
+                              : nextafterf(rounded, INFINITY) - rounded;
+  return fabs((double)approx - reference) / ulp;
+}
+// Sample arrays are static, three of them would crowd a 1 MB stack
+constexpr u32 kSampleCount = 1 << 16;
+static r32 Sample(r32 minf, r32 maxf, u32 sample_i) {
+  return minf + (maxf - minf) * ((r32)sample_i / kSampleCount);
+}
+
+TEST(Transcendental, SinCos) {
+  static r32 x[kSampleCount], sin_x[kSampleCount], cos_x[kSampleCount];
+  for (u32 i = 0; i < kSampleCount; i++) x[i] = Sample(-8192.0f, 8192.0f, i);
+  VSinCosBatch(x, kSampleCount, sin_x, cos_x);
+  for (u32 i = 0; i < kSampleCount; i++) {
+    double sin_ref = sin((double)x[i]);
+    double cos_ref = cos((double)x[i]);
+    if (fabs(sin_ref) >= 1e-3) {
+      EXPECT_LE(UlpError(sin_x[i], sin_ref), 2.0);
+    }
+    if (fabs(cos_ref) >= 1e-3) {
+      EXPECT_LE(UlpError(cos_x[i], cos_ref), 2.0);
+    }
+    EXPECT_LE(fabs(sin_x[i] - sin_ref), 1e-7);
+    EXPECT_LE(fabs(cos_x[i] - cos_ref), 1e-7);
+  }
+  // Odd signs and exact zero
+  Vec4 s, c;
+  VSinCos4(Vec4{0.0f, -0.0f, -kPi / 2, kPi}, s, c);
+  alignas(16) r32 sf[4], cf[4];
+  VStore(s, sf);
+  VStore(c, cf);
+  EXPECT_EQ(sf[0], 0.0f);
+  EXPECT_EQ(cf[0], 1.0f);
+  EXPECT_EQ(signbit(sf[1]), true);
+  EXPECT_LE(UlpError(sf[2], -1.0), 2.0);
+  EXPECT_LE(UlpError(cf[3], -1.0), 2.0);
+}
+
+TEST(Transcendental, Tan) {
+  static r32 x[kSampleCount], tan_x[kSampleCount];
+  for (u32 i = 0; i < kSampleCount; i++) x[i] = Sample(-8192.0f, 8192.0f, i);
+  VTanBatch(x, kSampleCount, tan_x);
+  for (u32 i = 0; i < kSampleCount; i++) {
+    double tan_ref = tan((double)x[i]);
+    if (fabs(tan_ref) < 1e-3 || fabs(cos((double)x[i])) < 1e-2) continue;
+    EXPECT_LE(UlpError(tan_x[i], tan_ref), 4.0);
+  }
+}
+
+TEST(Transcendental, Exp) {
+  static r32 x[kSampleCount], exp_x[kSampleCount];
+  for (u32 i = 0; i < kSampleCount; i++) x[i] = Sample(-87.3f, 88.3f, i);
+  VExpBatch(x, kSampleCount, exp_x);
+  for (u32 i = 0; i < kSampleCount; i++)
+    EXPECT_LE(UlpError(exp_x[i], exp((double)x[i])), 1.0);
+  alignas(16) r32 ef[4];
+  VStore(VExp4(Vec4{0.0f, -INFINITY, INFINITY, NAN}), ef);
+  EXPECT_EQ(ef[0], 1.0f);
+  EXPECT_GT(ef[1], 0.0f);
+  EXPECT_EQ(isfinite(ef[2]), true);
+  EXPECT_EQ(isfinite(ef[3]), true);
+}
+
+TEST(Transcendental, Log) {
+  static r32 x[kSampleCount], log_x[kSampleCount];
+  // Every exponent of the normal range with a spread of mantissas
+  for (u32 i = 0; i < kSampleCount; i++)
+    x[i] = ldexpf(1.0f + (r32)(i % 256) / 256.0f, (i / 256) % 252 - 126);
+  VLogBatch(x, kSampleCount, log_x);
+  for (u32 i = 0; i < kSampleCount; i++)
+    EXPECT_LE(UlpError(log_x[i], log((double)x[i])), 1.0);
+  alignas(16) r32 lf[4];
+  VStore(VLog4(Vec4{0.0f, -1.0f, INFINITY, NAN}), lf);
+  EXPECT_EQ(lf[0], -INFINITY);
+  EXPECT_EQ(isnan(lf[1]), true);
+  EXPECT_EQ(lf[2], INFINITY);
+  EXPECT_EQ(isnan(lf[3]), true);
+}
+
+TEST(Transcendental, Batch) {
+  // Odd count leaves a tail, values past count must stay untouched
+  constexpr u32 kCount = 7;
+  r32 x[kCount + 1], out[kCount + 1], out_cos[kCount + 1];
+  for (u32 i = 0; i < kCount; i++) x[i] = 0.25f * i + 0.5f;
+  x[kCount] = 1.0f;
+  out[kCount] = out_cos[kCount] = -1.0f;
+  VSinCosBatch(x, kCount, out, out_cos);
+  EXPECT_EQ(out[kCount], -1.0f);
+  EXPECT_EQ(out_cos[kCount], -1.0f);
+  for (u32 i = 0; i < kCount; i++) {
+    EXPECT_LE(UlpError(out[i], sin((double)x[i])), 2.0);
+    EXPECT_LE(UlpError(out_cos[i], cos((double)x[i])), 2.0);
+  }
+  // Output may replace the input
+  r32 y[kCount];
+  memcpy(y, x, sizeof(y));
+  VLogBatch(y, kCount, y);
+  for (u32 i = 0; i < kCount; i++)
+    EXPECT_LE(UlpError(y[i], log((double)x[i])), 1.0);
+  VExpBatch(y, kCount, y);
+  for (u32 i = 0; i < kCount; i++) EXPECT_NEAR(y[i], x[i], 4e-6f * x[i]);
+}
\ No newline at end of file
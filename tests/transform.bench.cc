@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <rally/math/transform.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+// Scene hierarchies compose parent and local transforms every frame. The same
+// transforms are composed as Transforms and as the Mat4s they expand to.
+static void FillTransforms(Transform* transforms, u32 count) {
+  for (u32 transform_i = 0; transform_i < count; transform_i++)
+    transforms[transform_i] = {QEuler(0.1f * transform_i, 0.2f, 0.3f),
+                               {(r32)transform_i, 1.0f, 2.0f},
+                               1.0f};
+}
+template <typename T>
+static T* AllocateArray(u32 count) {
+  return (T*)aligned_alloc(alignof(T), count * sizeof(T));
+}
+static void ComposeArgs(benchmark::internal::Benchmark* bench) {
+  for (i64 count = 1 << 10; count <= 1 << 20; count <<= 5) bench->Arg(count);
+}
+
+static void BM_TComposeBatch(benchmark::State& state) {
+  u32 count = (u32)state.range(0);
+  Transform* parent = AllocateArray<Transform>(count);
+  Transform* child = AllocateArray<Transform>(count);
+  Transform* out = AllocateArray<Transform>(count);
+  FillTransforms(parent, count);
+  FillTransforms(child, count);
+  for (auto _ : state) {
+    TComposeBatch(parent, child, count, out);
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetBytesProcessed(state.iterations() * count * 3 * sizeof(Transform));
+  free(parent);
+  free(child);
+  free(out);
+}
+BENCHMARK(BM_TComposeBatch)->Apply(ComposeArgs);
+
+static void BM_MMulBatchCompose(benchmark::State& state) {
+  u32 count = (u32)state.range(0);
+  Transform* transforms = AllocateArray<Transform>(count);
+  Mat4* parent = AllocateArray<Mat4>(count);
+  Mat4* child = AllocateArray<Mat4>(count);
+  Mat4* out = AllocateArray<Mat4>(count);
+  FillTransforms(transforms, count);
+  MFromTransformBatch(transforms, count, parent);
+  MFromTransformBatch(transforms, count, child);
+  for (auto _ : state) {
+    MMulBatch(parent, child, count, out);
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  state.SetBytesProcessed(state.iterations() * count * 3 * sizeof(Mat4));
+  free(transforms);
+  free(parent);
+  free(child);
+  free(out);
+}
+BENCHMARK(BM_MMulBatchCompose)->Apply(ComposeArgs);
+
+static void BM_MFromTransformBatch(benchmark::State& state) {
+  u32 count = (u32)state.range(0);
+  Transform* transforms = AllocateArray<Transform>(count);
+  Mat4* out = AllocateArray<Mat4>(count);
+  FillTransforms(transforms, count);
+  for (auto _ : state) {
+    MFromTransformBatch(transforms, count, out);
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  free(transforms);
+  free(out);
+}
+BENCHMARK(BM_MFromTransformBatch)->Apply(ComposeArgs);
+
+constexpr u32 kInterpolateCount = 1024;
+template <Quat (*interpolate)(const Quat&, const Quat&, r32)>
+static void BM_Interpolate(benchmark::State& state) {
+  Quat* a = AllocateArray<Quat>(kInterpolateCount);
+  Quat* b = AllocateArray<Quat>(kInterpolateCount);
+  Quat* out = AllocateArray<Quat>(kInterpolateCount);
+  for (u32 quat_i = 0; quat_i < kInterpolateCount; quat_i++) {
+    a[quat_i] = QEuler(0.1f * quat_i, 0.2f, 0.3f);
+    b[quat_i] = QEuler(0.3f, 0.1f * quat_i, 0.2f);
+  }
+  for (auto _ : state) {
+    for (u32 quat_i = 0; quat_i < kInterpolateCount; quat_i++)
+      out[quat_i] = interpolate(a[quat_i], b[quat_i], 0.3f);
+    benchmark::DoNotOptimize(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kInterpolateCount);
+  free(a);
+  free(b);
+  free(out);
+}
+BENCHMARK_TEMPLATE(BM_Interpolate, QNlerp);
+BENCHMARK_TEMPLATE(BM_Interpolate, QSlerp);
\ No newline at end of file
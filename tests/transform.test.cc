@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include <rally/math/transform.h>
+
+#include "testrandom.h"
+
+using namespace rally;
+
+inline Vec3 RandVec3(const r32 magnitude) {
+  return Vec3{RandR32(-magnitude, magnitude), RandR32(-magnitude, magnitude),
+              RandR32(-magnitude, magnitude), 0.0f};
+}
+inline Quat RandQuat() {
+  return QEuler(RandR32(-kPi, kPi), RandR32(-kPi, kPi), RandR32(-kPi, kPi));
+}
+inline Transform RandTransform() {
+  Transform a;
+  a.rotation = RandQuat();
+  a.translation = {RandR32(-100.0f, 100.0f), RandR32(-100.0f, 100.0f),
+                   RandR32(-100.0f, 100.0f)};
+  a.scale = RandR32(0.5f, 2.0f);
+  return a;
+}
+// q and -q are the same rotation
+inline bool QNear(const Quat& a, const Quat& b) {
+  return abs(QDot(a, b)) > 1.0f - eps;
+}
+
+TEST(Transform, Size) {
+  EXPECT_EQ(sizeof(Quat), 16);
+  EXPECT_EQ(sizeof(Transform), 32);
+  EXPECT_EQ(alignof(Transform), 16);
+}
+
+TEST(Transform, QEuler) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    r32 rotx = RandR32(-kPi, kPi);
+    r32 roty = RandR32(-kPi, kPi);
+    r32 rotz = RandR32(-kPi, kPi);
+    Quat q = QEuler(rotx, roty, rotz);
+    EXPECT_LE(abs(QDot(q, q) - 1.0f), eps);
+    EXPECT_EQ(MNear(MRotation(q), MRotation(rotx, roty, rotz)), true);
+  }
+}
+
+TEST(Transform, QAxisAngle) {
+  Quat qx = QAxisAngle(Vec3{1.0f, 0.0f, 0.0f, 0.0f}, 0.5f);
+  Quat qy = QAxisAngle(Vec3{0.0f, 1.0f, 0.0f, 0.0f}, -1.0f);
+  Quat qz = QAxisAngle(Vec3{0.0f, 0.0f, 1.0f, 0.0f}, 2.0f);
+  EXPECT_EQ(QNear(qx, QEuler(0.5f, 0.0f, 0.0f)), true);
+  EXPECT_EQ(QNear(qy, QEuler(0.0f, -1.0f, 0.0f)), true);
+  EXPECT_EQ(QNear(qz, QEuler(0.0f, 0.0f, 2.0f)), true);
+  EXPECT_EQ(QNear(QMul(qz, QMul(qy, qx)), QEuler(0.5f, -1.0f, 2.0f)), true);
+}
+
+TEST(Transform, QMul) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    Quat a = RandQuat();
+    Quat b = RandQuat();
+    EXPECT_EQ(MNear(MRotation(QMul(a, b)), MMul(MRotation(a), MRotation(b))),
+              true);
+    EXPECT_EQ(QNear(QMul(a, QConjugate(a)), kQuatIdentity), true);
+    EXPECT_EQ(QNear(QMul(kQuatIdentity, b), b), true);
+  }
+}
+
+TEST(Transform, QRotate) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    Quat q = RandQuat();
+    Vec3 v = RandVec3(100.0f);
+    Vec4 rotated = VMul(MRotation(q), Vec4{v.data});
+    EXPECT_EQ(VNear(Vec4{QRotate(q, v).data}, rotated), true);
+  }
+}
+
+TEST(Transform, QSlerp) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    Quat a = RandQuat();
+    Quat b = RandQuat();
+    EXPECT_EQ(QNear(QSlerp(a, b, 0.0f), a), true);
+    EXPECT_EQ(QNear(QSlerp(a, b, 1.0f), b), true);
+    // Halfway lies at equal angles from both ends
+    Quat half = QSlerp(a, b, 0.5f);
+    EXPECT_LE(abs(QDot(half, half) - 1.0f), eps);
+    EXPECT_LE(abs(abs(QDot(half, a)) - abs(QDot(half, b))), eps);
+    EXPECT_EQ(QNear(half, QNlerp(a, b, 0.5f)), true);
+    // Constant angular speed, a quarter of the way covers a quarter angle
+    r32 theta = acosf(fminf(abs(QDot(a, b)), 1.0f));
+    r32 quarter = acosf(fminf(abs(QDot(QSlerp(a, b, 0.25f), a)), 1.0f));
+    EXPECT_LE(abs(quarter - 0.25f * theta), 1e-3f);
+  }
+}
+
+TEST(Transform, TCompose) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    Transform a = RandTransform();
+    Transform b = RandTransform();
+    Mat4 ab = MMul(MFromTransform(a), MFromTransform(b));
+    EXPECT_EQ(MNear(MFromTransform(TCompose(a, b)), ab), true);
+    Vec3 p = RandVec3(100.0f);
+    Vec4 point = {_mm_add_ps(p.data, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f))};
+    Vec4 transformed = {TTransformPoint(TCompose(a, b), p).data};
+    EXPECT_EQ(VNear(VAdd(transformed, Vec4{0.0f, 0.0f, 0.0f, 1.0f}),
+                    VMul(ab, point)),
+              true);
+  }
+}
+
+TEST(Transform, TInverse) {
+  u32 iters = 100;
+  SeedRand(0);
+  while (iters--) {
+    Transform a = RandTransform();
+    Transform ai = TInverse(a);
+    EXPECT_EQ(MNear(MFromTransform(ai), MInverseAffine(MFromTransform(a))),
+              true);
+    EXPECT_EQ(MNear(MFromTransform(TCompose(a, ai)), kIdentity), true);
+  }
+}
+
+TEST(Transform, TComposeBatch) {
+  constexpr u32 kCount = 37;
+  Transform parent[kCount], child[kCount], out[kCount];
+  Mat4 M[kCount];
+  SeedRand(0);
+  for (u32 i = 0; i < kCount; i++) {
+    parent[i] = RandTransform();
+    child[i] = RandTransform();
+  }
+  TComposeBatch(parent, child, kCount, out);
+  MFromTransformBatch(out, kCount, M);
+  for (u32 i = 0; i < kCount; i++) {
+    EXPECT_EQ(MNear(M[i], MMul(MFromTransform(parent[i]),
+                               MFromTransform(child[i]))),
+              true);
+  }
+  // Output may replace either input
+  TComposeBatch(parent, child, kCount, child);
+  for (u32 i = 0; i < kCount; i++)
+    EXPECT_EQ(MNear(MFromTransform(child[i]), M[i]), true);
+}
\ No newline at end of file
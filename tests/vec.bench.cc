@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+#include <rally/math/simd.h>
+#include <rally/math/vec.h>
+#include <stdlib.h>
+
+using namespace rally;
+
+// Inputs of every benchmark, filled once so only the kernels are timed
+static void FillMatrices(Mat4* mats, u32 count) {
+  for (u32 mat_i = 0; mat_i < count; mat_i++)
+    mats[mat_i] = MMul(MTranslation((r32)mat_i, 1.0f, 2.0f),
+                       MRotation(0.1f * mat_i, 0.2f, 0.3f));
+}
+static Mat4* AllocateMatrices(u32 count) {
+  return (Mat4*)aligned_alloc(alignof(Mat4), count * sizeof(Mat4));
+}
+// Args are the element count and the SimdLevel, -1 for one call per element
+static b32 SetBenchLevel(benchmark::State& state) {
+  if (state.range(1) < 0) return false;
+  SimdLevel level = (SimdLevel)state.range(1);
+  if (SetSimdLevel(level) != level) {
+    state.SkipWithError("SIMD level not supported");
+    return true;
+  }
+  return false;
+}
+static void BatchArgs(benchmark::internal::Benchmark* bench) {
+  for (i64 count = 1 << 10; count <= 1 << 20; count <<= 5)
+    for (i64 level = -1; level <= (i64)SimdLevel::kAvx512; level++)
+      bench->Args({count, level});
+}
+
+static void BM_MMulBatch(benchmark::State& state) {
+  if (SetBenchLevel(state)) return;
+  u32 count = (u32)state.range(0);
+  Mat4* A = AllocateMatrices(count);
+  Mat4* B = AllocateMatrices(count);
+  Mat4* AB = AllocateMatrices(count);
+  FillMatrices(A, count);
+  FillMatrices(B, count);
+  for (auto _ : state) {
+    if (state.range(1) < 0) {
+      for (u32 mat_i = 0; mat_i < count; mat_i++)
+        MMul(A[mat_i], B[mat_i], AB[mat_i]);
+    } else {
+      MMulBatch(A, B, count, AB);
+    }
+    benchmark::DoNotOptimize(AB);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  SetSimdLevel(GetCpuSimdLevel());
+  free(A);
+  free(B);
+  free(AB);
+}
+BENCHMARK(BM_MMulBatch)->Apply(BatchArgs);
+
+static void BM_VMulBatch(benchmark::State& state) {
+  if (SetBenchLevel(state)) return;
+  u32 count = (u32)state.range(0);
+  Mat4 A = MMul(MTranslation(1.0f, 2.0f, 3.0f), MRotation(0.1f, 0.2f, 0.3f));
+  Vec4* b = (Vec4*)aligned_alloc(alignof(Vec4), count * sizeof(Vec4));
+  Vec4* Ab = (Vec4*)aligned_alloc(alignof(Vec4), count * sizeof(Vec4));
+  for (u32 vec_i = 0; vec_i < count; vec_i++)
+    b[vec_i] = Vec4{(r32)vec_i, 1.0f, 2.0f, 1.0f};
+  for (auto _ : state) {
+    if (state.range(1) < 0) {
+      for (u32 vec_i = 0; vec_i < count; vec_i++)
+        VMul(A, b[vec_i], Ab[vec_i]);
+    } else {
+      VMulBatch(A, b, count, Ab);
+    }
+    benchmark::DoNotOptimize(Ab);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  SetSimdLevel(GetCpuSimdLevel());
+  free(b);
+  free(Ab);
+}
+BENCHMARK(BM_VMulBatch)->Apply(BatchArgs);
+
+// SoA points against the same points as Vec4s through VMul
+static void BM_MTransformPoints(benchmark::State& state) {
+  if (SetBenchLevel(state)) return;
+  u32 count = (u32)state.range(0);
+  Mat4 A = MMul(MTranslation(1.0f, 2.0f, 3.0f), MRotation(0.1f, 0.2f, 0.3f));
+  r32* streams = (r32*)malloc(6 * count * sizeof(r32));
+  for (u32 point_i = 0; point_i < 3 * count; point_i++)
+    streams[point_i] = (r32)point_i;
+  PointStreams points = {streams, streams + count, streams + 2 * count};
+  PointStreams out_points = {streams + 3 * count, streams + 4 * count,
+                             streams + 5 * count};
+  Vec4* b = (Vec4*)aligned_alloc(alignof(Vec4), count * sizeof(Vec4));
+  Vec4* Ab = (Vec4*)aligned_alloc(alignof(Vec4), count * sizeof(Vec4));
+  for (u32 point_i = 0; point_i < count; point_i++)
+    b[point_i] = Vec4{points.x[point_i], points.y[point_i], points.z[point_i],
+                      1.0f};
+  for (auto _ : state) {
+    if (state.range(1) < 0) {
+      for (u32 point_i = 0; point_i < count; point_i++)
+        VMul(A, b[point_i], Ab[point_i]);
+    } else {
+      MTransformPoints(A, points, count, out_points);
+    }
+    benchmark::DoNotOptimize(streams);
+    benchmark::DoNotOptimize(Ab);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  SetSimdLevel(GetCpuSimdLevel());
+  free(streams);
+  free(b);
+  free(Ab);
+}
+BENCHMARK(BM_MTransformPoints)->Apply(BatchArgs);
+
+// MInverse before the cofactor version, LU and one solve per column
+static void MInverseLU(const Mat4& A, Mat4& out_AI) {
+  Mat4 L, U;
+  LUDecomposition(A, L, U);
+  for (u32 col_i = 0; col_i < 4; col_i++) {
+    Vec4 y;
+    ForwardSubstitution(L, kIdentity.cols[col_i], y);
+    BackSubstitution(U, y, out_AI.cols[col_i]);
+  }
+}
+constexpr u32 kInverseCount = 1024;
+template <void (*inverse)(const Mat4&, Mat4&)>
+static void BM_Inverse(benchmark::State& state) {
+  Mat4* A = AllocateMatrices(kInverseCount);
+  Mat4* AI = AllocateMatrices(kInverseCount);
+  FillMatrices(A, kInverseCount);
+  for (auto _ : state) {
+    for (u32 mat_i = 0; mat_i < kInverseCount; mat_i++)
+      inverse(A[mat_i], AI[mat_i]);
+    benchmark::DoNotOptimize(AI);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kInverseCount);
+  free(A);
+  free(AI);
+}
+BENCHMARK_TEMPLATE(BM_Inverse, MInverseLU);
+BENCHMARK_TEMPLATE(BM_Inverse, MInverse);
+BENCHMARK_TEMPLATE(BM_Inverse, MInverseAffine);
+BENCHMARK_TEMPLATE(BM_Inverse, MInverseRigid);
\ No newline at end of file
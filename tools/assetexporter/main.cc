@@ -2,7 +2,10 @@
 #include <assimp/scene.h>
 #include <direct.h>
 #include <rally/application/application.h>
+#include <rally/dev/dev.h>
 #include <rally/math/geometry.h>
+#include <rally/math/packing.h>
+#include <rally/scene/meshoptimizer.h>
 #include <stdio.h>
 #include <sys/stat.h>
 
@@ -14,66 +17,162 @@ using namespace rally;
 
 #define REL_POINT(p, base, type) p = (type*)((char*)p - (char*)base)
 
+constexpr u32 kImportFlags = aiProcess_Triangulate | aiProcess_GenNormals |
+                            aiProcess_GenUVCoords |
+                            aiProcess_CalcTangentSpace;
+
+// Points and lines are left out of the index buffer
+u32 CountTriangles(const aiMesh* mesh) {
+  u32 triangle_count = 0;
+  for (u32 face_i = 0; face_i < mesh->mNumFaces; face_i++)
+    triangle_count += mesh->mFaces[face_i].mNumIndices == 3;
+  return triangle_count;
+}
+
 void PreprocessModel(const char* read_buffer, SceneCreateInfo* scene_ci) {
-  // TODO: Correct index processing with aiFace
   char filename_buffer[256];
   sscanf(read_buffer + 6, "%s", filename_buffer);
   Assimp::Importer* importer = new Assimp::Importer();
   std::string filepath = filename_buffer;
-  importer->ReadFile(filepath, aiProcess_GenNormals | aiProcess_GenUVCoords |
-                                   aiProcess_CalcTangentSpace);
+  importer->ReadFile(filepath, kImportFlags);
   const aiScene* scene = importer->GetScene();
   u32 num_meshes = scene->mNumMeshes;
   scene_ci->max_meshes += num_meshes;
+  // Upper bounds before welding, assuming 32-bit indices plus alignment
   for (u32 mesh_i = 0; mesh_i < num_meshes; mesh_i++) {
     const aiMesh* mesh = scene->mMeshes[mesh_i];
-    u32 vert_count = mesh->mNumVertices;
-    scene_ci->max_vertices += vert_count;
-    scene_ci->max_indices += vert_count;
+    scene_ci->max_vertices += mesh->mNumVertices;
+    scene_ci->max_index_bytes +=
+        (CountTriangles(mesh) * 3 + 1) * sizeof(u32);
   }
   delete importer;
 }
 
-void ProcessModel(const char* read_buffer, Scene* scene) {
-  // TODO: Correct index processing with aiFace
+// Returns true if the model does not fit the preprocessed scene or the
+// exporter runs out of temporary memory
+bool ProcessModel(const char* read_buffer, Application* app, bool optimize) {
   char filename_buffer[256];
   sscanf(read_buffer + 6, "%s", filename_buffer);
   Assimp::Importer* importer = new Assimp::Importer();
   std::string filepath = filename_buffer;
-  importer->ReadFile(filepath, aiProcess_GenNormals | aiProcess_GenUVCoords |
-                                   aiProcess_CalcTangentSpace);
+  importer->ReadFile(filepath, kImportFlags);
   const aiScene* ai_scene = importer->GetScene();
+  SceneResources* res = app->scene->resources;
+  VertexStreams& vertices = res->vertices;
   u32 num_meshes = ai_scene->mNumMeshes;
-  u32 mesh_offset = scene->resources->mesh_count;
   for (u32 mesh_i = 0; mesh_i < num_meshes; mesh_i++) {
-    const aiMesh* mesh = ai_scene->mMeshes[mesh_i];
-    u32 vert_count = mesh->mNumVertices;
-    u32 vert_offset = scene->resources->vertex_count;
-    u32 index_offset = scene->resources->index_count;
+    const aiMesh* ai_mesh = ai_scene->mMeshes[mesh_i];
+    u32 vert_count = ai_mesh->mNumVertices;
+    u32 vert_offset = res->vertex_count;
     for (u32 vert_i = 0; vert_i < vert_count; vert_i++) {
-      const aiVector3D ai_vertex = mesh->mVertices[vert_i];
-      const aiVector3D ai_normal = mesh->mNormals[vert_i];
-      const aiVector3D ai_tan = mesh->mTangents[vert_i];
-      const aiVector3D ai_bitan = mesh->mBitangents[vert_i];
-      const aiVector3D ai_uv = mesh->mTextureCoords[0][vert_i];
-      Vertex vert{{ai_vertex.x, ai_vertex.y, ai_vertex.z},
-                  {ai_normal.x, ai_normal.y, ai_normal.z},
-                  {ai_tan.x, ai_tan.y, ai_tan.z},
-                  {ai_bitan.x, ai_bitan.y, ai_bitan.z},
-                  {ai_uv.x, ai_uv.y}};
-      scene->resources->vertices[vert_i + vert_offset] = vert;
-      scene->resources->indices[vert_i + index_offset] = vert_i;
+      const aiVector3D ai_vertex = ai_mesh->mVertices[vert_i];
+      const aiVector3D ai_normal = ai_mesh->mNormals[vert_i];
+      const aiVector3D ai_tan = ai_mesh->mTangents[vert_i];
+      const aiVector3D ai_bitan = ai_mesh->mBitangents[vert_i];
+      const aiVector3D ai_uv = ai_mesh->mTextureCoords[0][vert_i];
+      u32 dst_i = vert_i + vert_offset;
+      Float3 normal{ai_normal.x, ai_normal.y, ai_normal.z};
+      vertices.positions[dst_i] = {ai_vertex.x, ai_vertex.y, ai_vertex.z};
+      vertices.normals[dst_i] = EncodeOctNormal(normal);
+      vertices.tangent_frames[dst_i] =
+          EncodeTangentFrame(normal, {ai_tan.x, ai_tan.y, ai_tan.z},
+                             {ai_bitan.x, ai_bitan.y, ai_bitan.z});
+      vertices.uvs[dst_i] = EncodeHalfUv(ai_uv.x, ai_uv.y);
+    }
+
+    // Weld after encoding, so vertices that only differed below the
+    // precision of the compressed formats are merged too
+    u32* remap = SALLOC(app->alloc, u32, vert_count);
+    u32 welded_count = 0;
+    if (remap == nullptr ||
+        WeldVertices(app->alloc, &vertices, vert_offset, vert_count, remap,
+                     &welded_count)) {
+      printf("Out of memory for welding %s\n", filename_buffer);
+      delete importer;
+      return true;
     }
-    scene->resources->meshes[mesh_i + mesh_offset].vertex_offset = vert_offset;
-    scene->resources->meshes[mesh_i + mesh_offset].index_offset = index_offset;
-    scene->resources->meshes[mesh_i + mesh_offset].vertex_count = vert_count;
-    scene->resources->meshes[mesh_i + mesh_offset].index_count = vert_count;
-
-    scene->resources->vertex_count += vert_count;
-    scene->resources->index_count += vert_count;
-    scene->resources->mesh_count++;
+    u32 index_count = CountTriangles(ai_mesh) * 3;
+    u32* indices = SALLOC(app->alloc, u32, index_count);
+    if (indices == nullptr) {
+      printf("Out of memory for the indices of %s\n", filename_buffer);
+      delete importer;
+      return true;
+    }
+    u32 index_i = 0;
+    for (u32 face_i = 0; face_i < ai_mesh->mNumFaces; face_i++) {
+      const aiFace& face = ai_mesh->mFaces[face_i];
+      if (face.mNumIndices != 3) continue;
+      for (u32 corner_i = 0; corner_i < 3; corner_i++)
+        indices[index_i++] = remap[face.mIndices[corner_i]];
+    }
+
+    if (optimize) {
+      VertexCacheStats before, after;
+      bool failed = AnalyzeVertexCache(app->alloc, indices, index_count,
+                                       welded_count, kVertexCacheSize, &before);
+      failed |= OptimizeVertexCache(app->alloc, indices, index_count,
+                                    welded_count, kVertexCacheSize);
+      failed |= OptimizeVertexFetch(app->alloc, &vertices, vert_offset,
+                                    welded_count, indices, index_count,
+                                    &welded_count);
+      failed |= AnalyzeVertexCache(app->alloc, indices, index_count,
+                                   welded_count, kVertexCacheSize, &after);
+      if (failed) {
+        printf("Out of memory for optimizing %s\n", filename_buffer);
+        delete importer;
+        return true;
+      }
+      printf("Mesh %u: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+             res->mesh_count, before.acmr, after.acmr, before.atvr,
+             after.atvr);
+    }
+
+    Mesh* mesh = &res->meshes[res->mesh_count];
+    mesh->vertex_offset = vert_offset;
+    mesh->vertex_count = welded_count;
+    if (AppendMeshIndices(res, mesh, indices, index_count)) {
+      printf("Index buffer is full at %s\n", filename_buffer);
+      delete importer;
+      return true;
+    }
+    StackFree(app->alloc);
+    StackFree(app->alloc);
+    printf("Mesh %u: %u vertices welded to %u, %u-bit indices\n",
+           res->mesh_count, vert_count, welded_count, mesh->index_size * 8);
+
+    res->vertex_count += welded_count;
+    res->mesh_count++;
   }
   delete importer;
+  return false;
+}
+
+// Welding leaves the preprocessed sizes as upper bounds, copy the resources
+// into a scene sized by the actual counts
+void CompactScene(Application* app, SceneCreateInfo* scene_ci) {
+  const SceneResources* src = app->scene->resources;
+  scene_ci->max_meshes = src->mesh_count;
+  scene_ci->max_vertices = src->vertex_count;
+  scene_ci->max_index_bytes = (src->index_bytes + 3) & ~3u;
+  scene_ci->max_materials = src->material_count;
+  CreateScene(scene_ci, app);
+  SceneResources* dst = app->scene->resources;
+  memcpy(dst->meshes, src->meshes, src->mesh_count * sizeof(Mesh));
+  memcpy(dst->vertices.positions, src->vertices.positions,
+         src->vertex_count * sizeof(Float3));
+  memcpy(dst->vertices.normals, src->vertices.normals,
+         src->vertex_count * sizeof(OctNormal));
+  memcpy(dst->vertices.tangent_frames, src->vertices.tangent_frames,
+         src->vertex_count * sizeof(TangentFrame));
+  memcpy(dst->vertices.uvs, src->vertices.uvs,
+         src->vertex_count * sizeof(HalfUv));
+  memcpy(dst->indices, src->indices, src->index_bytes);
+  memcpy(dst->materials, src->materials,
+         src->material_count * sizeof(Material));
+  dst->mesh_count = src->mesh_count;
+  dst->vertex_count = src->vertex_count;
+  dst->index_bytes = src->index_bytes;
+  dst->material_count = src->material_count;
 }
 
 void PreprocessMaterial(char* read_buffer, SceneCreateInfo* scene_ci) {
@@ -89,12 +188,15 @@ void ProcessMaterial(char* read_buffer, Scene* scene) {
   scene->resources->material_count++;
 }
 
+// Usage: assetexporter <output directory> [--optimize]
+// --optimize reorders each mesh for vertex cache and fetch locality
 int main(int argc, char* argv[]) {
+  bool optimize = argc > 2 && strcmp(argv[2], "--optimize") == 0;
+
   // Start empty application
   s64 app_size = rally::Megabytes(128);
-  void* app_mem = malloc(app_size);
   rally::ApplicationCreateInfo app_ci{0};
-  Application* app = CreateApplication(&app_ci, app_mem, app_size);
+  Application* app = CreateApplication(&app_ci, nullptr, app_size);
 
   // Initialize preprocess resources
   // TODO: Import these from assets.txt
@@ -118,14 +220,16 @@ int main(int argc, char* argv[]) {
 
   // Create Scene
   CreateScene(&scene_ci, app);
-  s64 occupied = app->alloc->occupied;
-  s64 data_size = ((char*)app->alloc->data + occupied) - ((char*)app->scene);
 
   // Process: Populate Scene
   fseek(manifest_file, 0, SEEK_SET);
   while (fgets(read_buffer, 256, manifest_file)) {
     if (strncmp(read_buffer, "MODEL", 5) == 0) {
-      ProcessModel(read_buffer, app->scene);
+      if (ProcessModel(read_buffer, app, optimize)) {
+        fclose(manifest_file);
+        DestroyApplication(app);
+        return 1;
+      }
     } else if (strncmp(read_buffer, "MATERIAL", 8) == 0) {
       ProcessMaterial(read_buffer, app->scene);
     } else {
@@ -133,13 +237,19 @@ int main(int argc, char* argv[]) {
     }
   }
   fclose(manifest_file);
+  CompactScene(app, &scene_ci);
+  s64 occupied = app->alloc->occupied;
+  s64 data_size = ((char*)app->alloc->data + occupied) - ((char*)app->scene);
 
   // Make pointers relative: No more modifications after this point!
   rally::Scene* sp = app->scene;
   rally::SceneResources* sr = sp->resources;
   REL_POINT(sr->meshes, sp, Mesh);
-  REL_POINT(sr->vertices, sp, Vertex);
-  REL_POINT(sr->indices, sp, Index);
+  REL_POINT(sr->vertices.positions, sp, Float3);
+  REL_POINT(sr->vertices.normals, sp, OctNormal);
+  REL_POINT(sr->vertices.tangent_frames, sp, TangentFrame);
+  REL_POINT(sr->vertices.uvs, sp, HalfUv);
+  REL_POINT(sr->indices, sp, char);
   REL_POINT(sr->materials, sp, Material);
   REL_POINT(sp->resources, sp, SceneResources);
   REL_POINT(sp->transforms, sp, Mat4);
@@ -163,6 +273,5 @@ int main(int argc, char* argv[]) {
 
   // Cleanup
   DestroyApplication(app);
-  delete app_mem;
   return 0;
 }
\ No newline at end of file